@@ -0,0 +1,321 @@
+#include "calibration.h"
+#include "stats.h"
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+
+#define LOG_TAG "Calibration"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+/**
+ * calibration.cpp - Chessboard collection worker, solve, undistortion maps.
+ *
+ * The board check runs on at most detectWidth pixels of width.
+ * CALIB_CB_FAST_CHECK gives up quickly when no board is in view, and
+ * ADAPTIVE_THRESH | NORMALIZE_IMAGE keep the detection robust under
+ * uneven lighting.
+ *
+ * Corners found on the small image are accurate to roughly one small-image
+ * pixel. They are scaled up and refined with cornerSubPix on the
+ * full-resolution luma. The refinement runs on an ROI around the board, so
+ * the cost tracks the board's area rather than the frame's, and its window
+ * is wide enough to absorb the downscale error but narrower than a square.
+ *
+ * A view is kept only if its corners moved by minViewChange of the frame
+ * width (mean over corners) from every view kept so far. This stops a
+ * board held still from filling the set with near-duplicates.
+ */
+
+static const int MAX_SUBPIX_WINDOW = 11;
+
+static void setError(std::string* error, const std::string& message) {
+    if (error) {
+        *error = message;
+    }
+}
+
+static double meanCornerDistance(const std::vector<cv::Point2f>& a, const std::vector<cv::Point2f>& b) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        sum += cv::norm(a[i] - b[i]);
+    }
+    return sum / a.size();
+}
+
+Calibrator::Calibrator() : worker_([this](const cv::Mat& luma) { process(luma); }) {
+}
+
+Calibrator::~Calibrator() {
+    worker_.stop();
+}
+
+void Calibrator::set(const CalibrationParams& params) {
+    CalibrationParams clamped = params;
+    clamped.boardSize.width = std::max(clamped.boardSize.width, 3);
+    clamped.boardSize.height = std::max(clamped.boardSize.height, 3);
+    clamped.detectWidth = std::max(clamped.detectWidth, 160);
+    clamped.viewsNeeded = std::max(clamped.viewsNeeded, 3);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (clamped == params_ && status_.viewsNeeded != 0) {
+            return;
+        }
+        params_ = clamped;
+    }
+    reset();
+    LOGI("Calibration: %dx%d board, check at %d px, %d views", clamped.boardSize.width,
+         clamped.boardSize.height, clamped.detectWidth, clamped.viewsNeeded);
+}
+
+void Calibrator::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    views_.clear();
+    status_ = CalibrationStatus();
+    status_.viewsNeeded = params_.viewsNeeded;
+    result_.reset();
+}
+
+bool Calibrator::submit(const cv::Mat& luma) {
+    CV_Assert(luma.type() == CV_8UC1);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (status_.state != CALIBRATION_COLLECTING) {
+            return false;
+        }
+    }
+    return worker_.submit(luma);
+}
+
+CalibrationStatus Calibrator::status() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+}
+
+std::shared_ptr<const CameraCalibration> Calibrator::result() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return result_;
+}
+
+void Calibrator::process(const cv::Mat& luma) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const CalibrationParams params = params_;
+    const uint64_t generation = generation_;
+
+    lock.unlock();
+    try {
+        check(luma, params, generation);
+    } catch (const cv::Exception& e) {
+        // Drop the frame; an exception must not escape the worker thread
+        LOGE("Board check failed: %s", e.what());
+        return;
+    }
+    lock.lock();
+
+    if (generation == generation_ && status_.state == CALIBRATION_COLLECTING &&
+        static_cast<int>(views_.size()) >= params.viewsNeeded) {
+        status_.state = CALIBRATION_SOLVING;
+        lock.unlock();
+        solve(params, generation);
+    }
+}
+
+void Calibrator::check(const cv::Mat& luma, const CalibrationParams& params, uint64_t generation) {
+    const auto start = std::chrono::steady_clock::now();
+
+    const double scale = std::min(1.0, static_cast<double>(params.detectWidth) / luma.cols);
+    const cv::Mat* detect = &luma;
+    if (scale < 1.0) {
+        cv::resize(luma, small_, cv::Size(), scale, scale, cv::INTER_AREA);
+        detect = &small_;
+    }
+
+    std::vector<cv::Point2f> corners;
+    const bool found = cv::findChessboardCorners(
+            *detect, params.boardSize, corners,
+            cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE | cv::CALIB_CB_FAST_CHECK);
+
+    if (found) {
+        for (cv::Point2f& p : corners) {
+            p *= static_cast<float>(1.0 / scale);
+        }
+
+        // Window: covers the downscale error, stays inside one square
+        float square = FLT_MAX;
+        for (int y = 0; y < params.boardSize.height; ++y) {
+            for (int x = 1; x < params.boardSize.width; ++x) {
+                const int i = y * params.boardSize.width + x;
+                square = std::min(square, static_cast<float>(cv::norm(corners[i] - corners[i - 1])));
+            }
+        }
+        const int window = std::max(2, std::min({MAX_SUBPIX_WINDOW, cvCeil(2.0 / scale) + 1,
+                                                 cvFloor(square * 0.4f)}));
+
+        const cv::Rect roi = (cv::boundingRect(corners) + cv::Size(4 * window, 4 * window) -
+                              cv::Point(2 * window, 2 * window)) & cv::Rect(0, 0, luma.cols, luma.rows);
+        const cv::Point2f offset(static_cast<float>(roi.x), static_cast<float>(roi.y));
+        for (cv::Point2f& p : corners) {
+            p -= offset;
+        }
+        cv::cornerSubPix(luma(roi), corners, cv::Size(window, window), cv::Size(-1, -1),
+                         cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 30, 0.01));
+        for (cv::Point2f& p : corners) {
+            p += offset;
+        }
+    }
+
+    statsRecord(STAT_CALIB_CHECK, std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation != generation_) {
+        return;
+    }
+    ++status_.checkedFrames;
+    status_.boardFound = found;
+    status_.corners = corners;
+    status_.frameSize = luma.size();
+    if (!found || status_.state != CALIBRATION_COLLECTING) {
+        return;
+    }
+
+    const double minChange = params.minViewChange * luma.cols;
+    for (const std::vector<cv::Point2f>& view : views_) {
+        if (meanCornerDistance(view, corners) < minChange) {
+            return;
+        }
+    }
+    views_.push_back(std::move(corners));
+    status_.views = static_cast<int>(views_.size());
+    LOGI("Calibration view %d/%d (check %.1f ms avg)", status_.views, params.viewsNeeded,
+         statsAverageMs(STAT_CALIB_CHECK));
+}
+
+void Calibrator::solve(const CalibrationParams& params, uint64_t generation) {
+    std::vector<std::vector<cv::Point2f>> views;
+    cv::Size frameSize;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        views = views_;
+        frameSize = status_.frameSize;
+    }
+
+    std::vector<cv::Point3f> board;
+    for (int y = 0; y < params.boardSize.height; ++y) {
+        for (int x = 0; x < params.boardSize.width; ++x) {
+            board.emplace_back(x * params.squareSize, y * params.squareSize, 0.0f);
+        }
+    }
+    const std::vector<std::vector<cv::Point3f>> objectPoints(views.size(), board);
+
+    const auto start = std::chrono::steady_clock::now();
+    auto calibration = std::make_shared<CameraCalibration>();
+    calibration->imageSize = frameSize;
+    calibration->views = static_cast<int>(views.size());
+    bool solved = false;
+    try {
+        std::vector<cv::Mat> rvecs, tvecs;
+        calibration->rms = cv::calibrateCamera(objectPoints, views, frameSize,
+                                               calibration->cameraMatrix, calibration->distCoeffs,
+                                               rvecs, tvecs);
+        solved = cv::checkRange(calibration->cameraMatrix) && cv::checkRange(calibration->distCoeffs);
+    } catch (const cv::Exception& e) {
+        LOGE("calibrateCamera failed: %s", e.what());
+    }
+    const double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation != generation_) {
+        return;
+    }
+    if (!solved) {
+        // Start over rather than keep views that produced no solution
+        views_.clear();
+        status_.views = 0;
+        status_.state = CALIBRATION_COLLECTING;
+        return;
+    }
+    const cv::Mat& k = calibration->cameraMatrix;
+    LOGI("Calibrated %dx%d from %d views in %.0f ms: fx %.1f fy %.1f cx %.1f cy %.1f, RMS %.3f px",
+         frameSize.width, frameSize.height, calibration->views, ms, k.at<double>(0, 0),
+         k.at<double>(1, 1), k.at<double>(0, 2), k.at<double>(1, 2), calibration->rms);
+    status_.rms = calibration->rms;
+    status_.state = CALIBRATION_DONE;
+    result_ = std::move(calibration);
+}
+
+bool saveCalibration(const CameraCalibration& calibration, const std::string& path, std::string* error) {
+    try {
+        cv::FileStorage fs(path, cv::FileStorage::WRITE);
+        if (!fs.isOpened()) {
+            setError(error, "cannot open " + path);
+            return false;
+        }
+        fs << "image_width" << calibration.imageSize.width;
+        fs << "image_height" << calibration.imageSize.height;
+        fs << "camera_matrix" << calibration.cameraMatrix;
+        fs << "distortion_coefficients" << calibration.distCoeffs;
+        fs << "rms" << calibration.rms;
+        fs << "views" << calibration.views;
+    } catch (const cv::Exception& e) {
+        setError(error, e.what());
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<CameraCalibration> loadCalibration(const std::string& path, std::string* error) {
+    auto calibration = std::make_shared<CameraCalibration>();
+    try {
+        cv::FileStorage fs(path, cv::FileStorage::READ);
+        if (!fs.isOpened()) {
+            setError(error, "cannot open " + path);
+            return nullptr;
+        }
+        fs["image_width"] >> calibration->imageSize.width;
+        fs["image_height"] >> calibration->imageSize.height;
+        fs["camera_matrix"] >> calibration->cameraMatrix;
+        fs["distortion_coefficients"] >> calibration->distCoeffs;
+        fs["rms"] >> calibration->rms;
+        fs["views"] >> calibration->views;
+    } catch (const cv::Exception& e) {
+        setError(error, e.what());
+        return nullptr;
+    }
+    if (calibration->imageSize.area() <= 0 || calibration->cameraMatrix.size() != cv::Size(3, 3) ||
+        calibration->distCoeffs.empty()) {
+        setError(error, "incomplete calibration in " + path);
+        return nullptr;
+    }
+    calibration->cameraMatrix.convertTo(calibration->cameraMatrix, CV_64F);
+    calibration->distCoeffs.convertTo(calibration->distCoeffs, CV_64F);
+    return calibration;
+}
+
+void Undistorter::set(std::shared_ptr<const CameraCalibration> calibration) {
+    if (calibration != calibration_) {
+        calibration_ = std::move(calibration);
+        mapSize_ = cv::Size();
+    }
+}
+
+void Undistorter::apply(const cv::Mat& src, cv::Mat& dst) {
+    CV_Assert(calibration_ && src.data != dst.data);
+    if (src.size() != mapSize_) {
+        // Intrinsics scale with the image (same aspect ratio assumed)
+        cv::Mat k = calibration_->cameraMatrix.clone();
+        k.row(0) *= static_cast<double>(src.cols) / calibration_->imageSize.width;
+        k.row(1) *= static_cast<double>(src.rows) / calibration_->imageSize.height;
+        const cv::Mat newK = cv::getOptimalNewCameraMatrix(k, calibration_->distCoeffs, src.size(), 0.0);
+        cv::initUndistortRectifyMap(k, calibration_->distCoeffs, cv::noArray(), newK, src.size(),
+                                    CV_16SC2, map1_, map2_);
+        mapSize_ = src.size();
+        LOGI("Undistortion maps: %dx%d", mapSize_.width, mapSize_.height);
+    }
+    cv::remap(src, dst, map1_, map2_, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+}
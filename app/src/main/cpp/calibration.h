@@ -0,0 +1,138 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "frame_worker.h"
+
+/**
+ * In-app camera calibration from chessboard views, plus the undistortion
+ * stage that uses the result. Implementation is in calibration.cpp.
+ *
+ * The frame thread only hands luma frames to Calibrator::submit(), which
+ * copies one when the worker (a FrameWorker) is idle and drops it
+ * otherwise. The worker thread runs the slow parts:
+ * - findChessboardCorners with CALIB_CB_FAST_CHECK on a downscaled copy,
+ *   which rejects frames without a board in a few milliseconds
+ * - cornerSubPix at full resolution, but only for accepted frames and only
+ *   inside the board's bounding box
+ * - calibrateCamera, once enough distinct views are collected
+ */
+struct CalibrationParams {
+    cv::Size boardSize{9, 6};       // Inner corners per row and column
+    float squareSize = 1.0f;        // Square edge, in the unit wanted for extrinsics
+    int detectWidth = 640;          // Luma width for the fast board check
+    int viewsNeeded = 15;           // Views collected before calibrating
+    float minViewChange = 0.05f;    // Mean corner motion (fraction of width) between views
+
+    bool operator==(const CalibrationParams& o) const {
+        return boardSize == o.boardSize && squareSize == o.squareSize &&
+               detectWidth == o.detectWidth && viewsNeeded == o.viewsNeeded &&
+               minViewChange == o.minViewChange;
+    }
+};
+
+/** Intrinsics for frames of imageSize; scaled for other sizes of the same aspect. */
+struct CameraCalibration {
+    cv::Size imageSize;
+    cv::Mat cameraMatrix;           // 3x3 CV_64F
+    cv::Mat distCoeffs;             // 1xN CV_64F
+    double rms = 0.0;               // Reprojection error, pixels
+    int views = 0;
+};
+
+/** OpenCV FileStorage (YAML/XML/JSON by extension). */
+bool saveCalibration(const CameraCalibration& calibration, const std::string& path,
+                     std::string* error = nullptr);
+std::shared_ptr<CameraCalibration> loadCalibration(const std::string& path,
+                                                   std::string* error = nullptr);
+
+enum CalibrationState {
+    CALIBRATION_COLLECTING = 0,
+    CALIBRATION_SOLVING,            // calibrateCamera running
+    CALIBRATION_DONE
+};
+
+/** Snapshot of the worker's progress, for overlays. */
+struct CalibrationStatus {
+    CalibrationState state = CALIBRATION_COLLECTING;
+    int views = 0;
+    int viewsNeeded = 0;
+    uint64_t checkedFrames = 0;             // Frames checked since the last reset
+    bool boardFound = false;                // In the most recently checked frame
+    std::vector<cv::Point2f> corners;       // Its corners, full-resolution luma pixels
+    cv::Size frameSize;                     // Size of that luma
+    double rms = 0.0;
+};
+
+class Calibrator {
+public:
+    Calibrator();
+    ~Calibrator();
+    Calibrator(const Calibrator&) = delete;
+    Calibrator& operator=(const Calibrator&) = delete;
+
+    /** A change of parameters discards collected views. */
+    void set(const CalibrationParams& params);
+
+    /** Discard views and any result; the worker keeps running. */
+    void reset();
+
+    /**
+     * Offer a full-resolution CV_8UC1 luma frame. Copies it and wakes the
+     * worker if the worker is idle; returns false (frame skipped) if not.
+     */
+    bool submit(const cv::Mat& luma);
+
+    CalibrationStatus status() const;
+
+    /** Latest calibration, or nullptr until one has been solved. */
+    std::shared_ptr<const CameraCalibration> result() const;
+
+private:
+    void process(const cv::Mat& luma);
+    void check(const cv::Mat& luma, const CalibrationParams& params, uint64_t generation);
+    void solve(const CalibrationParams& params, uint64_t generation);
+
+    mutable std::mutex mutex_;
+    uint64_t generation_ = 0;       // Bumped by reset(); stale work is discarded
+
+    CalibrationParams params_;
+
+    std::vector<std::vector<cv::Point2f>> views_;
+    CalibrationStatus status_;
+    std::shared_ptr<const CameraCalibration> result_;
+
+    // Worker-only scratch
+    cv::Mat small_;
+
+    // Last, so it starts after and stops before the state it works on
+    FrameWorker worker_;
+};
+
+/**
+ * Undistortion stage: remap with fixed-point maps built once per frame size
+ * from a CameraCalibration. Maps use the optimal new camera matrix with
+ * alpha = 0, so the output has no invalid border.
+ */
+class Undistorter {
+public:
+    /** nullptr turns the stage off. Maps are rebuilt lazily. */
+    void set(std::shared_ptr<const CameraCalibration> calibration);
+    bool enabled() const { return calibration_ != nullptr; }
+
+    /** Undistort src (any type remap supports) into dst; dst must not alias src. */
+    void apply(const cv::Mat& src, cv::Mat& dst);
+
+private:
+    std::shared_ptr<const CameraCalibration> calibration_;
+    cv::Size mapSize_;
+    cv::Mat map1_;                  // CV_16SC2
+    cv::Mat map2_;                  // CV_16UC1 interpolation table indices
+};
+
+#endif // CALIBRATION_H
@@ -0,0 +1,113 @@
+#include "chroma_effects.h"
+#include <opencv2/core.hpp>
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#define LOG_TAG "ChromaEffects"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+/**
+ * chroma_effects.cpp - NV21 color adjustment tables.
+ *
+ * Saturation, hue and tint are one affine map of the (U, V) vector:
+ *   [U' V'] = saturation * R(hue) * [U-128 V-128] + 128 + tint
+ * Precomputing it for all 65536 byte pairs turns the whole chroma plane
+ * into a single 16-bit gather per sample. Y gets an ordinary 8-bit LUT.
+ */
+
+static inline uint8_t clampToByte(float v) {
+    return static_cast<uint8_t>(v < 0.0f ? 0 : (v > 255.0f ? 255 : static_cast<int>(v + 0.5f)));
+}
+
+void ChromaEffects::set(const ColorAdjust& adjust) {
+    if (adjust == adjust_ && !chromaLut_.empty()) {
+        return;
+    }
+    adjust_ = adjust;
+    rebuildTables();
+}
+
+void ChromaEffects::rebuildTables() {
+    // Luma: contrast around mid-gray, then brightness, then gamma (video range)
+    lumaIdentity_ = adjust_.contrast == 1.0f && adjust_.brightness == 0.0f && adjust_.gamma == 1.0f;
+    for (int y = 0; y < 256; ++y) {
+        float v = (y - 128) * adjust_.contrast + 128 + adjust_.brightness;
+        if (adjust_.gamma != 1.0f) {
+            const float normalized = std::min(std::max((v - 16.0f) / 219.0f, 0.0f), 1.0f);
+            v = 16.0f + 219.0f * std::pow(normalized, adjust_.gamma);
+        }
+        lumaLut_[y] = clampToByte(v);
+    }
+
+    chromaIdentity_ = adjust_.saturation == 1.0f && adjust_.hueShiftDeg == 0.0f &&
+                      adjust_.tintU == 0 && adjust_.tintV == 0;
+    const float radians = adjust_.hueShiftDeg * static_cast<float>(CV_PI) / 180.0f;
+    const float cosH = std::cos(radians) * adjust_.saturation;
+    const float sinH = std::sin(radians) * adjust_.saturation;
+
+    chromaLut_.resize(65536);
+    for (int v = 0; v < 256; ++v) {
+        for (int u = 0; u < 256; ++u) {
+            const float fu = u - 128.0f;
+            const float fv = v - 128.0f;
+            const uint8_t outU = clampToByte(cosH * fu - sinH * fv + 128.0f + adjust_.tintU);
+            const uint8_t outV = clampToByte(sinH * fu + cosH * fv + 128.0f + adjust_.tintV);
+
+            // NV21 stores V then U; index and store the pair in memory order
+            uint8_t in[2] = {static_cast<uint8_t>(v), static_cast<uint8_t>(u)};
+            uint8_t out[2] = {outV, outU};
+            uint16_t key;
+            uint16_t value;
+            std::memcpy(&key, in, 2);
+            std::memcpy(&value, out, 2);
+            chromaLut_[key] = value;
+        }
+    }
+
+    LOGI("Color adjust: sat %.2f hue %.1f tint %d/%d, Y contrast %.2f brightness %.1f gamma %.2f",
+         adjust_.saturation, adjust_.hueShiftDeg, adjust_.tintU, adjust_.tintV,
+         adjust_.contrast, adjust_.brightness, adjust_.gamma);
+}
+
+void ChromaEffects::apply(const uint8_t* nv21In, uint8_t* nv21Out, int width, int height) const {
+    const size_t lumaSize = static_cast<size_t>(width) * height;
+
+    if (lumaIdentity_) {
+        if (nv21In != nv21Out) {
+            std::memcpy(nv21Out, nv21In, lumaSize);
+        }
+    } else {
+        // cv::LUT is vectorized and parallel
+        const cv::Mat lut(1, 256, CV_8UC1, const_cast<uint8_t*>(lumaLut_));
+        const cv::Mat src(height, width, CV_8UC1, const_cast<uint8_t*>(nv21In));
+        cv::Mat dst(height, width, CV_8UC1, nv21Out);
+        cv::LUT(src, lut, dst);
+    }
+
+    const size_t chromaPairs = lumaSize / 4;
+    if (chromaIdentity_) {
+        if (nv21In != nv21Out) {
+            std::memcpy(nv21Out + lumaSize, nv21In + lumaSize, chromaPairs * 2);
+        }
+        return;
+    }
+
+    const uint16_t* table = chromaLut_.data();
+    const uint8_t* srcVu = nv21In + lumaSize;
+    uint8_t* dstVu = nv21Out + lumaSize;
+    const int rows = height / 2;
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int r = range.start; r < range.end; ++r) {
+            const uint8_t* src = srcVu + static_cast<size_t>(r) * width;
+            uint8_t* dst = dstVu + static_cast<size_t>(r) * width;
+            for (int i = 0; i < width; i += 2) {
+                uint16_t pair;
+                std::memcpy(&pair, src + i, 2);
+                pair = table[pair];
+                std::memcpy(dst + i, &pair, 2);
+            }
+        }
+    });
+}
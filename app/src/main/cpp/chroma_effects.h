@@ -0,0 +1,61 @@
+#ifndef CHROMA_EFFECTS_H
+#define CHROMA_EFFECTS_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Color adjustments applied to NV21 before RGBA conversion.
+ * Implementation is in chroma_effects.cpp.
+ *
+ * Saturation, hue shift and tint only touch the interleaved VU plane
+ * (width*height/2 bytes); brightness/contrast/gamma are a 256-entry LUT on
+ * Y. Compared with doing the same math on RGBA (4 bytes per pixel) this is
+ * roughly a quarter of the memory traffic, and every effect is a table
+ * lookup whatever the combination.
+ */
+struct ColorAdjust {
+    float saturation = 1.0f;    // 0 = grayscale, 1 = unchanged, >1 = more vivid
+    float hueShiftDeg = 0.0f;   // Rotation of the UV vector (approximates an HSV hue shift)
+    int tintU = 0;              // Added to U (blue-yellow axis), -128..127
+    int tintV = 0;              // Added to V (red-cyan axis), -128..127
+    float brightness = 0.0f;    // Added to Y after contrast, in Y units
+    float contrast = 1.0f;      // Y scale around mid-gray
+    float gamma = 1.0f;         // Y transfer exponent (>1 darkens mid-tones)
+
+    bool operator==(const ColorAdjust& o) const {
+        return saturation == o.saturation && hueShiftDeg == o.hueShiftDeg &&
+               tintU == o.tintU && tintV == o.tintV && brightness == o.brightness &&
+               contrast == o.contrast && gamma == o.gamma;
+    }
+};
+
+class ChromaEffects {
+public:
+    /** Tables are rebuilt only when the adjustment actually changes. */
+    void set(const ColorAdjust& adjust);
+    const ColorAdjust& adjust() const { return adjust_; }
+
+    /** True when apply() would change nothing (callers can skip it). */
+    bool isIdentity() const { return lumaIdentity_ && chromaIdentity_; }
+
+    /**
+     * Write the adjusted frame to nv21Out (same size as the input).
+     * An untouched plane is copied; nv21In == nv21Out works in place.
+     */
+    void apply(const uint8_t* nv21In, uint8_t* nv21Out, int width, int height) const;
+
+private:
+    void rebuildTables();
+
+    ColorAdjust adjust_;
+    bool lumaIdentity_ = true;
+    bool chromaIdentity_ = true;
+
+    uint8_t lumaLut_[256] = {};
+
+    // Indexed by the raw (V, U) byte pair as it sits in memory; 128 KB
+    std::vector<uint16_t> chromaLut_;
+};
+
+#endif // CHROMA_EFFECTS_H
@@ -0,0 +1,275 @@
+#include "color_lut.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#define LOG_TAG "ColorLut"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+/**
+ * color_lut.cpp - .cube parsing and CPU tetrahedral interpolation.
+ *
+ * Each input byte maps to a cell index and an 8-bit fraction along its
+ * axis. Sorting the three fractions picks one of the six tetrahedra of the
+ * cell; the result is a weighted sum of four corners:
+ *   out = (256 - f1) * c0 + (f1 - f2) * c1 + (f2 - f3) * c2 + f3 * c3
+ * where f1 >= f2 >= f3 and each corner steps one axis further from c0.
+ * Entries are {r, g, b, a} int16, so one 128-bit multiply-accumulate per
+ * corner handles all channels; four pixels are narrowed and stored together.
+ */
+
+// Table entries are the [0, 1] value times 128 * 255; weights sum to 256
+static const int ENTRY_SCALE = 128 * 255;
+static const int RESULT_SHIFT = 15;
+
+static void setError(std::string* error, const std::string& message) {
+    if (error) {
+        *error = message;
+    }
+}
+
+std::shared_ptr<const ColorLut3D> makeColorLut(int size, const std::vector<float>& rgb,
+                                               const std::string& title) {
+    if (size < ColorLut3D::MIN_SIZE || size > ColorLut3D::MAX_SIZE ||
+        rgb.size() != static_cast<size_t>(size) * size * size * 3) {
+        return nullptr;
+    }
+
+    auto lut = std::make_shared<ColorLut3D>();
+    lut->title = title;
+    lut->size = size;
+
+    const size_t entries = static_cast<size_t>(size) * size * size;
+    lut->table.resize(entries * 4);
+    lut->texture.resize(entries * 4);
+    for (size_t i = 0; i < entries; ++i) {
+        // Data order is r fastest, then g, then b
+        const int r = static_cast<int>(i % size);
+        const int g = static_cast<int>((i / size) % size);
+        const int b = static_cast<int>(i / (static_cast<size_t>(size) * size));
+        uint8_t* texel = &lut->texture[(static_cast<size_t>(g) * size * size + b * size + r) * 4];
+
+        for (int c = 0; c < 3; ++c) {
+            const float v = std::min(std::max(rgb[i * 3 + c], 0.0f), 1.0f);
+            lut->table[i * 4 + c] = static_cast<int16_t>(std::lround(v * ENTRY_SCALE));
+            texel[c] = static_cast<uint8_t>(std::lround(v * 255.0f));
+        }
+        lut->table[i * 4 + 3] = ENTRY_SCALE;
+        texel[3] = 255;
+    }
+    return lut;
+}
+
+std::shared_ptr<const ColorLut3D> loadCubeLut(const std::string& path, std::string* error) {
+    const auto start = std::chrono::steady_clock::now();
+
+    std::ifstream file(path);
+    if (!file) {
+        setError(error, "cannot open " + path);
+        return nullptr;
+    }
+
+    std::string title;
+    int size = 0;
+    std::vector<float> rgb;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        const char* p = line.c_str();
+        while (*p == ' ' || *p == '\t') {
+            ++p;
+        }
+        if (*p == '\0' || *p == '#' || *p == '\r') {
+            continue;
+        }
+
+        // Data lines are the common case; try them first
+        if ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.') {
+            if (size == 0) {
+                setError(error, "data before LUT_3D_SIZE at line " + std::to_string(lineNumber));
+                return nullptr;
+            }
+            char* end = nullptr;
+            for (int c = 0; c < 3; ++c) {
+                const float v = std::strtof(p, &end);
+                if (end == p) {
+                    setError(error, "bad data at line " + std::to_string(lineNumber));
+                    return nullptr;
+                }
+                rgb.push_back(v);
+                p = end;
+            }
+            continue;
+        }
+
+        if (std::strncmp(p, "TITLE", 5) == 0) {
+            const char* open = std::strchr(p, '"');
+            const char* close = open ? std::strrchr(open + 1, '"') : nullptr;
+            if (open && close) {
+                title.assign(open + 1, close);
+            }
+        } else if (std::strncmp(p, "LUT_3D_SIZE", 11) == 0) {
+            size = std::atoi(p + 11);
+            if (size < ColorLut3D::MIN_SIZE || size > ColorLut3D::MAX_SIZE) {
+                setError(error, "unsupported LUT_3D_SIZE " + std::to_string(size));
+                return nullptr;
+            }
+            rgb.reserve(static_cast<size_t>(size) * size * size * 3);
+        } else if (std::strncmp(p, "LUT_1D_SIZE", 11) == 0) {
+            setError(error, "1D LUTs are not supported");
+            return nullptr;
+        } else if (std::strncmp(p, "DOMAIN_MIN", 10) == 0 ||
+                   std::strncmp(p, "DOMAIN_MAX", 10) == 0) {
+            // Camera frames cover [0, 1]; other input domains would need a prescale
+            const float expected = p[8] == 'A' ? 1.0f : 0.0f;
+            const char* q = p + 10;
+            char* end = nullptr;
+            for (int c = 0; c < 3; ++c) {
+                const float v = std::strtof(q, &end);
+                if (end == q || v != expected) {
+                    setError(error, "only the [0, 1] input domain is supported");
+                    return nullptr;
+                }
+                q = end;
+            }
+        }
+        // Other keywords (LUT_3D_INPUT_RANGE, vendor extensions) are ignored
+    }
+
+    if (size == 0) {
+        setError(error, "missing LUT_3D_SIZE");
+        return nullptr;
+    }
+    const size_t expected = static_cast<size_t>(size) * size * size * 3;
+    if (rgb.size() != expected) {
+        setError(error, "expected " + std::to_string(expected / 3) + " entries, found " +
+                        std::to_string(rgb.size() / 3));
+        return nullptr;
+    }
+
+    auto lut = makeColorLut(size, rgb, title);
+    const double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+    LOGI("Loaded LUT '%s': %d^3 from %s in %.1f ms", title.c_str(), size, path.c_str(), ms);
+    return lut;
+}
+
+/** Cell index and fraction for one axis value */
+struct AxisStep {
+    int cell;
+    int frac;       // 0..256
+};
+
+struct CornerWeights {
+    int base;
+    int step1, step2, step3;    // Offsets from one corner to the next
+    int w0, w1, w2, w3;
+};
+
+static inline void sortAxes(int& f1, int& s1, int& f2, int& s2, int& f3, int& s3) {
+    if (f1 < f2) { std::swap(f1, f2); std::swap(s1, s2); }
+    if (f2 < f3) { std::swap(f2, f3); std::swap(s2, s3); }
+    if (f1 < f2) { std::swap(f1, f2); std::swap(s1, s2); }
+}
+
+static inline CornerWeights cornerWeights(const AxisStep* axes, int strideG, int strideB,
+                                          const uint8_t* px) {
+    const AxisStep& r = axes[px[0]];
+    const AxisStep& g = axes[px[1]];
+    const AxisStep& b = axes[px[2]];
+
+    int f1 = r.frac, s1 = 4;
+    int f2 = g.frac, s2 = strideG;
+    int f3 = b.frac, s3 = strideB;
+    sortAxes(f1, s1, f2, s2, f3, s3);
+
+    CornerWeights w;
+    w.base = r.cell * 4 + g.cell * strideG + b.cell * strideB;
+    w.step1 = s1;
+    w.step2 = s2;
+    w.step3 = s3;
+    w.w0 = 256 - f1;
+    w.w1 = f1 - f2;
+    w.w2 = f2 - f3;
+    w.w3 = f3;
+    return w;
+}
+
+#if CV_SIMD128
+static inline cv::v_int32x4 blendCorners(const int16_t* table, const CornerWeights& w) {
+    const int16_t* c0 = table + w.base;
+    const int16_t* c1 = c0 + w.step1;
+    const int16_t* c2 = c1 + w.step2;
+    const int16_t* c3 = c2 + w.step3;
+    cv::v_int32x4 acc = cv::v_mul(cv::v_load_expand(c0), cv::v_setall_s32(w.w0));
+    acc = cv::v_muladd(cv::v_load_expand(c1), cv::v_setall_s32(w.w1), acc);
+    acc = cv::v_muladd(cv::v_load_expand(c2), cv::v_setall_s32(w.w2), acc);
+    return cv::v_muladd(cv::v_load_expand(c3), cv::v_setall_s32(w.w3), acc);
+}
+#endif
+
+static inline void blendCornersScalar(const int16_t* table, const CornerWeights& w, uint8_t* out) {
+    const int16_t* c0 = table + w.base;
+    const int16_t* c1 = c0 + w.step1;
+    const int16_t* c2 = c1 + w.step2;
+    const int16_t* c3 = c2 + w.step3;
+    for (int c = 0; c < 4; ++c) {
+        const int v = (c0[c] * w.w0 + c1[c] * w.w1 + c2[c] * w.w2 + c3[c] * w.w3 +
+                       (1 << (RESULT_SHIFT - 1))) >> RESULT_SHIFT;
+        out[c] = static_cast<uint8_t>(std::min(std::max(v, 0), 255));
+    }
+}
+
+void applyColorLut(const ColorLut3D& lut, cv::Mat& rgba) {
+    CV_Assert(rgba.type() == CV_8UC4);
+    const int n = lut.size;
+    const int strideG = 4 * n;
+    const int strideB = 4 * n * n;
+
+    // Value -> (cell, fraction) in 8.8 fixed point; the top value lands at
+    // fraction 256 of the last cell so corner reads stay in the table
+    AxisStep axes[256];
+    for (int v = 0; v < 256; ++v) {
+        const int pos = (v * (n - 1) * 256 + 127) / 255;
+        int cell = pos >> 8;
+        int frac = pos & 255;
+        if (cell >= n - 1) {
+            cell = n - 2;
+            frac = 256;
+        }
+        axes[v] = {cell, frac};
+    }
+
+    const int16_t* table = lut.table.data();
+    cv::parallel_for_(cv::Range(0, rgba.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; ++y) {
+            uint8_t* row = rgba.ptr<uint8_t>(y);
+            int x = 0;
+#if CV_SIMD128
+            for (; x <= rgba.cols - 4; x += 4) {
+                uint8_t* px = row + x * 4;
+                // All four pixels are read before the store overwrites them
+                const CornerWeights w0 = cornerWeights(axes, strideG, strideB, px);
+                const CornerWeights w1 = cornerWeights(axes, strideG, strideB, px + 4);
+                const CornerWeights w2 = cornerWeights(axes, strideG, strideB, px + 8);
+                const CornerWeights w3 = cornerWeights(axes, strideG, strideB, px + 12);
+                const cv::v_int16x8 lo = cv::v_rshr_pack<RESULT_SHIFT>(blendCorners(table, w0),
+                                                                       blendCorners(table, w1));
+                const cv::v_int16x8 hi = cv::v_rshr_pack<RESULT_SHIFT>(blendCorners(table, w2),
+                                                                       blendCorners(table, w3));
+                cv::v_store(px, cv::v_pack_u(lo, hi));
+            }
+#endif
+            for (; x < rgba.cols; ++x) {
+                uint8_t* px = row + x * 4;
+                blendCornersScalar(table, cornerWeights(axes, strideG, strideB, px), px);
+            }
+        }
+    });
+}
@@ -0,0 +1,59 @@
+#ifndef COLOR_LUT_H
+#define COLOR_LUT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * 3D color lookup table for film-style grading.
+ * Implementation is in color_lut.cpp.
+ *
+ * A .cube file is parsed once into two ready-to-use forms, so switching
+ * grades never costs more than a pointer swap (plus one small texture
+ * upload on the GPU path):
+ * - table: fixed-point entries for the CPU tetrahedral interpolator
+ * - texture: the cube packed as a 2D RGBA8 image (N*N x N, blue slices side
+ *   by side) because GLES2 has no 3D textures; the fragment shader blends
+ *   two bilinear slice samples
+ * A loaded LUT is immutable and shared between threads by shared_ptr.
+ */
+struct ColorLut3D {
+    static constexpr int MIN_SIZE = 2;
+    static constexpr int MAX_SIZE = 65;
+
+    std::string title;
+    int size = 0;                   // Entries per axis (N)
+
+    // N^3 entries of {r, g, b, 255} scaled by 128, red fastest, then green, then blue
+    std::vector<int16_t> table;
+
+    // N*N x N RGBA8; texel (r + b*N, g) is entry (r, g, b)
+    std::vector<uint8_t> texture;
+
+    int textureWidth() const { return size * size; }
+    int textureHeight() const { return size; }
+};
+
+/**
+ * Build a LUT from N^3 RGB triples in [0, 1], red index fastest
+ * (the .cube data order). Returns nullptr on a size mismatch.
+ */
+std::shared_ptr<const ColorLut3D> makeColorLut(int size, const std::vector<float>& rgb,
+                                               const std::string& title = std::string());
+
+/**
+ * Parse a .cube file (LUT_3D_SIZE, optional TITLE / DOMAIN_MIN / DOMAIN_MAX).
+ * Returns nullptr and fills *error on failure. 1D LUTs are rejected.
+ */
+std::shared_ptr<const ColorLut3D> loadCubeLut(const std::string& path, std::string* error = nullptr);
+
+/**
+ * Grade an RGBA (CV_8UC4) image in place with tetrahedral interpolation.
+ * Alpha is written as 255 (camera frames are opaque).
+ */
+void applyColorLut(const ColorLut3D& lut, cv::Mat& rgba);
+
+#endif // COLOR_LUT_H
@@ -0,0 +1,130 @@
+#include "color_mask.h"
+#include <opencv2/imgproc.hpp>
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+
+#define LOG_TAG "ColorMask"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+/**
+ * color_mask.cpp - YUV lookup-table color classification.
+ *
+ * Y, U and V are quantized to 64 levels (6 bits). The table is indexed by
+ * (V, U) and holds a 64-bit word whose bits are the Y levels that fall in
+ * the HSV range, so classifying a sample is one load, one shift and one AND.
+ *
+ * The table is built by converting the center of every (Y, U, V) bin with
+ * the same BT.601 video-range formula the camera path uses, then running
+ * those 262144 colors through cv::cvtColor(RGB2HSV) and cv::inRange. The
+ * HSV definition is therefore exactly OpenCV's; differences from the full
+ * pipeline come only from quantization and from classifying per 2x2 block.
+ */
+
+static const int BIN_BITS = 6;
+static const int BINS = 1 << BIN_BITS;
+static const int BIN_SHIFT = 8 - BIN_BITS;
+
+void ColorMask::setRange(const HsvRange& range) {
+    if (!(range == range_)) {
+        range_ = range;
+        dirty_ = true;
+    }
+}
+
+void ColorMask::rebuildTable() {
+    const auto start = std::chrono::steady_clock::now();
+
+    // Bin centers -> RGB, one row per (V, U) pair, one column per Y level
+    cv::Mat rgb(BINS * BINS, BINS, CV_8UC3);
+    for (int v = 0; v < BINS; ++v) {
+        for (int u = 0; u < BINS; ++u) {
+            cv::Vec3b* row = rgb.ptr<cv::Vec3b>(v * BINS + u);
+            const float vf = ((v << BIN_SHIFT) + (1 << (BIN_SHIFT - 1))) - 128.0f;
+            const float uf = ((u << BIN_SHIFT) + (1 << (BIN_SHIFT - 1))) - 128.0f;
+            for (int y = 0; y < BINS; ++y) {
+                const float yf = 1.164f * std::max(0, (y << BIN_SHIFT) + (1 << (BIN_SHIFT - 1)) - 16);
+                row[y] = cv::Vec3b(cv::saturate_cast<uint8_t>(yf + 1.596f * vf),
+                                   cv::saturate_cast<uint8_t>(yf - 0.813f * vf - 0.391f * uf),
+                                   cv::saturate_cast<uint8_t>(yf + 2.018f * uf));
+            }
+        }
+    }
+
+    cv::Mat hsv;
+    cv::cvtColor(rgb, hsv, cv::COLOR_RGB2HSV);
+
+    cv::Mat inside;
+    if (range_.hueMin <= range_.hueMax) {
+        cv::inRange(hsv, cv::Scalar(range_.hueMin, range_.satMin, range_.valMin),
+                    cv::Scalar(range_.hueMax, range_.satMax, range_.valMax), inside);
+    } else {
+        // Wrapping hue range: [hueMin, 179] or [0, hueMax]
+        cv::Mat high;
+        cv::inRange(hsv, cv::Scalar(range_.hueMin, range_.satMin, range_.valMin),
+                    cv::Scalar(179, range_.satMax, range_.valMax), inside);
+        cv::inRange(hsv, cv::Scalar(0, range_.satMin, range_.valMin),
+                    cv::Scalar(range_.hueMax, range_.satMax, range_.valMax), high);
+        cv::bitwise_or(inside, high, inside);
+    }
+
+    table_.assign(BINS * BINS, 0);
+    int selected = 0;
+    for (int i = 0; i < BINS * BINS; ++i) {
+        const uint8_t* row = inside.ptr<uint8_t>(i);
+        uint64_t bits = 0;
+        for (int y = 0; y < BINS; ++y) {
+            if (row[y] != 0) {
+                bits |= uint64_t(1) << y;
+                selected++;
+            }
+        }
+        table_[i] = bits;
+    }
+    dirty_ = false;
+
+    LOGI("Color table rebuilt: H %d-%d S %d-%d V %d-%d, %d/%d bins selected (%.2f ms)",
+         range_.hueMin, range_.hueMax, range_.satMin, range_.satMax, range_.valMin, range_.valMax,
+         selected, BINS * BINS * BINS,
+         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+void ColorMask::compute(const uint8_t* nv21Data, int width, int height, cv::Mat& maskOut) {
+    if (dirty_) {
+        rebuildTable();
+    }
+
+    const int chromaWidth = width / 2;
+    const int chromaHeight = height / 2;
+    maskOut.create(chromaHeight, chromaWidth, CV_8UC1);
+
+    const uint64_t* table = table_.data();
+    const uint8_t* vuPlane = nv21Data + static_cast<size_t>(width) * height;
+
+    cv::parallel_for_(cv::Range(0, chromaHeight), [&](const cv::Range& range) {
+        for (int cy = range.start; cy < range.end; ++cy) {
+            const uint8_t* y0 = nv21Data + static_cast<size_t>(2 * cy) * width;
+            const uint8_t* y1 = y0 + width;
+            const uint8_t* vu = vuPlane + static_cast<size_t>(cy) * width;
+            uint8_t* dst = maskOut.ptr<uint8_t>(cy);
+
+            for (int cx = 0; cx < chromaWidth; ++cx) {
+                const int luma = (y0[2 * cx] + y0[2 * cx + 1] + y1[2 * cx] + y1[2 * cx + 1] + 2) >> 2;
+                const uint64_t bits = table[(vu[2 * cx] >> BIN_SHIFT) * BINS + (vu[2 * cx + 1] >> BIN_SHIFT)];
+                dst[cx] = static_cast<uint8_t>(0 - ((bits >> (luma >> BIN_SHIFT)) & 1));
+            }
+        }
+    });
+}
+
+void ColorMask::compute(const uint8_t* nv21Data, int width, int height, cv::Size size,
+                        cv::Mat& maskOut) {
+    if (size.width == width / 2 && size.height == height / 2) {
+        compute(nv21Data, width, height, maskOut);
+        return;
+    }
+
+    compute(nv21Data, width, height, chromaMask_);
+    cv::resize(chromaMask_, maskOut, size, 0, 0, cv::INTER_NEAREST);
+}
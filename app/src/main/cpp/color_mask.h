@@ -0,0 +1,64 @@
+#ifndef COLOR_MASK_H
+#define COLOR_MASK_H
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * Hue/saturation/value range classification straight from NV21.
+ * Implementation is in color_mask.cpp.
+ *
+ * Replaces NV21 -> RGBA -> HSV -> inRange (three full-resolution passes)
+ * with one pass over the chroma grid: each VU sample and the mean of the
+ * 2x2 Y block it covers index a precomputed table. The table is rebuilt
+ * only when the range changes.
+ */
+struct HsvRange {
+    // OpenCV 8-bit HSV units: hue 0-179, saturation/value 0-255.
+    // hueMin > hueMax selects a range that wraps through red (e.g. 170..10).
+    int hueMin = 0;
+    int hueMax = 179;
+    int satMin = 0;
+    int satMax = 255;
+    int valMin = 0;
+    int valMax = 255;
+
+    bool operator==(const HsvRange& o) const {
+        return hueMin == o.hueMin && hueMax == o.hueMax && satMin == o.satMin &&
+               satMax == o.satMax && valMin == o.valMin && valMax == o.valMax;
+    }
+};
+
+class ColorMask {
+public:
+    /** Select the color range; the table is rebuilt on the next compute(). */
+    void setRange(const HsvRange& range);
+    const HsvRange& range() const { return range_; }
+
+    /**
+     * Classify an NV21 frame at chroma resolution.
+     * @param maskOut CV_8UC1, (width/2) x (height/2), 255 inside the range
+     */
+    void compute(const uint8_t* nv21Data, int width, int height, cv::Mat& maskOut);
+
+    /**
+     * Classify and resample to an arbitrary size (nearest neighbour). When
+     * size is the chroma size no resampling happens.
+     */
+    void compute(const uint8_t* nv21Data, int width, int height, cv::Size size, cv::Mat& maskOut);
+
+private:
+    void rebuildTable();
+
+    HsvRange range_;
+    bool dirty_ = true;
+
+    // One 64-bit word per (V, U) bin pair; bit n set if Y bin n is in range.
+    // 64 x 64 x 8 bytes = 32 KB, small enough to stay in L1/L2.
+    std::vector<uint64_t> table_;
+
+    cv::Mat chromaMask_;
+};
+
+#endif // COLOR_MASK_H
@@ -0,0 +1,311 @@
+#include "compositor.h"
+#include "gl_util.h"
+#include "stats.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#define LOG_TAG "Compositor"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+/**
+ * compositor.cpp - Atlas-based multi-stream compositing.
+ *
+ * An atlas (rather than a GLES3 texture array) keeps this working on the
+ * app's ES 2.0 context while still needing only one texture bind and one
+ * draw. Cells are sized to the largest processed stream; each stream is
+ * processed at the resolution of its on-screen tile (see
+ * processorChooseDownscale), so a 3x3 grid of 720p streams uploads roughly
+ * one 720p frame's worth of pixels in total.
+ */
+
+static const int ATLAS_COLUMNS = 3;
+static const int ATLAS_ROWS = 3;
+
+// PiP insets: fraction of the viewport and margin in pixels
+static const float PIP_SCALE = 0.25f;
+static const float PIP_MIN_SCALE = 0.1f;     // Insets shrink to this before overflowing
+static const float PIP_MARGIN = 16.0f;
+
+void Compositor::onSurfaceCreated() {
+    release(false);
+
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize_);
+
+    glGenTextures(1, &atlas_);
+    glBindTexture(GL_TEXTURE_2D, atlas_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenBuffers(1, &vbo_);
+    verticesDirty_ = true;
+}
+
+void Compositor::release(bool deleteObjects) {
+    if (deleteObjects) {
+        if (atlas_ != 0) glDeleteTextures(1, &atlas_);
+        if (vbo_ != 0) glDeleteBuffers(1, &vbo_);
+    }
+    atlas_ = 0;
+    vbo_ = 0;
+    cellWidth_ = 0;
+    cellHeight_ = 0;
+
+    // Cell contents are gone with the texture; wait for new frames
+    for (Stream& stream : streams_) {
+        stream.hasFrame = false;
+    }
+}
+
+void Compositor::setViewport(int width, int height) {
+    if (width != viewWidth_ || height != viewHeight_) {
+        viewWidth_ = width;
+        viewHeight_ = height;
+        verticesDirty_ = true;
+    }
+}
+
+void Compositor::setLayout(CompositeLayout layout) {
+    if (layout != layout_) {
+        layout_ = layout;
+        verticesDirty_ = true;
+    }
+}
+
+void Compositor::setOutputFormat(OutputFormat format) {
+    format_ = format;
+}
+
+int Compositor::streamCount() const {
+    int count = 0;
+    for (const Stream& stream : streams_) {
+        count += stream.active ? 1 : 0;
+    }
+    return count;
+}
+
+bool Compositor::hasStream(int streamId) const {
+    return streamId >= 0 && streamId < MAX_STREAMS && streams_[streamId].active;
+}
+
+void Compositor::removeStream(int streamId) {
+    if (streamId < 0 || streamId >= MAX_STREAMS || !streams_[streamId].active) {
+        return;
+    }
+    streams_[streamId] = Stream();
+    verticesDirty_ = true;
+    LOGI("Stream %d removed", streamId);
+}
+
+/**
+ * Tile rectangle in pixels (x0, y0, x1, y1; origin top-left) for the
+ * order-th visible stream out of count.
+ */
+void Compositor::tileRect(int order, int count, float rect[4]) const {
+    const float w = static_cast<float>(viewWidth_);
+    const float h = static_cast<float>(viewHeight_);
+
+    if (layout_ == LAYOUT_PIP) {
+        if (order == 0) {
+            rect[0] = 0.0f; rect[1] = 0.0f; rect[2] = w; rect[3] = h;
+            return;
+        }
+        // Insets in rows from the bottom edge up, each row right to left.
+        // They shrink if the rows would not fit in the view otherwise.
+        const int insets = count - 1;
+        float scale = PIP_SCALE;
+        float insetW, insetH;
+        int perRow;
+        for (;;) {
+            insetW = w * scale;
+            insetH = h * scale;
+            perRow = std::max(1, static_cast<int>((w - PIP_MARGIN) / (insetW + PIP_MARGIN)));
+            const int rows = (insets + perRow - 1) / perRow;
+            if (rows * (insetH + PIP_MARGIN) + PIP_MARGIN <= h || scale <= PIP_MIN_SCALE) {
+                break;
+            }
+            scale = std::max(scale * 0.8f, PIP_MIN_SCALE);
+        }
+        const int column = (order - 1) % perRow;
+        const int row = (order - 1) / perRow;
+        const float x1 = w - PIP_MARGIN - column * (insetW + PIP_MARGIN);
+        const float y1 = h - PIP_MARGIN - row * (insetH + PIP_MARGIN);
+        rect[0] = x1 - insetW; rect[1] = y1 - insetH;
+        rect[2] = x1;          rect[3] = y1;
+        return;
+    }
+
+    const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+    const int rows = (count + columns - 1) / columns;
+    const float tileW = w / columns;
+    const float tileH = h / rows;
+    rect[0] = (order % columns) * tileW;
+    rect[1] = (order / columns) * tileH;
+    rect[2] = rect[0] + tileW;
+    rect[3] = rect[1] + tileH;
+}
+
+void Compositor::ensureAtlas(int cellWidth, int cellHeight) {
+    if (cellWidth <= cellWidth_ && cellHeight <= cellHeight_ && format_ == atlasFormat_) {
+        return;
+    }
+
+    cellWidth_ = std::max(cellWidth, cellWidth_);
+    cellHeight_ = std::max(cellHeight, cellHeight_);
+    atlasFormat_ = format_;
+    LOGI("Atlas resize: cells %dx%d, texture %dx%d", cellWidth_, cellHeight_,
+         cellWidth_ * ATLAS_COLUMNS, cellHeight_ * ATLAS_ROWS);
+
+    glBindTexture(GL_TEXTURE_2D, atlas_);
+    allocateOutputTexture(cellWidth_ * ATLAS_COLUMNS, cellHeight_ * ATLAS_ROWS, atlasFormat_);
+
+    // Old contents are undefined after reallocation; texcoords depend on cell size
+    for (Stream& stream : streams_) {
+        stream.hasFrame = false;
+    }
+    verticesDirty_ = true;
+}
+
+bool Compositor::updateStream(int streamId, const uint8_t* nv21Data, int width, int height) {
+    if (streamId < 0 || streamId >= MAX_STREAMS || atlas_ == 0) {
+        LOGE("updateStream: invalid stream %d", streamId);
+        return false;
+    }
+
+    Stream& stream = streams_[streamId];
+    if (!stream.active) {
+        stream.active = true;
+        stream.processor = processorCreateStream(streamId == 0);
+        verticesDirty_ = true;
+        LOGI("Stream %d added: %dx%d", streamId, width, height);
+    }
+
+    // Process at the resolution of this stream's tile, within the atlas cell limit
+    int order = 0;
+    for (int i = 0; i < streamId; ++i) {
+        order += streams_[i].active ? 1 : 0;
+    }
+    float rect[4];
+    tileRect(order, streamCount(), rect);
+    const int maxCellW = maxTextureSize_ / ATLAS_COLUMNS;
+    const int maxCellH = maxTextureSize_ / ATLAS_ROWS;
+    int downscale = processorChooseDownscale(width, height,
+                                             static_cast<int>(rect[2] - rect[0]),
+                                             static_cast<int>(rect[3] - rect[1]));
+    while ((width / downscale > maxCellW || height / downscale > maxCellH) && downscale < 8) {
+        downscale *= 2;
+    }
+    const int outWidth = width / downscale;
+    const int outHeight = height / downscale;
+
+    stream.pixels.resize(static_cast<size_t>(outWidth) * outHeight * 4);
+    processFrame(nv21Data, width, height, stream.pixels.data(), downscale, format_, nullptr,
+                 stream.processor.get());
+
+    ensureAtlas(outWidth, outHeight);
+    if (outWidth != stream.width || outHeight != stream.height) {
+        stream.width = outWidth;
+        stream.height = outHeight;
+        verticesDirty_ = true;
+    }
+
+    // Upload only this stream's cell
+    glBindTexture(GL_TEXTURE_2D, atlas_);
+    {
+        ScopedStatTimer timer(STAT_UPLOAD);
+        uploadOutputTexture((streamId % ATLAS_COLUMNS) * cellWidth_,
+                            (streamId / ATLAS_COLUMNS) * cellHeight_,
+                            outWidth, outHeight, format_, stream.pixels.data());
+    }
+    statsAddUploadBytes(static_cast<uint64_t>(outWidth) * outHeight * outputBytesPerPixel(format_));
+
+    if (!stream.hasFrame) {
+        stream.hasFrame = true;
+        verticesDirty_ = true;
+    }
+    return true;
+}
+
+void Compositor::rebuildVertices() {
+    verticesDirty_ = false;
+    vertexCount_ = 0;
+    if (viewWidth_ <= 0 || viewHeight_ <= 0 || vbo_ == 0) {
+        return;
+    }
+
+    const int count = streamCount();
+    const float atlasW = static_cast<float>(cellWidth_ * ATLAS_COLUMNS);
+    const float atlasH = static_cast<float>(cellHeight_ * ATLAS_ROWS);
+    std::vector<GLfloat> vertices;
+    vertices.reserve(count * 6 * 4);
+
+    int order = 0;
+    for (int id = 0; id < MAX_STREAMS; ++id) {
+        const Stream& stream = streams_[id];
+        if (!stream.active) {
+            continue;
+        }
+        float rect[4];
+        tileRect(order++, count, rect);
+        if (!stream.hasFrame || atlasW <= 0.0f) {
+            continue;
+        }
+
+        // Pixel rect -> NDC (y up)
+        const float x0 = rect[0] / viewWidth_ * 2.0f - 1.0f;
+        const float x1 = rect[2] / viewWidth_ * 2.0f - 1.0f;
+        const float y0 = 1.0f - rect[1] / viewHeight_ * 2.0f;
+        const float y1 = 1.0f - rect[3] / viewHeight_ * 2.0f;
+
+        // Cell texcoords, inset by half a texel so linear filtering never
+        // bleeds in a neighbouring cell
+        const float cellX = static_cast<float>((id % ATLAS_COLUMNS) * cellWidth_);
+        const float cellY = static_cast<float>((id / ATLAS_COLUMNS) * cellHeight_);
+        const float u0 = (cellX + 0.5f) / atlasW;
+        const float u1 = (cellX + stream.width - 0.5f) / atlasW;
+        const float v0 = (cellY + 0.5f) / atlasH;
+        const float v1 = (cellY + stream.height - 0.5f) / atlasH;
+
+        const GLfloat quad[] = {
+                x0, y1, u0, v1,   x1, y1, u1, v1,   x0, y0, u0, v0,
+                x1, y1, u1, v1,   x1, y0, u1, v0,   x0, y0, u0, v0,
+        };
+        vertices.insert(vertices.end(), std::begin(quad), std::end(quad));
+    }
+
+    vertexCount_ = static_cast<GLsizei>(vertices.size() / 4);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(),
+                 GL_STATIC_DRAW);
+}
+
+void Compositor::draw(GLuint program, GLint positionLoc, GLint texCoordLoc, GLint textureLoc) {
+    if (verticesDirty_) {
+        rebuildVertices();
+    }
+    if (vertexCount_ == 0) {
+        return;
+    }
+
+    glUseProgram(program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlas_);
+    glUniform1i(textureLoc, 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glEnableVertexAttribArray(positionLoc);
+    glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(texCoordLoc);
+    glVertexAttribPointer(texCoordLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat),
+                          (void*)(2 * sizeof(GLfloat)));
+
+    // All tiles, one call; later tiles (PiP insets) paint over earlier ones
+    glDrawArrays(GL_TRIANGLES, 0, vertexCount_);
+
+    glDisableVertexAttribArray(positionLoc);
+    glDisableVertexAttribArray(texCoordLoc);
+}
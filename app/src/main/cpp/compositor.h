@@ -0,0 +1,85 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <GLES2/gl2.h>
+#include <cstdint>
+#include <vector>
+#include "processor.h"
+
+/**
+ * Multi-stream compositor.
+ * Implementation is in compositor.cpp.
+ *
+ * Every stream is processed into its own cell of one atlas texture, and all
+ * visible tiles are drawn with a single batched glDrawArrays from a static
+ * VBO that is rebuilt only when the layout, viewport or stream set changes.
+ * Streams without a new frame cost nothing per frame: no processing, no
+ * upload and no extra draw call. Each stream has its own processor state,
+ * and only stream 0 (the camera preview) feeds the panorama and
+ * calibration modes.
+ */
+enum CompositeLayout {
+    LAYOUT_GRID = 0,    // Equal tiles, ceil(sqrt(N)) columns
+    LAYOUT_PIP = 1      // Lowest stream id full screen, others as insets
+};
+
+class Compositor {
+public:
+    static const int MAX_STREAMS = 9;   // Atlas is a 3x3 grid of cells
+
+    // GL resources (call with a current context)
+    void onSurfaceCreated();
+    void release(bool deleteObjects);
+
+    void setViewport(int width, int height);
+    void setLayout(CompositeLayout layout);
+    void setOutputFormat(OutputFormat format);
+
+    /**
+     * Process an NV21 frame for a stream and upload it into the stream's cell.
+     * Registers the stream on first use. Returns false for invalid ids.
+     */
+    bool updateStream(int streamId, const uint8_t* nv21Data, int width, int height);
+    void removeStream(int streamId);
+
+    int streamCount() const;
+    bool hasStream(int streamId) const;
+
+    /**
+     * Draw all tiles in one call with a program that has a vec4 position
+     * attribute, a vec2 texCoord attribute and a sampler2D uniform.
+     */
+    void draw(GLuint program, GLint positionLoc, GLint texCoordLoc, GLint textureLoc);
+
+private:
+    struct Stream {
+        bool active = false;
+        bool hasFrame = false;
+        int width = 0;              // Processed (uploaded) size
+        int height = 0;
+        std::vector<uint8_t> pixels;
+        ProcessorStreamPtr processor;   // Denoise history, palettes, tracking
+    };
+
+    void ensureAtlas(int cellWidth, int cellHeight);
+    void rebuildVertices();
+    void tileRect(int order, int count, float rect[4]) const;
+
+    Stream streams_[MAX_STREAMS];
+    CompositeLayout layout_ = LAYOUT_GRID;
+    OutputFormat format_ = OUTPUT_RGBA8888;
+    int viewWidth_ = 0;
+    int viewHeight_ = 0;
+
+    GLuint atlas_ = 0;
+    GLuint vbo_ = 0;
+    int cellWidth_ = 0;
+    int cellHeight_ = 0;
+    OutputFormat atlasFormat_ = OUTPUT_RGBA8888;
+    GLint maxTextureSize_ = 2048;
+
+    bool verticesDirty_ = true;
+    GLsizei vertexCount_ = 0;
+};
+
+#endif // COMPOSITOR_H
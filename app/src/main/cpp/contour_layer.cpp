@@ -0,0 +1,142 @@
+#include "contour_layer.h"
+#include "gl_util.h"
+#include <android/log.h>
+#include <algorithm>
+
+#define LOG_TAG "ContourLayer"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+/**
+ * contour_layer.cpp - Line strips from a preallocated vertex buffer.
+ *
+ * Strips share one buffer and are drawn with one glDrawArrays each. ES 2.0
+ * has neither primitive restart nor multi-draw, and GL_LINES would double
+ * the vertex count. A few hundred draws of the same program and buffer
+ * are cheap next to a full-frame texture upload.
+ */
+
+// Frame coordinates (0..1, y down) to screen through the inverse texture
+// transform, then to clip space (y up)
+static constexpr const char* lineVertexShaderSource = R"(
+    attribute vec2 a_position;
+    uniform mat3 u_toScreen;
+
+    void main() {
+        vec2 p = (u_toScreen * vec3(a_position, 1.0)).xy;
+        gl_Position = vec4(p.x * 2.0 - 1.0, 1.0 - p.y * 2.0, 0.0, 1.0);
+    }
+)";
+
+static constexpr const char* lineFragmentShaderSource = R"(
+    precision mediump float;
+    uniform vec4 u_color;
+
+    void main() {
+        gl_FragColor = u_color;
+    }
+)";
+
+void ContourLayer::onSurfaceCreated(int maxVertices, int slots) {
+    release(false);
+
+    program_ = linkProgram(lineVertexShaderSource, lineFragmentShaderSource);
+    positionLoc_ = glGetAttribLocation(program_, "a_position");
+    toScreenLoc_ = glGetUniformLocation(program_, "u_toScreen");
+    colorLoc_ = glGetUniformLocation(program_, "u_color");
+
+    capacity_ = std::max(maxVertices, 0);
+    slots_.resize(std::max(slots, 1));
+    for (Slot& slot : slots_) {
+        glGenBuffers(1, &slot.vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, slot.vbo);
+        glBufferData(GL_ARRAY_BUFFER, capacity_ * sizeof(cv::Point2f), nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    LOGI("Contour layer: %zu x %d vertices (%zu KB each)", slots_.size(), capacity_,
+         capacity_ * sizeof(cv::Point2f) / 1024);
+}
+
+void ContourLayer::release(bool deleteObjects) {
+    if (deleteObjects) {
+        if (program_ != 0) glDeleteProgram(program_);
+        for (Slot& slot : slots_) {
+            if (slot.vbo != 0) glDeleteBuffers(1, &slot.vbo);
+        }
+    }
+    program_ = 0;
+    slots_.clear();
+    capacity_ = 0;
+    uploadedBytes_ = 0;
+}
+
+void ContourLayer::setColor(float r, float g, float b, float a) {
+    color_[0] = r;
+    color_[1] = g;
+    color_[2] = b;
+    color_[3] = a;
+}
+
+void ContourLayer::upload(int slot, const ContourGeometry& geometry) {
+    uploadedBytes_ = 0;
+    if (slot < 0 || slot >= static_cast<int>(slots_.size())) {
+        return;
+    }
+    Slot& target = slots_[slot];
+    target.stripCounts.clear();
+
+    // Whole strips only
+    int vertices = 0;
+    for (int count : geometry.stripCounts) {
+        if (vertices + count > capacity_) {
+            break;
+        }
+        vertices += count;
+        target.stripCounts.push_back(count);
+    }
+    if (vertices == 0) {
+        return;
+    }
+
+    uploadedBytes_ = vertices * sizeof(cv::Point2f);
+    glBindBuffer(GL_ARRAY_BUFFER, target.vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, uploadedBytes_, geometry.vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ContourLayer::draw(int slot, const GLfloat* texTransform) {
+    if (slot < 0 || slot >= static_cast<int>(slots_.size()) || slots_[slot].stripCounts.empty()) {
+        return;
+    }
+    const Slot& source = slots_[slot];
+    cv::Matx33f toTexture;
+    for (int col = 0; col < 3; ++col) {
+        for (int row = 0; row < 3; ++row) {
+            toTexture(row, col) = texTransform[col * 3 + row];
+        }
+    }
+    const cv::Matx33f toScreen = toTexture.inv();
+    GLfloat toScreenColumns[9];
+    for (int col = 0; col < 3; ++col) {
+        for (int row = 0; row < 3; ++row) {
+            toScreenColumns[col * 3 + row] = toScreen(row, col);
+        }
+    }
+
+    glUseProgram(program_);
+    glUniformMatrix3fv(toScreenLoc_, 1, GL_FALSE, toScreenColumns);
+    glUniform4fv(colorLoc_, 1, color_);
+    glLineWidth(lineWidth_);
+
+    glBindBuffer(GL_ARRAY_BUFFER, source.vbo);
+    glEnableVertexAttribArray(positionLoc_);
+    glVertexAttribPointer(positionLoc_, 2, GL_FLOAT, GL_FALSE, sizeof(cv::Point2f), nullptr);
+
+    GLint first = 0;
+    for (int count : source.stripCounts) {
+        glDrawArrays(GL_LINE_STRIP, first, count);
+        first += count;
+    }
+
+    glDisableVertexAttribArray(positionLoc_);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,56 @@
+#ifndef CONTOUR_LAYER_H
+#define CONTOUR_LAYER_H
+
+#include <GLES2/gl2.h>
+#include "contour_vectors.h"
+
+/**
+ * Draws ContourGeometry as GL line strips over the camera quad.
+ * Implementation is in contour_layer.cpp.
+ *
+ * There is one vertex buffer per texture ring slot, each allocated once for
+ * maxVertices and updated with glBufferSubData, so a frame uploads 8 bytes
+ * per vertex and never reallocates GPU memory. The renderer writes a slot's
+ * buffer together with its texture, after the slot's last draw has
+ * finished, and draws the buffer of the slot on screen; the lines therefore
+ * belong to the displayed frame and its texture transform, and an upload
+ * never waits on a draw still reading the buffer. Vertices are in
+ * normalized frame coordinates and go through the inverse of the slot's
+ * texture transform, so the lines stay on the stabilized image.
+ */
+class ContourLayer {
+public:
+    // GL resources (call with a current context)
+    void onSurfaceCreated(int maxVertices, int slots);
+    void release(bool deleteObjects);
+
+    /** Copy the geometry into a slot's buffer; excess vertices are dropped. */
+    void upload(int slot, const ContourGeometry& geometry);
+
+    /** texTransform maps screen to texture coordinates (column-major mat3). */
+    void draw(int slot, const GLfloat* texTransform);
+
+    /** Bytes copied to the GPU by the last upload. */
+    size_t uploadedBytes() const { return uploadedBytes_; }
+
+    void setColor(float r, float g, float b, float a);
+    void setLineWidth(float width) { lineWidth_ = width; }
+
+private:
+    struct Slot {
+        GLuint vbo = 0;
+        std::vector<int> stripCounts;  // Strips in the buffer
+    };
+
+    GLuint program_ = 0;
+    std::vector<Slot> slots_;
+    GLint positionLoc_ = -1;
+    GLint toScreenLoc_ = -1;
+    GLint colorLoc_ = -1;
+    int capacity_ = 0;              // Vertices each buffer holds
+    size_t uploadedBytes_ = 0;
+    GLfloat color_[4] = {1.0f, 0.85f, 0.2f, 1.0f};
+    float lineWidth_ = 2.0f;
+};
+
+#endif // CONTOUR_LAYER_H
@@ -0,0 +1,79 @@
+#include "contour_vectors.h"
+#include <opencv2/imgproc.hpp>
+#include <android/log.h>
+#include <algorithm>
+
+#define LOG_TAG "ContourVectors"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+/**
+ * contour_vectors.cpp - findContours + approxPolyDP into a fixed-capacity
+ * vertex list.
+ *
+ * Canny edges are one pixel wide. findContours therefore traces a thin
+ * open curve as a loop that runs out along one side and back along the
+ * other. It traces a thin closed curve twice: once as an outer boundary
+ * and once as the hole inside it. With RETR_CCOMP the holes are the
+ * second level of the hierarchy. Skipping them drops the duplicate of
+ * every closed curve, while shapes nested inside others are still
+ * outer boundaries and are kept.
+ *
+ * Contours are treated as closed. Each strip repeats its first vertex at
+ * the end, so a GL_LINE_STRIP draws the whole outline.
+ */
+
+void ContourVectorizer::set(const ContourParams& params) {
+    ContourParams clamped = params;
+    clamped.epsilon = std::max(clamped.epsilon, 0.0);
+    clamped.minLength = std::max(clamped.minLength, 0.0);
+    clamped.maxVertices = std::max(clamped.maxVertices, 64);
+    clamped.maxStrips = std::max(clamped.maxStrips, 1);
+    if (configured_ && clamped == params_) {
+        return;
+    }
+    params_ = clamped;
+    configured_ = true;
+    LOGI("Contour vectors: epsilon %.1f px, min length %.0f px, capacity %d vertices / %d strips",
+         params_.epsilon, params_.minLength, params_.maxVertices, params_.maxStrips);
+}
+
+void ContourVectorizer::extract(const cv::Mat& edges, ContourGeometry& out) {
+    CV_Assert(edges.type() == CV_8UC1);
+    if (!configured_) {
+        set(params_);
+    }
+    out.clear();
+    out.vertices.reserve(params_.maxVertices);
+    out.stripCounts.reserve(params_.maxStrips);
+
+    cv::findContours(edges, contours_, hierarchy_, cv::RETR_CCOMP, cv::CHAIN_APPROX_SIMPLE);
+
+    const float sx = 1.0f / edges.cols;
+    const float sy = 1.0f / edges.rows;
+    for (size_t i = 0; i < contours_.size(); ++i) {
+        if (hierarchy_[i][3] >= 0) {
+            continue;   // Hole: the inside of a closed edge already traced
+        }
+        const std::vector<cv::Point>& contour = contours_[i];
+        if (cv::arcLength(contour, true) < params_.minLength) {
+            continue;
+        }
+        cv::approxPolyDP(contour, approx_, params_.epsilon, true);
+        if (approx_.size() < 2) {
+            continue;
+        }
+
+        const size_t count = approx_.size() + 1;
+        if (out.vertices.size() + count > static_cast<size_t>(params_.maxVertices) ||
+            out.stripCounts.size() >= static_cast<size_t>(params_.maxStrips)) {
+            out.truncated = true;
+            break;
+        }
+        // Pixel centers, normalized
+        for (const cv::Point& p : approx_) {
+            out.vertices.emplace_back((p.x + 0.5f) * sx, (p.y + 0.5f) * sy);
+        }
+        out.vertices.push_back(out.vertices[out.vertices.size() - approx_.size()]);
+        out.stripCounts.push_back(static_cast<int>(count));
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef CONTOUR_VECTORS_H
+#define CONTOUR_VECTORS_H
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * Edges as geometry: polylines from a binary edge image (Canny output).
+ * Implementation is in contour_vectors.cpp; ContourLayer (contour_layer.h)
+ * draws the result as GL line strips.
+ *
+ * findContours traces the edge pixels and approxPolyDP reduces each
+ * contour to a few vertices. A frame's edges typically come down to a few
+ * thousand vertices, a few tens of KB, where the same edges as an RGBA
+ * texture are a full frame of pixels. The polylines are drawn at screen
+ * resolution, however small the processed image.
+ */
+struct ContourParams {
+    double epsilon = 1.5;           // approxPolyDP tolerance, processing pixels
+    double minLength = 24.0;        // Contours shorter than this are dropped, pixels
+    int maxVertices = 16384;        // Capacity of ContourGeometry (and the GL buffer)
+    int maxStrips = 2048;
+
+    bool operator==(const ContourParams& o) const {
+        return epsilon == o.epsilon && minLength == o.minLength &&
+               maxVertices == o.maxVertices && maxStrips == o.maxStrips;
+    }
+};
+
+/**
+ * Polylines of one frame, back to back. Storage is reserved once for the
+ * params' capacity, so steady-state frames allocate nothing.
+ */
+struct ContourGeometry {
+    std::vector<cv::Point2f> vertices;  // Normalized frame coordinates (0..1, y down)
+    std::vector<int> stripCounts;       // Vertices per strip, in order
+    bool truncated = false;             // Capacity ran out; later contours dropped
+
+    void clear() {
+        vertices.clear();
+        stripCounts.clear();
+        truncated = false;
+    }
+};
+
+class ContourVectorizer {
+public:
+    void set(const ContourParams& params);
+    const ContourParams& params() const { return params_; }
+
+    /** Vectorize a CV_8UC1 edge image (non-zero = edge) into out. */
+    void extract(const cv::Mat& edges, ContourGeometry& out);
+
+private:
+    ContourParams params_;
+    bool configured_ = false;
+
+    // Scratch reused between frames
+    std::vector<std::vector<cv::Point>> contours_;
+    std::vector<cv::Vec4i> hierarchy_;
+    std::vector<cv::Point> approx_;
+};
+
+#endif // CONTOUR_VECTORS_H
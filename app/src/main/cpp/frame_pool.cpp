@@ -0,0 +1,129 @@
+#include "frame_pool.h"
+#include <android/log.h>
+#include <cstdlib>
+#include <new>
+
+#define LOG_TAG "FramePool"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+/**
+ * frame_pool.cpp - Lock-free buffer recycling.
+ *
+ * The free list is a Treiber stack of buffer indices. The head carries a
+ * 32-bit tag that changes on every successful pop/push, so a buffer that is
+ * popped, released and pushed back between another thread's load and CAS
+ * cannot be mistaken for the old head (ABA).
+ */
+
+static constexpr uint64_t kIndexMask = 0xffffffffull;
+
+static inline uint64_t makeHead(uint64_t previous, uint32_t link) {
+    return (((previous >> 32) + 1) << 32) | link;
+}
+
+FramePool::FramePool(size_t bufferBytes, int count, StatPool statPool, size_t alignment)
+        : bufferBytes_((bufferBytes + alignment - 1) & ~(alignment - 1)),
+          count_(count),
+          statPool_(statPool),
+          buffers_(new FrameBuffer[count]) {
+    void* slab = nullptr;
+    if (posix_memalign(&slab, alignment, bufferBytes_ * count_) != 0) {
+        LOGE("Failed to allocate %d x %zu byte frame buffers", count_, bufferBytes_);
+        throw std::bad_alloc();
+    }
+    slab_ = static_cast<uint8_t*>(slab);
+
+    // Chain every buffer into the free list: 1 -> 2 -> ... -> count -> end
+    for (int i = 0; i < count_; ++i) {
+        FrameBuffer& buffer = buffers_[i];
+        buffer.data = slab_ + bufferBytes_ * i;
+        buffer.capacity = bufferBytes_;
+        buffer.pool = this;
+        buffer.index = static_cast<uint32_t>(i);
+        buffer.nextFree.store(i + 1 < count_ ? static_cast<uint32_t>(i + 2) : 0,
+                              std::memory_order_relaxed);
+    }
+    freeHead_.store(count_ > 0 ? 1 : 0, std::memory_order_release);
+    statsPoolUpdate(statPool_, 0, count_);
+
+    LOGI("Frame pool: %d x %zu bytes (%zu-byte aligned)", count_, bufferBytes_, alignment);
+}
+
+FramePool::~FramePool() {
+    if (inUse() != 0) {
+        LOGE("Frame pool destroyed with %d buffers still referenced", inUse());
+    }
+    std::free(slab_);
+}
+
+FrameHandle FramePool::acquire() {
+    uint64_t head = freeHead_.load(std::memory_order_acquire);
+    while (true) {
+        const uint32_t link = static_cast<uint32_t>(head & kIndexMask);
+        if (link == 0) {
+            statsPoolExhausted(statPool_);
+            return FrameHandle();
+        }
+
+        FrameBuffer* buffer = &buffers_[link - 1];
+        const uint32_t next = buffer->nextFree.load(std::memory_order_relaxed);
+        if (freeHead_.compare_exchange_weak(head, makeHead(head, next),
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+            buffer->refCount.store(1, std::memory_order_relaxed);
+            buffer->sequence = nextSequence_.fetch_add(1, std::memory_order_relaxed) + 1;
+            buffer->timestampNs = 0;
+
+            const int used = inUse_.fetch_add(1, std::memory_order_relaxed) + 1;
+            statsPoolUpdate(statPool_, used, count_);
+            return FrameHandle(buffer);
+        }
+    }
+}
+
+void FramePool::recycle(FrameBuffer* buffer) {
+    const uint32_t link = buffer->index + 1;
+    uint64_t head = freeHead_.load(std::memory_order_relaxed);
+    do {
+        buffer->nextFree.store(static_cast<uint32_t>(head & kIndexMask), std::memory_order_relaxed);
+    } while (!freeHead_.compare_exchange_weak(head, makeHead(head, link),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+
+    const int used = inUse_.fetch_sub(1, std::memory_order_relaxed) - 1;
+    statsPoolUpdate(statPool_, used, count_);
+}
+
+FrameHandle::FrameHandle(const FrameHandle& other) : buffer_(other.buffer_) {
+    if (buffer_ != nullptr) {
+        buffer_->refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrameHandle& FrameHandle::operator=(const FrameHandle& other) {
+    if (this != &other) {
+        FrameHandle copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+FrameHandle& FrameHandle::operator=(FrameHandle&& other) noexcept {
+    if (this != &other) {
+        reset();
+        buffer_ = other.buffer_;
+        other.buffer_ = nullptr;
+    }
+    return *this;
+}
+
+void FrameHandle::reset() {
+    if (buffer_ != nullptr) {
+        // acq_rel: the releasing thread's writes are visible to the next acquirer
+        if (buffer_->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            buffer_->pool->recycle(buffer_);
+        }
+        buffer_ = nullptr;
+    }
+}
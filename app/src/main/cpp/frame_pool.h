@@ -0,0 +1,115 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "stats.h"
+
+/**
+ * Refcounted frame buffer pool.
+ * Implementation is in frame_pool.cpp.
+ *
+ * A pool owns a fixed number of preallocated, aligned buffers. acquire()
+ * hands one out as a FrameHandle; copying a handle bumps an intrusive
+ * atomic refcount, and the last handle to go away returns the buffer to
+ * the pool's lock-free free list. JNI, processor, renderer and sinks pass
+ * handles around instead of copying pixels.
+ *
+ * The pool must outlive every handle it has handed out.
+ */
+enum FrameFormat {
+    FRAME_NV21 = 0,
+    FRAME_RGBA8888,
+    FRAME_RGB565,
+    FRAME_GRAY8
+};
+
+class FramePool;
+
+struct FrameBuffer {
+    uint8_t* data = nullptr;
+    size_t capacity = 0;
+
+    // Metadata, written by the producer before the handle is shared
+    int width = 0;
+    int height = 0;
+    FrameFormat format = FRAME_NV21;
+    int64_t timestampNs = 0;
+    uint64_t sequence = 0;      // Assigned by acquire(), monotonically increasing
+
+private:
+    friend class FramePool;
+    friend class FrameHandle;
+
+    std::atomic<int> refCount{0};
+    std::atomic<uint32_t> nextFree{0};  // Free-list link (index + 1, 0 = end)
+    FramePool* pool = nullptr;
+    uint32_t index = 0;
+};
+
+class FrameHandle {
+public:
+    FrameHandle() = default;
+    FrameHandle(const FrameHandle& other);
+    FrameHandle(FrameHandle&& other) noexcept : buffer_(other.buffer_) { other.buffer_ = nullptr; }
+    FrameHandle& operator=(const FrameHandle& other);
+    FrameHandle& operator=(FrameHandle&& other) noexcept;
+    ~FrameHandle() { reset(); }
+
+    void reset();
+
+    FrameBuffer* get() const { return buffer_; }
+    FrameBuffer* operator->() const { return buffer_; }
+    FrameBuffer& operator*() const { return *buffer_; }
+    explicit operator bool() const { return buffer_ != nullptr; }
+
+private:
+    friend class FramePool;
+    explicit FrameHandle(FrameBuffer* buffer) : buffer_(buffer) {}
+
+    FrameBuffer* buffer_ = nullptr;
+};
+
+class FramePool {
+public:
+    /**
+     * @param bufferBytes Size of each buffer (rounded up to alignment)
+     * @param count Number of buffers
+     * @param statPool Stats slot for pressure/exhaustion reporting
+     * @param alignment Buffer alignment in bytes (power of two)
+     */
+    FramePool(size_t bufferBytes, int count, StatPool statPool, size_t alignment = 64);
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /**
+     * Take a free buffer. Returns an empty handle (and counts an exhaustion)
+     * when every buffer is still referenced. Lock-free.
+     */
+    FrameHandle acquire();
+
+    size_t bufferBytes() const { return bufferBytes_; }
+    int capacity() const { return count_; }
+    int inUse() const { return inUse_.load(std::memory_order_relaxed); }
+
+private:
+    friend class FrameHandle;
+    void recycle(FrameBuffer* buffer);
+
+    size_t bufferBytes_;
+    int count_;
+    StatPool statPool_;
+    uint8_t* slab_ = nullptr;
+    std::unique_ptr<FrameBuffer[]> buffers_;
+
+    // Free-list head: (ABA tag << 32) | (index + 1); low half 0 = empty
+    std::atomic<uint64_t> freeHead_{0};
+    std::atomic<int> inUse_{0};
+    std::atomic<uint64_t> nextSequence_{0};
+};
+
+#endif // FRAME_POOL_H
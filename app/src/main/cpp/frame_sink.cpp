@@ -0,0 +1,252 @@
+#include "frame_sink.h"
+#include <android/log.h>
+#include <pthread.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <thread>
+
+#define LOG_TAG "FrameSink"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+/**
+ * frame_sink.cpp - Per-sink queues and worker threads.
+ *
+ * Each sink owns a small deque guarded by its own mutex. publish() holds
+ * that mutex only long enough to push (and possibly evict) a handle; the
+ * worker pops under the lock and calls consume() with it released.
+ */
+
+static const double LAG_EMA_ALPHA = 1.0 / 16.0;
+
+using Clock = std::chrono::steady_clock;
+
+struct QueuedFrame {
+    FrameHandle frame;
+    Clock::time_point publishedAt;
+};
+
+struct SinkRegistry::Sink {
+    int id = 0;
+    std::shared_ptr<FrameSink> sink;
+    SinkDropPolicy policy = SINK_DROP_OLDEST;
+    int queueDepth = 1;
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<QueuedFrame> queue;
+    bool stopping = false;
+
+    // Counters, guarded by mutex
+    uint64_t received = 0;
+    uint64_t consumed = 0;
+    uint64_t dropped = 0;
+    uint64_t newestSequence = 0;
+    uint64_t consumedSequence = 0;
+    double lagMs = -1.0;
+    double maxLagMs = 0.0;
+
+    std::thread thread;
+};
+
+SinkRegistry::SinkRegistry() = default;
+
+SinkRegistry::~SinkRegistry() {
+    removeAll();
+}
+
+int SinkRegistry::addSink(std::shared_ptr<FrameSink> sink, SinkDropPolicy policy, int queueDepth,
+                          int maxReservedFrames) {
+    if (!sink) {
+        return -1;
+    }
+
+    std::unique_ptr<Sink> entry(new Sink());
+    entry->sink = std::move(sink);
+    entry->policy = policy;
+    entry->queueDepth = std::max(1, queueDepth);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (maxReservedFrames > 0) {
+        int reserved = 0;
+        for (const std::unique_ptr<Sink>& other : sinks_) {
+            reserved += other->queueDepth + 1;
+        }
+        if (reserved + entry->queueDepth + 1 > maxReservedFrames) {
+            LOGE("addSink: '%s' needs %d buffers, only %d of %d left for sinks",
+                 entry->sink->name(), entry->queueDepth + 1, maxReservedFrames - reserved,
+                 maxReservedFrames);
+            return -1;
+        }
+    }
+    entry->id = nextId_++;
+    entry->thread = std::thread(&SinkRegistry::runSink, entry.get());
+    LOGI("Sink %d '%s' added (depth %d, %s)", entry->id, entry->sink->name(), entry->queueDepth,
+         policy == SINK_DROP_OLDEST ? "drop-oldest" : "drop-newest");
+
+    const int id = entry->id;
+    sinks_.push_back(std::move(entry));
+    return id;
+}
+
+void SinkRegistry::stopSink(Sink& sink) {
+    {
+        std::lock_guard<std::mutex> lock(sink.mutex);
+        sink.stopping = true;
+        sink.queue.clear();
+    }
+    sink.ready.notify_one();
+    if (sink.thread.joinable()) {
+        sink.thread.join();
+    }
+}
+
+bool SinkRegistry::removeSink(int id) {
+    std::unique_ptr<Sink> removed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(sinks_.begin(), sinks_.end(),
+                               [id](const std::unique_ptr<Sink>& s) { return s->id == id; });
+        if (it == sinks_.end()) {
+            return false;
+        }
+        removed = std::move(*it);
+        sinks_.erase(it);
+    }
+
+    // Join outside the registry lock so publish() is never held up by a
+    // sink finishing a long consume()
+    stopSink(*removed);
+    LOGI("Sink %d '%s' removed", id, removed->sink->name());
+    return true;
+}
+
+void SinkRegistry::removeAll() {
+    std::vector<std::unique_ptr<Sink>> removed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        removed.swap(sinks_);
+    }
+    for (std::unique_ptr<Sink>& sink : removed) {
+        stopSink(*sink);
+    }
+}
+
+void SinkRegistry::publish(const FrameHandle& frame) {
+    if (!frame) {
+        return;
+    }
+
+    const Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::unique_ptr<Sink>& sink : sinks_) {
+        {
+            std::lock_guard<std::mutex> sinkLock(sink->mutex);
+            sink->received++;
+            sink->newestSequence = frame->sequence;
+
+            if (static_cast<int>(sink->queue.size()) >= sink->queueDepth) {
+                sink->dropped++;
+                if (sink->policy == SINK_DROP_NEWEST) {
+                    continue;
+                }
+                sink->queue.pop_front();
+            }
+            sink->queue.push_back(QueuedFrame{frame, now});
+        }
+        sink->ready.notify_one();
+    }
+    publishCount_++;
+}
+
+int SinkRegistry::reservedFrames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int frames = 0;
+    for (const std::unique_ptr<Sink>& sink : sinks_) {
+        frames += sink->queueDepth + 1;
+    }
+    return frames;
+}
+
+size_t SinkRegistry::sinkCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sinks_.size();
+}
+
+bool SinkRegistry::sinkStats(int id, SinkStats& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const std::unique_ptr<Sink>& sink : sinks_) {
+        if (sink->id != id) {
+            continue;
+        }
+        std::lock_guard<std::mutex> sinkLock(sink->mutex);
+        out.received = sink->received;
+        out.consumed = sink->consumed;
+        out.dropped = sink->dropped;
+        out.queued = static_cast<int>(sink->queue.size());
+        out.framesBehind = sink->newestSequence > sink->consumedSequence
+                ? sink->newestSequence - sink->consumedSequence : 0;
+        out.lagMs = std::max(0.0, sink->lagMs);
+        out.maxLagMs = sink->maxLagMs;
+        return true;
+    }
+    return false;
+}
+
+void SinkRegistry::logStats(int interval) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sinks_.empty() || interval <= 0 || publishCount_ == 0 || publishCount_ % interval != 0) {
+        return;
+    }
+    for (const std::unique_ptr<Sink>& sink : sinks_) {
+        std::lock_guard<std::mutex> sinkLock(sink->mutex);
+        const uint64_t behind = sink->newestSequence > sink->consumedSequence
+                ? sink->newestSequence - sink->consumedSequence : 0;
+        LOGI("Sink '%s': %llu/%llu consumed, %llu dropped, %zu queued, %llu behind, "
+             "lag %.2f ms (max %.2f)", sink->sink->name(),
+             static_cast<unsigned long long>(sink->consumed),
+             static_cast<unsigned long long>(sink->received),
+             static_cast<unsigned long long>(sink->dropped), sink->queue.size(),
+             static_cast<unsigned long long>(behind), std::max(0.0, sink->lagMs), sink->maxLagMs);
+    }
+}
+
+void SinkRegistry::runSink(Sink* sink) {
+    char threadName[16];
+    std::snprintf(threadName, sizeof(threadName), "sink-%s", sink->sink->name());
+    pthread_setname_np(pthread_self(), threadName);
+
+    while (true) {
+        QueuedFrame next;
+        {
+            std::unique_lock<std::mutex> lock(sink->mutex);
+            sink->ready.wait(lock, [sink] { return sink->stopping || !sink->queue.empty(); });
+            if (sink->stopping) {
+                return;
+            }
+            next = std::move(sink->queue.front());
+            sink->queue.pop_front();
+
+            const double lag = std::chrono::duration<double, std::milli>(
+                    Clock::now() - next.publishedAt).count();
+            sink->lagMs = sink->lagMs < 0 ? lag : sink->lagMs + LAG_EMA_ALPHA * (lag - sink->lagMs);
+            sink->maxLagMs = std::max(sink->maxLagMs, lag);
+        }
+
+        try {
+            sink->sink->consume(*next.frame);
+        } catch (const std::exception& e) {
+            LOGE("Sink '%s' consume failed: %s", sink->sink->name(), e.what());
+        }
+
+        std::lock_guard<std::mutex> lock(sink->mutex);
+        sink->consumed++;
+        sink->consumedSequence = next.frame->sequence;
+        // next.frame is released after the lock, returning the buffer once
+        // the display and every other sink are done with it
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef FRAME_SINK_H
+#define FRAME_SINK_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "frame_pool.h"
+
+/**
+ * Fan-out of processed frames to independent consumers.
+ * Implementation is in frame_sink.cpp.
+ *
+ * The renderer publishes each processed frame once, as a shared FrameHandle.
+ * Every registered sink (recording, shared-memory export, analytics, ...)
+ * gets its own bounded queue and worker thread, so a slow sink only ever
+ * drops its own frames; publish() never waits on a consumer.
+ */
+enum SinkDropPolicy {
+    SINK_DROP_OLDEST = 0,   // Queue full: evict the oldest queued frame (stay current)
+    SINK_DROP_NEWEST        // Queue full: reject the incoming frame (keep a contiguous run)
+};
+
+class FrameSink {
+public:
+    virtual ~FrameSink() = default;
+
+    /** Short name for logs and stats */
+    virtual const char* name() const = 0;
+
+    /**
+     * Called on the sink's own thread, one frame at a time. The buffer is
+     * shared with the display and other sinks and must not be written.
+     */
+    virtual void consume(const FrameBuffer& frame) = 0;
+};
+
+struct SinkStats {
+    uint64_t received = 0;      // Frames offered by publish()
+    uint64_t consumed = 0;      // Frames handed to consume()
+    uint64_t dropped = 0;       // Frames discarded by the drop policy
+    int queued = 0;             // Frames currently waiting
+    uint64_t framesBehind = 0;  // Newest published sequence - last consumed sequence
+    double lagMs = 0.0;         // Smoothed publish-to-consume delay
+    double maxLagMs = 0.0;
+};
+
+class SinkRegistry {
+public:
+    SinkRegistry();
+    ~SinkRegistry();
+
+    SinkRegistry(const SinkRegistry&) = delete;
+    SinkRegistry& operator=(const SinkRegistry&) = delete;
+
+    /**
+     * Register a sink and start its worker thread.
+     * @param queueDepth Frames the sink may have waiting (>= 1)
+     * @param maxReservedFrames Refuse the sink if reservedFrames() would
+     *                          exceed this (0 = no limit); checked under the
+     *                          registry lock, so concurrent adds cannot both
+     *                          pass
+     * @return Sink id, used for removeSink() and sinkStats(); -1 if refused
+     */
+    int addSink(std::shared_ptr<FrameSink> sink, SinkDropPolicy policy, int queueDepth = 2,
+                int maxReservedFrames = 0);
+
+    /** Stop and join a sink's thread; queued frames are released. */
+    bool removeSink(int id);
+    void removeAll();
+
+    /**
+     * Offer a frame to every sink. Only takes short per-queue locks; never
+     * blocks on consume().
+     */
+    void publish(const FrameHandle& frame);
+
+    /**
+     * Frames the registered sinks may hold at once (queued plus one being
+     * consumed each). Owners of the frame pool use this to keep buffers
+     * free for the display path.
+     */
+    int reservedFrames() const;
+
+    size_t sinkCount() const;
+    bool sinkStats(int id, SinkStats& out) const;
+
+    /** Log one line per sink every interval publishes */
+    void logStats(int interval = 120);
+
+private:
+    struct Sink;
+    static void runSink(Sink* sink);
+    static void stopSink(Sink& sink);
+
+    mutable std::mutex mutex_;      // Guards sinks_ (publish vs add/remove)
+    std::vector<std::unique_ptr<Sink>> sinks_;
+    int nextId_ = 1;
+    uint64_t publishCount_ = 0;
+};
+
+#endif // FRAME_SINK_H
@@ -0,0 +1,61 @@
+#include "frame_worker.h"
+#include <utility>
+
+/**
+ * frame_worker.cpp - Single-slot frame hand-off to a worker thread.
+ *
+ * pending_ and work_ swap on each wake-up, so once their sizes settle the
+ * copy in submit() reuses the buffer the worker finished with and nothing
+ * is allocated per frame.
+ */
+
+FrameWorker::FrameWorker(std::function<void(const cv::Mat&)> process)
+    : process_(std::move(process)) {
+}
+
+FrameWorker::~FrameWorker() {
+    stop();
+}
+
+bool FrameWorker::submit(const cv::Mat& frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (busy_ || stop_) {
+        return false;
+    }
+    // The worker is idle and does not touch pending_ until woken
+    frame.copyTo(pending_);
+    busy_ = true;
+    if (!thread_.joinable()) {
+        thread_ = std::thread(&FrameWorker::run, this);
+    }
+    wake_.notify_one();
+    return true;
+}
+
+void FrameWorker::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void FrameWorker::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        // busy_ is only set together with a new pending_ frame
+        wake_.wait(lock, [this] { return stop_ || busy_; });
+        if (stop_) {
+            return;
+        }
+        std::swap(pending_, work_);
+
+        lock.unlock();
+        process_(work_);
+        lock.lock();
+        busy_ = false;
+    }
+}
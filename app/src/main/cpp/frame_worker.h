@@ -0,0 +1,51 @@
+#ifndef FRAME_WORKER_H
+#define FRAME_WORKER_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <opencv2/core.hpp>
+
+/**
+ * Worker thread with a single pending-frame slot, for stages that are too
+ * slow for the frame thread and only ever need the latest frame.
+ * Implementation is in frame_worker.cpp.
+ *
+ * submit() copies a frame and wakes the worker only while the worker is
+ * idle, and otherwise drops the frame, so the frame thread never waits on
+ * the work. The thread starts on the first submit() and calls the process
+ * function once per accepted frame, without holding the worker's lock.
+ * Owners keep their results under their own mutex.
+ */
+class FrameWorker {
+public:
+    explicit FrameWorker(std::function<void(const cv::Mat&)> process);
+    ~FrameWorker();
+    FrameWorker(const FrameWorker&) = delete;
+    FrameWorker& operator=(const FrameWorker&) = delete;
+
+    /** Copy the frame if the worker is idle; returns false (frame skipped) if not. */
+    bool submit(const cv::Mat& frame);
+
+    /**
+     * Finish the frame in progress and join the thread; later frames are
+     * dropped. Owners call it first in their destructor, while the state
+     * the process function uses still exists.
+     */
+    void stop();
+
+private:
+    void run();
+
+    std::function<void(const cv::Mat&)> process_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::thread thread_;
+    bool stop_ = false;
+    bool busy_ = false;             // A frame is pending or being processed
+    cv::Mat pending_;               // Frame handed over by submit()
+    cv::Mat work_;                  // Frame being processed
+};
+
+#endif // FRAME_WORKER_H
@@ -0,0 +1,80 @@
+#include "gl_ext.h"
+#include <EGL/egl.h>
+#include <android/log.h>
+#include <cstring>
+
+#define LOG_TAG "GlExt"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+/**
+ * gl_ext.cpp - Runtime resolution of optional GL features.
+ *
+ * Rendering must work on plain ES 2.0 devices, so every feature here is an
+ * optimization with a fallback in renderer.cpp.
+ */
+
+template <typename Proc>
+static Proc loadProc(const char* name) {
+    return reinterpret_cast<Proc>(eglGetProcAddress(name));
+}
+
+bool hasGlExtension(const char* name) {
+    const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    if (extensions == nullptr) {
+        return false;
+    }
+
+    const size_t len = std::strlen(name);
+    for (const char* p = std::strstr(extensions, name); p != nullptr;
+         p = std::strstr(p + len, name)) {
+        const bool startOk = p == extensions || p[-1] == ' ';
+        const bool endOk = p[len] == ' ' || p[len] == '\0';
+        if (startOk && endOk) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void loadGlExtensions(GlExtensions& ext) {
+    ext = GlExtensions();
+
+    // "OpenGL ES 3.2 ..." on ES contexts, "3.3 (Core Profile) Mesa ..." on desktop
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    if (version != nullptr) {
+        ext.isEs = std::strncmp(version, "OpenGL ES", 9) == 0;
+        const char* digits = ext.isEs ? version + 10 : version;
+        if (digits[0] >= '0' && digits[0] <= '9') {
+            ext.majorVersion = digits[0] - '0';
+        }
+    }
+
+    if (ext.majorVersion >= 3) {
+        ext.fenceSync = loadProc<PFNGLFENCESYNCPROC>("glFenceSync");
+        ext.clientWaitSync = loadProc<PFNGLCLIENTWAITSYNCPROC>("glClientWaitSync");
+        ext.deleteSync = loadProc<PFNGLDELETESYNCPROC>("glDeleteSync");
+        ext.hasFenceSync = ext.fenceSync && ext.clientWaitSync && ext.deleteSync;
+    }
+
+    if (hasGlExtension("GL_EXT_disjoint_timer_query")) {
+        ext.genQueries = loadProc<PFNGLGENQUERIESEXTPROC>("glGenQueriesEXT");
+        ext.deleteQueries = loadProc<PFNGLDELETEQUERIESEXTPROC>("glDeleteQueriesEXT");
+        ext.beginQuery = loadProc<PFNGLBEGINQUERYEXTPROC>("glBeginQueryEXT");
+        ext.endQuery = loadProc<PFNGLENDQUERYEXTPROC>("glEndQueryEXT");
+        ext.getQueryObjectuiv = loadProc<PFNGLGETQUERYOBJECTUIVEXTPROC>("glGetQueryObjectuivEXT");
+        ext.getQueryObjectui64v = loadProc<PFNGLGETQUERYOBJECTUI64VEXTPROC>("glGetQueryObjectui64vEXT");
+        ext.hasDisjointFlag = true;
+    } else if (!ext.isEs && (ext.majorVersion >= 4 || hasGlExtension("GL_ARB_timer_query"))) {
+        ext.genQueries = loadProc<PFNGLGENQUERIESEXTPROC>("glGenQueries");
+        ext.deleteQueries = loadProc<PFNGLDELETEQUERIESEXTPROC>("glDeleteQueries");
+        ext.beginQuery = loadProc<PFNGLBEGINQUERYEXTPROC>("glBeginQuery");
+        ext.endQuery = loadProc<PFNGLENDQUERYEXTPROC>("glEndQuery");
+        ext.getQueryObjectuiv = loadProc<PFNGLGETQUERYOBJECTUIVEXTPROC>("glGetQueryObjectuiv");
+        ext.getQueryObjectui64v = loadProc<PFNGLGETQUERYOBJECTUI64VEXTPROC>("glGetQueryObjectui64v");
+    }
+    ext.hasTimerQuery = ext.genQueries && ext.deleteQueries && ext.beginQuery &&
+                        ext.endQuery && ext.getQueryObjectuiv && ext.getQueryObjectui64v;
+
+    LOGI("GL %s: fence sync %s, timer query %s", version ? version : "?",
+         ext.hasFenceSync ? "yes" : "no", ext.hasTimerQuery ? "yes" : "no");
+}
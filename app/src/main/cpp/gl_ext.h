@@ -0,0 +1,50 @@
+#ifndef GL_EXT_LOADER_H
+#define GL_EXT_LOADER_H
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <GLES3/gl3.h>
+
+/**
+ * Optional GL entry points resolved at runtime.
+ * Implementation is in gl_ext.cpp.
+ *
+ * The app creates an OpenGL ES 2.0 context, so anything beyond ES 2.0 is
+ * looked up through eglGetProcAddress and only used when the context
+ * version or extension string says it is supported. Every pointer is null
+ * when the feature is unavailable; check the has* flag before calling.
+ */
+struct GlExtensions {
+    int majorVersion = 2;
+    bool isEs = true;               // false on desktop GL (Mesa host build)
+
+    // Fence sync (ES 3.0 core)
+    bool hasFenceSync = false;
+    PFNGLFENCESYNCPROC fenceSync = nullptr;
+    PFNGLCLIENTWAITSYNCPROC clientWaitSync = nullptr;
+    PFNGLDELETESYNCPROC deleteSync = nullptr;
+
+    // GPU timer queries: GL_EXT_disjoint_timer_query on ES,
+    // GL 3.3 / GL_ARB_timer_query on desktop. Signatures are identical.
+    bool hasTimerQuery = false;
+    bool hasDisjointFlag = false;   // GL_GPU_DISJOINT_EXT is queryable
+    PFNGLGENQUERIESEXTPROC genQueries = nullptr;
+    PFNGLDELETEQUERIESEXTPROC deleteQueries = nullptr;
+    PFNGLBEGINQUERYEXTPROC beginQuery = nullptr;
+    PFNGLENDQUERYEXTPROC endQuery = nullptr;
+    PFNGLGETQUERYOBJECTUIVEXTPROC getQueryObjectuiv = nullptr;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC getQueryObjectui64v = nullptr;
+};
+
+/**
+ * Query the current context and resolve optional entry points.
+ * Must be called on the GL thread with a current context.
+ */
+void loadGlExtensions(GlExtensions& ext);
+
+/**
+ * True if `name` appears as a whole token in GL_EXTENSIONS.
+ */
+bool hasGlExtension(const char* name);
+
+#endif // GL_EXT_LOADER_H
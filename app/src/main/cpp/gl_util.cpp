@@ -0,0 +1,69 @@
+#include "gl_util.h"
+#include <android/log.h>
+
+#define LOG_TAG "GlUtil"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// Private helper function for shader compilation
+static GLuint compileShader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    // Check compile status
+    GLint compileStatus = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
+    if (compileStatus != GL_TRUE) {
+        GLchar log[512];
+        glGetShaderInfoLog(shader, 512, nullptr, log);
+        LOGE("Shader compilation failed: %s", log);
+    }
+
+    return shader;
+}
+
+GLuint linkProgram(const char* vertexSource, const char* fragmentSource) {
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+
+    // Check link status
+    GLint linkStatus = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+    if (linkStatus != GL_TRUE) {
+        GLchar log[512];
+        glGetProgramInfoLog(program, 512, nullptr, log);
+        LOGE("Shader link failed: %s", log);
+    }
+
+    // Shaders are no longer needed once linked
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+void allocateOutputTexture(int width, int height, OutputFormat format) {
+    if (format == OUTPUT_RGB565) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height,
+                     0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, nullptr);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height,
+                     0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+}
+
+void uploadOutputTexture(int x, int y, int width, int height,
+                         OutputFormat format, const void* pixels) {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (format == OUTPUT_RGB565) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height,
+                        GL_RGB, GL_UNSIGNED_SHORT_5_6_5, pixels);
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height,
+                        GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef GL_UTIL_H
+#define GL_UTIL_H
+
+#include <GLES2/gl2.h>
+#include "processor.h"
+
+/**
+ * Small GL helpers shared by the renderer and compositor.
+ * Implementation is in gl_util.cpp.
+ */
+
+/**
+ * Compile and link a program from vertex/fragment sources.
+ * Logs and returns the (possibly unlinked) program on failure.
+ */
+GLuint linkProgram(const char* vertexSource, const char* fragmentSource);
+
+/**
+ * Allocate storage for the bound GL_TEXTURE_2D in the given output format.
+ */
+void allocateOutputTexture(int width, int height, OutputFormat format);
+
+/**
+ * glTexSubImage2D into the bound GL_TEXTURE_2D with the GL format/type
+ * matching an OutputFormat. Rows must be tightly packed.
+ */
+void uploadOutputTexture(int x, int y, int width, int height,
+                         OutputFormat format, const void* pixels);
+
+#endif // GL_UTIL_H
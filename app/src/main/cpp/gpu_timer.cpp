@@ -0,0 +1,116 @@
+#include "gpu_timer.h"
+#include <android/log.h>
+
+#define LOG_TAG "GpuTimer"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+/**
+ * gpu_timer.cpp - Double-buffered GL_TIME_ELAPSED queries.
+ *
+ * A section whose every query is still in flight simply skips measurement
+ * for that frame instead of waiting on the GPU. Results from a frame where
+ * the GPU reported a disjoint event (frequency change, context switch) are
+ * discarded.
+ */
+
+static const StatStage sectionStages[GPU_SECTION_COUNT] = {
+        STAT_GPU_UPLOAD,
+        STAT_GPU_DRAW,
+        STAT_GPU_HUD,
+        STAT_GPU_LINES,
+};
+
+void GpuTimer::init(const GlExtensions& ext) {
+    release(false);
+    if (!ext.hasTimerQuery) {
+        LOGI("Timer queries unavailable; GPU stages disabled");
+        return;
+    }
+
+    ext_ = &ext;
+    for (auto& sectionQueries : queries_) {
+        ext_->genQueries(QUERY_RING, sectionQueries);
+    }
+    LOGI("GPU timer initialized (%d queries per section)", QUERY_RING);
+}
+
+void GpuTimer::release(bool deleteObjects) {
+    if (ext_ != nullptr && deleteObjects) {
+        for (auto& sectionQueries : queries_) {
+            ext_->deleteQueries(QUERY_RING, sectionQueries);
+        }
+    }
+
+    ext_ = nullptr;
+    for (int s = 0; s < GPU_SECTION_COUNT; ++s) {
+        for (int i = 0; i < QUERY_RING; ++i) {
+            queries_[s][i] = 0;
+            pending_[s][i] = false;
+        }
+        next_[s] = 0;
+    }
+    active_ = -1;
+}
+
+void GpuTimer::begin(GpuSection section) {
+    if (ext_ == nullptr || active_ >= 0) {
+        return;
+    }
+
+    // Use the next query slot only if its previous result has been read
+    const int slot = next_[section];
+    if (pending_[section][slot]) {
+        collect();
+        if (pending_[section][slot]) {
+            return;
+        }
+    }
+
+    ext_->beginQuery(GL_TIME_ELAPSED_EXT, queries_[section][slot]);
+    active_ = section;
+    activeSlot_ = slot;
+}
+
+void GpuTimer::end(GpuSection section) {
+    if (ext_ == nullptr || active_ != section) {
+        return;
+    }
+
+    ext_->endQuery(GL_TIME_ELAPSED_EXT);
+    pending_[section][activeSlot_] = true;
+    next_[section] = (activeSlot_ + 1) % QUERY_RING;
+    active_ = -1;
+}
+
+void GpuTimer::collect() {
+    if (ext_ == nullptr) {
+        return;
+    }
+
+    // Disjoint flag is sticky until read; if set, all in-flight results are suspect
+    GLint disjoint = 0;
+    if (ext_->hasDisjointFlag) {
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    }
+
+    for (int s = 0; s < GPU_SECTION_COUNT; ++s) {
+        for (int i = 0; i < QUERY_RING; ++i) {
+            if (!pending_[s][i]) {
+                continue;
+            }
+
+            GLuint available = 0;
+            ext_->getQueryObjectuiv(queries_[s][i], GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+            if (!available) {
+                continue;
+            }
+
+            GLuint64 elapsedNs = 0;
+            ext_->getQueryObjectui64v(queries_[s][i], GL_QUERY_RESULT_EXT, &elapsedNs);
+            pending_[s][i] = false;
+            if (!disjoint) {
+                statsRecord(sectionStages[s], elapsedNs / 1.0e6);
+            }
+        }
+    }
+}
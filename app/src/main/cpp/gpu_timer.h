@@ -0,0 +1,71 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include "gl_ext.h"
+#include "stats.h"
+
+/**
+ * GPU-side timing of renderer sections with timer queries.
+ * Implementation is in gpu_timer.cpp.
+ *
+ * CPU timings around glTexSubImage2D/glDrawArrays only measure driver
+ * queuing; this measures when the GPU actually executed the work. Each
+ * section has a small ring of query objects, so results are read back one
+ * or two frames later and never stall. Sections must not overlap (only one
+ * GL_TIME_ELAPSED query may be active at a time).
+ */
+enum GpuSection {
+    GPU_UPLOAD = 0,     // Texture upload
+    GPU_DRAW,           // Camera quad (and any effect passes in its shader)
+    GPU_HUD,            // Performance HUD overlay
+    GPU_LINES,          // Contour and Hough line overlays
+    GPU_SECTION_COUNT
+};
+
+class GpuTimer {
+public:
+    static const int QUERY_RING = 3;
+
+    // Create query objects if the context supports timer queries
+    void init(const GlExtensions& ext);
+
+    // Delete query objects (deleteObjects = false after context loss)
+    void release(bool deleteObjects);
+
+    bool available() const { return ext_ != nullptr; }
+
+    void begin(GpuSection section);
+    void end(GpuSection section);
+
+    // Read back finished queries and record them into stats (non-blocking)
+    void collect();
+
+private:
+    const GlExtensions* ext_ = nullptr;
+    GLuint queries_[GPU_SECTION_COUNT][QUERY_RING] = {};
+    bool pending_[GPU_SECTION_COUNT][QUERY_RING] = {};
+    int next_[GPU_SECTION_COUNT] = {};
+    int active_ = -1;       // Section with an open query, -1 if none
+    int activeSlot_ = 0;
+};
+
+/**
+ * RAII helper: times a scope as a GPU section when timer queries exist.
+ */
+class ScopedGpuTimer {
+public:
+    ScopedGpuTimer(GpuTimer& timer, GpuSection section)
+        : timer_(timer), section_(section) {
+        timer_.begin(section_);
+    }
+
+    ~ScopedGpuTimer() {
+        timer_.end(section_);
+    }
+
+private:
+    GpuTimer& timer_;
+    GpuSection section_;
+};
+
+#endif // GPU_TIMER_H
@@ -0,0 +1,175 @@
+#include "hough_detector.h"
+#include <opencv2/imgproc.hpp>
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "HoughDetector"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+/**
+ * hough_detector.cpp - ROI-restricted, change-gated Hough transforms.
+ *
+ * Gate: INTER_AREA resizing of the 0/255 edge map to one pixel per
+ * gateCell x gateCell block gives each block's edge density. That costs
+ * one pass over the ROI, far less than either transform. Densities are
+ * compared with those of the frame the transforms last ran on, not the
+ * previous frame. Slow drift therefore adds up until it triggers a run
+ * instead of slipping through a little at a time.
+ *
+ * The accumulators are internal to OpenCV and allocated per call. The
+ * gate's grids, the segment list and the overlay's vertex storage are kept
+ * here and reused, so a gated frame allocates nothing.
+ */
+
+static const int CIRCLE_SEGMENTS = 32;
+
+static float segmentLength(const cv::Vec4i& l) {
+    return std::hypot(static_cast<float>(l[2] - l[0]), static_cast<float>(l[3] - l[1]));
+}
+
+void HoughDetector::set(const HoughParams& params) {
+    HoughParams clamped = params;
+    clamped.roi &= cv::Rect2f(0.0f, 0.0f, 1.0f, 1.0f);
+    clamped.rho = std::max(clamped.rho, 0.5);
+    clamped.theta = std::max(clamped.theta, CV_PI / 1800.0);
+    clamped.lineVotes = std::max(clamped.lineVotes, 1);
+    clamped.maxLines = std::max(clamped.maxLines, 1);
+    clamped.circleDp = std::max(clamped.circleDp, 1.0);
+    clamped.minRadius = std::max(clamped.minRadius, 1);
+    clamped.maxCircles = std::max(clamped.maxCircles, 1);
+    clamped.gateCell = std::max(clamped.gateCell, 2);
+    clamped.gateCellChange = std::min(std::max(clamped.gateCellChange, 0.0f), 1.0f);
+    clamped.gateChanged = std::min(std::max(clamped.gateChanged, 0.0f), 1.0f);
+    clamped.maxSkipFrames = std::max(clamped.maxSkipFrames, 0);
+    if (configured_ && clamped == params_) {
+        return;
+    }
+    params_ = clamped;
+    configured_ = true;
+    reset();
+    LOGI("Hough: lines %s, circles %s, ROI %.2f,%.2f %.2fx%.2f, gate %d px cells, "
+         "%.0f%% changed, every %d frames at least", params_.lines ? "on" : "off",
+         params_.circles ? "on" : "off", params_.roi.x, params_.roi.y, params_.roi.width,
+         params_.roi.height, params_.gateCell, params_.gateChanged * 100.0f, params_.maxSkipFrames);
+}
+
+void HoughDetector::reset() {
+    hasRun_ = false;
+    skipped_ = 0;
+}
+
+bool HoughDetector::edgesChanged(const cv::Mat& edgeRoi, const cv::Rect& roi) {
+    const cv::Size grid((edgeRoi.cols + params_.gateCell - 1) / params_.gateCell,
+                        (edgeRoi.rows + params_.gateCell - 1) / params_.gateCell);
+    cv::resize(edgeRoi, density_, grid, 0, 0, cv::INTER_AREA);
+
+    if (!hasRun_ || roi != lastRoi_ || skipped_ >= params_.maxSkipFrames) {
+        return true;
+    }
+    cv::absdiff(density_, runDensity_, densityDiff_);
+    cv::threshold(densityDiff_, densityDiff_, params_.gateCellChange * 255.0, 255, cv::THRESH_BINARY);
+    const double changed = static_cast<double>(cv::countNonZero(densityDiff_)) / densityDiff_.total();
+    return changed >= params_.gateChanged;
+}
+
+void HoughDetector::detect(const cv::Mat& edges, const cv::Mat& gray, HoughResult& out) {
+    CV_Assert(edges.type() == CV_8UC1);
+    if (!configured_) {
+        set(params_);
+    }
+    ++frames_;
+    out.fresh = false;
+
+    const cv::Rect roi = cv::Rect(cvRound(params_.roi.x * edges.cols), cvRound(params_.roi.y * edges.rows),
+                                  cvRound(params_.roi.width * edges.cols),
+                                  cvRound(params_.roi.height * edges.rows)) & cv::Rect(0, 0, edges.cols, edges.rows);
+    if (roi.width < params_.gateCell || roi.height < params_.gateCell) {
+        return;
+    }
+    const cv::Mat edgeRoi = edges(roi);
+    if (!edgesChanged(edgeRoi, roi)) {
+        ++skipped_;
+        return;
+    }
+    std::swap(density_, runDensity_);
+    lastRoi_ = roi;
+    hasRun_ = true;
+    skipped_ = 0;
+    ++runs_;
+    out.fresh = true;
+
+    out.lines.clear();
+    if (params_.lines) {
+        cv::HoughLinesP(edgeRoi, lines_, params_.rho, params_.theta, params_.lineVotes,
+                        params_.minLineLength, params_.maxLineGap);
+        if (lines_.size() > static_cast<size_t>(params_.maxLines)) {
+            std::partial_sort(lines_.begin(), lines_.begin() + params_.maxLines, lines_.end(),
+                              [](const cv::Vec4i& a, const cv::Vec4i& b) {
+                                  return segmentLength(a) > segmentLength(b);
+                              });
+            lines_.resize(params_.maxLines);
+        }
+        for (const cv::Vec4i& l : lines_) {
+            out.lines.emplace_back(l[0] + roi.x, l[1] + roi.y, l[2] + roi.x, l[3] + roi.y);
+        }
+    }
+
+    out.circles.clear();
+    if (params_.circles && !gray.empty()) {
+        CV_Assert(gray.type() == CV_8UC1);
+        const double s = static_cast<double>(gray.cols) / edges.cols;
+        const cv::Rect grayRoi = cv::Rect(cvRound(roi.x * s), cvRound(roi.y * s), cvRound(roi.width * s),
+                                          cvRound(roi.height * s)) & cv::Rect(0, 0, gray.cols, gray.rows);
+        const int maxRadius = params_.maxRadius > 0 ? params_.maxRadius : std::min(roi.width, roi.height) / 2;
+        cv::HoughCircles(gray(grayRoi), out.circles, cv::HOUGH_GRADIENT, params_.circleDp,
+                         params_.minCircleDistance * s, params_.cannyHigh, params_.circleVotes,
+                         std::max(cvRound(params_.minRadius * s), 1), std::max(cvRound(maxRadius * s), 1));
+        // Strongest first
+        if (out.circles.size() > static_cast<size_t>(params_.maxCircles)) {
+            out.circles.resize(params_.maxCircles);
+        }
+        for (cv::Vec3f& c : out.circles) {
+            c = cv::Vec3f(static_cast<float>(c[0] / s + roi.x), static_cast<float>(c[1] / s + roi.y),
+                          static_cast<float>(c[2] / s));
+        }
+    }
+
+    buildOverlay(out, edges.size(), roi);
+}
+
+void HoughDetector::buildOverlay(HoughResult& out, cv::Size frameSize, const cv::Rect& roi) const {
+    ContourGeometry& overlay = out.overlay;
+    overlay.clear();
+    overlay.vertices.reserve(params_.maxLines * 2 + params_.maxCircles * (CIRCLE_SEGMENTS + 1) + 5);
+    overlay.stripCounts.reserve(params_.maxLines + params_.maxCircles + 1);
+
+    const float sx = 1.0f / frameSize.width;
+    const float sy = 1.0f / frameSize.height;
+    // Pixel centers, like the contour vectors
+    const auto add = [&](float x, float y) {
+        overlay.vertices.emplace_back((x + 0.5f) * sx, (y + 0.5f) * sy);
+    };
+
+    for (const cv::Vec4i& l : out.lines) {
+        add(l[0], l[1]);
+        add(l[2], l[3]);
+        overlay.stripCounts.push_back(2);
+    }
+    for (const cv::Vec3f& c : out.circles) {
+        for (int i = 0; i <= CIRCLE_SEGMENTS; ++i) {
+            const float a = static_cast<float>(2.0 * CV_PI * i / CIRCLE_SEGMENTS);
+            add(c[0] + c[2] * std::cos(a), c[1] + c[2] * std::sin(a));
+        }
+        overlay.stripCounts.push_back(CIRCLE_SEGMENTS + 1);
+    }
+    if (roi.size() != frameSize) {
+        // Outline the region the transforms look at
+        add(roi.x, roi.y);
+        add(roi.x + roi.width - 1, roi.y);
+        add(roi.x + roi.width - 1, roi.y + roi.height - 1);
+        add(roi.x, roi.y + roi.height - 1);
+        add(roi.x, roi.y);
+        overlay.stripCounts.push_back(5);
+    }
+}
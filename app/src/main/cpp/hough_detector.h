@@ -0,0 +1,116 @@
+#ifndef HOUGH_DETECTOR_H
+#define HOUGH_DETECTOR_H
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "contour_vectors.h"
+
+/**
+ * Straight lines and circles (lanes, gauges, dials) from the Canny edge map
+ * the edge modes already compute. Implementation is in hough_detector.cpp.
+ *
+ * Two things keep it cheap enough to leave on:
+ * - an optional region of interest, so the transforms only vote over the
+ *   part of the frame where the lines or the gauge are
+ * - temporal gating: the edge map is reduced to a coarse density grid and
+ *   compared with the grid of the last run. While too few cells have
+ *   changed, the last results are kept and no transform runs. A run is
+ *   forced every maxSkipFrames frames anyway.
+ * Lines come from HoughLinesP on the edge map itself. OpenCV's
+ * HOUGH_GRADIENT needs the gray image, and runs its own Canny (cannyHigh)
+ * plus Sobel, so circles are found on the gray image, by default at half
+ * resolution.
+ */
+struct HoughParams {
+    bool lines = false;             // HoughLinesP on the edge map
+    bool circles = false;           // HoughCircles on the gray image
+    cv::Rect2f roi = cv::Rect2f(0.0f, 0.0f, 1.0f, 1.0f);   // Normalized frame coordinates
+
+    // Lines, processing pixels
+    double rho = 1.0;
+    double theta = CV_PI / 180.0;
+    int lineVotes = 60;             // Accumulator threshold
+    double minLineLength = 40.0;
+    double maxLineGap = 8.0;
+    int maxLines = 64;              // Longest ones kept
+
+    // Circles, processing pixels
+    bool circlesHalfRes = true;     // Vote on the half-resolution gray image
+    double circleDp = 1.5;          // Accumulator resolution divisor
+    double minCircleDistance = 40.0;
+    double cannyHigh = 160.0;       // HOUGH_GRADIENT's internal Canny threshold
+    double circleVotes = 40.0;
+    int minRadius = 16;
+    int maxRadius = 0;              // 0 = half the shorter ROI side
+    int maxCircles = 8;             // Strongest ones kept
+
+    // Gating
+    int gateCell = 16;              // Density grid cell, processing pixels
+    float gateCellChange = 0.08f;   // Edge density change that marks a cell as changed
+    float gateChanged = 0.02f;      // Fraction of changed cells that triggers a run
+    int maxSkipFrames = 15;         // Frames results are kept at most without a run
+
+    bool enabled() const { return lines || circles; }
+
+    bool operator==(const HoughParams& o) const {
+        return lines == o.lines && circles == o.circles && roi == o.roi &&
+               rho == o.rho && theta == o.theta && lineVotes == o.lineVotes &&
+               minLineLength == o.minLineLength && maxLineGap == o.maxLineGap &&
+               maxLines == o.maxLines && circlesHalfRes == o.circlesHalfRes &&
+               circleDp == o.circleDp && minCircleDistance == o.minCircleDistance &&
+               cannyHigh == o.cannyHigh && circleVotes == o.circleVotes &&
+               minRadius == o.minRadius && maxRadius == o.maxRadius &&
+               maxCircles == o.maxCircles && gateCell == o.gateCell &&
+               gateCellChange == o.gateCellChange && gateChanged == o.gateChanged &&
+               maxSkipFrames == o.maxSkipFrames;
+    }
+};
+
+struct HoughResult {
+    std::vector<cv::Vec4i> lines;   // Segments, processing pixels
+    std::vector<cv::Vec3f> circles; // Center and radius, processing pixels
+    ContourGeometry overlay;        // Lines, circles and the ROI as polylines (normalized)
+    bool fresh = false;             // The transforms ran this frame (false = results kept)
+};
+
+class HoughDetector {
+public:
+    /** A change of parameters forces a run on the next frame. */
+    void set(const HoughParams& params);
+    const HoughParams& params() const { return params_; }
+
+    /** Forget the last run; the next frame runs the transforms. */
+    void reset();
+
+    /**
+     * Update out for one frame. edges is the CV_8UC1 Canny output; gray is
+     * the CV_8UC1 image for circles, at the edge map's size or half of it
+     * (see circlesHalfRes), and may be empty when circles are off. While
+     * gated, out is left as it was except for fresh.
+     */
+    void detect(const cv::Mat& edges, const cv::Mat& gray, HoughResult& out);
+
+    uint64_t frames() const { return frames_; }
+    uint64_t runs() const { return runs_; }
+
+private:
+    bool edgesChanged(const cv::Mat& edgeRoi, const cv::Rect& roi);
+    void buildOverlay(HoughResult& out, cv::Size frameSize, const cv::Rect& roi) const;
+
+    HoughParams params_;
+    bool configured_ = false;
+    bool hasRun_ = false;
+    int skipped_ = 0;               // Frames since the last run
+    uint64_t frames_ = 0;
+    uint64_t runs_ = 0;
+
+    // Kept across frames
+    cv::Rect lastRoi_;
+    cv::Mat density_;               // Edge density grid of this frame
+    cv::Mat runDensity_;            // Grid of the frame of the last run
+    cv::Mat densityDiff_;
+    std::vector<cv::Vec4i> lines_;
+};
+
+#endif // HOUGH_DETECTOR_H
@@ -0,0 +1,49 @@
+#ifndef LUMA_ENHANCE_H
+#define LUMA_ENHANCE_H
+
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+/**
+ * Low-light enhancement on the NV21 Y plane.
+ * Implementation is in luma_enhance.cpp.
+ *
+ * Contrast-limited adaptive histogram equalization followed by an unsharp
+ * mask, both on luma only. Working on Y avoids the RGBA -> Lab -> RGBA
+ * round trip the same enhancement needs on RGB data, and leaves the VU
+ * plane (color) untouched.
+ */
+struct LumaEnhanceParams {
+    bool clahe = false;
+    double clipLimit = 2.0;     // Histogram clip, in multiples of the mean bin count
+    int tiles = 8;              // Tile grid is tiles x tiles
+
+    float sharpenAmount = 0.0f; // 0 disables the unsharp mask; 0.5-1.5 typical
+    double sharpenSigma = 1.0;  // Gaussian blur sigma of the mask, in pixels
+
+    bool operator==(const LumaEnhanceParams& o) const {
+        return clahe == o.clahe && clipLimit == o.clipLimit && tiles == o.tiles &&
+               sharpenAmount == o.sharpenAmount && sharpenSigma == o.sharpenSigma;
+    }
+};
+
+class LumaEnhancer {
+public:
+    void set(const LumaEnhanceParams& params);
+    const LumaEnhanceParams& params() const { return params_; }
+
+    bool enabled() const { return params_.clahe || params_.sharpenAmount > 0.0f; }
+
+    /**
+     * Enhance a Y plane. srcY and dstY may be the same buffer (in place).
+     */
+    void apply(const uint8_t* srcY, uint8_t* dstY, int width, int height);
+
+private:
+    LumaEnhanceParams params_;
+    cv::Ptr<cv::CLAHE> clahe_;      // Created once, reconfigured on change
+    cv::Mat blurred_;
+};
+
+#endif // LUMA_ENHANCE_H
@@ -0,0 +1,209 @@
+#include "morphology.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+#include <android/log.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#define LOG_TAG "Morphology"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+/**
+ * morphology.cpp - van Herk/Gil-Werman min/max filters.
+ *
+ * A 1-D window of k samples is split into blocks of k. Within each block we
+ * keep a running prefix (g) and suffix (h) of the min/max; any window then
+ * spans at most two blocks and its result is op(h[start], g[end]). That is
+ * one op for g, one for h and one to combine, per pixel.
+ *
+ * The filter always runs down columns, so each step combines two whole rows
+ * and vectorizes across the row with OpenCV universal intrinsics. The
+ * horizontal pass transposes strips of rows into tiles, filters the tile's
+ * columns the same way and transposes back.
+ */
+
+// Below this size OpenCV's direct filter is already cheap
+static const int VHGW_MIN_KERNEL = 7;
+
+// Columns per work item in the vertical pass; rows per tile in the horizontal pass
+static const int COLUMN_CHUNK = 256;
+static const int TILE_ROWS = 64;
+
+template <bool IsMax>
+static inline uint8_t combine(uint8_t a, uint8_t b) {
+    return IsMax ? std::max(a, b) : std::min(a, b);
+}
+
+/**
+ * dst[i] = op(a[i], b[i]) for a row of n bytes.
+ */
+template <bool IsMax>
+static void combineRows(uint8_t* dst, const uint8_t* a, const uint8_t* b, int n) {
+    int i = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_uint8>::vlanes();
+    for (; i <= n - lanes; i += lanes) {
+        const cv::v_uint8 va = cv::vx_load(a + i);
+        const cv::v_uint8 vb = cv::vx_load(b + i);
+        cv::v_store(dst + i, IsMax ? cv::v_max(va, vb) : cv::v_min(va, vb));
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = combine<IsMax>(a[i], b[i]);
+    }
+}
+
+/**
+ * Min/max over a vertical window of k rows, for `cols` adjacent columns.
+ *
+ * Rows outside the image read as the op's identity (0 for max, 255 for min),
+ * which is what OpenCV's default morphology border does. The window for row
+ * y covers [y - k/2, y - k/2 + k - 1], matching the default anchor.
+ *
+ * @param scratch At least 2 * (rows + k - 1) * cols + cols bytes
+ */
+template <bool IsMax>
+static void vhgwColumns(const uint8_t* src, size_t srcStep, uint8_t* dst, size_t dstStep,
+                        int rows, int cols, int k, uint8_t* scratch) {
+    const int before = k / 2;
+    const int padded = rows + k - 1;
+    uint8_t* g = scratch;
+    uint8_t* h = g + static_cast<size_t>(padded) * cols;
+    uint8_t* padRow = h + static_cast<size_t>(padded) * cols;
+    std::memset(padRow, IsMax ? 0 : 255, cols);
+
+    auto srcRow = [&](int p) -> const uint8_t* {
+        const int y = p - before;
+        return y < 0 || y >= rows ? padRow : src + static_cast<size_t>(y) * srcStep;
+    };
+
+    // Prefix within each block of k rows
+    for (int p = 0; p < padded; ++p) {
+        uint8_t* gRow = g + static_cast<size_t>(p) * cols;
+        if (p % k == 0) {
+            std::memcpy(gRow, srcRow(p), cols);
+        } else {
+            combineRows<IsMax>(gRow, gRow - cols, srcRow(p), cols);
+        }
+    }
+
+    // Suffix within each block
+    for (int p = padded - 1; p >= 0; --p) {
+        uint8_t* hRow = h + static_cast<size_t>(p) * cols;
+        if (p % k == k - 1 || p == padded - 1) {
+            std::memcpy(hRow, srcRow(p), cols);
+        } else {
+            combineRows<IsMax>(hRow, hRow + cols, srcRow(p), cols);
+        }
+    }
+
+    // Window [y, y + k - 1] in padded rows spans the suffix of one block
+    // and the prefix of the next
+    for (int y = 0; y < rows; ++y) {
+        combineRows<IsMax>(dst + static_cast<size_t>(y) * dstStep,
+                           h + static_cast<size_t>(y) * cols,
+                           g + static_cast<size_t>(y + k - 1) * cols, cols);
+    }
+}
+
+static uint8_t* scratchBuffer(size_t bytes) {
+    thread_local static std::vector<uint8_t> scratch;
+    if (scratch.size() < bytes) {
+        scratch.resize(bytes);
+    }
+    return scratch.data();
+}
+
+template <bool IsMax>
+static void filterVertical(const cv::Mat& src, cv::Mat& dst, int k) {
+    const int chunks = (src.cols + COLUMN_CHUNK - 1) / COLUMN_CHUNK;
+    cv::parallel_for_(cv::Range(0, chunks), [&](const cv::Range& range) {
+        uint8_t* scratch = scratchBuffer(
+                (2 * static_cast<size_t>(src.rows + k - 1) + 1) * COLUMN_CHUNK);
+        for (int chunk = range.start; chunk < range.end; ++chunk) {
+            const int c0 = chunk * COLUMN_CHUNK;
+            const int cols = std::min(COLUMN_CHUNK, src.cols - c0);
+            vhgwColumns<IsMax>(src.ptr<uint8_t>() + c0, src.step, dst.ptr<uint8_t>() + c0, dst.step,
+                               src.rows, cols, k, scratch);
+        }
+    });
+}
+
+template <bool IsMax>
+static void filterHorizontal(const cv::Mat& src, cv::Mat& dst, int k) {
+    const int strips = (src.rows + TILE_ROWS - 1) / TILE_ROWS;
+    cv::parallel_for_(cv::Range(0, strips), [&](const cv::Range& range) {
+        // Tile in, tile out, then the column filter's own scratch
+        const size_t tileBytes = static_cast<size_t>(src.cols) * TILE_ROWS;
+        uint8_t* scratch = scratchBuffer(
+                2 * tileBytes + (2 * static_cast<size_t>(src.cols + k - 1) + 1) * TILE_ROWS);
+        for (int strip = range.start; strip < range.end; ++strip) {
+            const int r0 = strip * TILE_ROWS;
+            const int rows = std::min(TILE_ROWS, src.rows - r0);
+
+            cv::Mat tileIn(src.cols, rows, CV_8UC1, scratch);
+            cv::Mat tileOut(src.cols, rows, CV_8UC1, scratch + tileBytes);
+            cv::transpose(src.rowRange(r0, r0 + rows), tileIn);
+            vhgwColumns<IsMax>(tileIn.ptr<uint8_t>(), tileIn.step, tileOut.ptr<uint8_t>(), tileOut.step,
+                               src.cols, rows, k, scratch + 2 * tileBytes);
+
+            cv::Mat dstStrip = dst.rowRange(r0, r0 + rows);
+            cv::transpose(tileOut, dstStrip);
+        }
+    });
+}
+
+template <bool IsMax>
+static void minMaxRect(const cv::Mat& src, cv::Mat& dst, cv::Size kernel) {
+    if (kernel.width < VHGW_MIN_KERNEL && kernel.height < VHGW_MIN_KERNEL) {
+        const cv::Mat element = cv::getStructuringElement(cv::MORPH_RECT, kernel);
+        if (IsMax) {
+            cv::dilate(src, dst, element);
+        } else {
+            cv::erode(src, dst, element);
+        }
+        return;
+    }
+
+    // Horizontal pass into a temporary so dst may alias src
+    thread_local static cv::Mat temp;
+    temp.create(src.size(), CV_8UC1);
+    if (kernel.width > 1) {
+        filterHorizontal<IsMax>(src, temp, kernel.width);
+    } else {
+        src.copyTo(temp);
+    }
+
+    dst.create(src.size(), CV_8UC1);
+    if (kernel.height > 1) {
+        filterVertical<IsMax>(temp, dst, kernel.height);
+    } else {
+        temp.copyTo(dst);
+    }
+}
+
+void morphRect(const cv::Mat& src, cv::Mat& dst, cv::Size kernel, MorphOp op) {
+    if (src.type() != CV_8UC1 || kernel.width < 1 || kernel.height < 1) {
+        LOGE("morphRect: need CV_8UC1 and a positive kernel (got type %d, %dx%d)",
+             src.type(), kernel.width, kernel.height);
+        return;
+    }
+
+    switch (op) {
+        case MORPH_OP_DILATE:
+            minMaxRect<true>(src, dst, kernel);
+            break;
+        case MORPH_OP_ERODE:
+            minMaxRect<false>(src, dst, kernel);
+            break;
+        case MORPH_OP_OPEN:
+            minMaxRect<false>(src, dst, kernel);
+            minMaxRect<true>(dst, dst, kernel);
+            break;
+        case MORPH_OP_CLOSE:
+            minMaxRect<true>(src, dst, kernel);
+            minMaxRect<false>(dst, dst, kernel);
+            break;
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef MORPHOLOGY_H
+#define MORPHOLOGY_H
+
+#include <opencv2/core.hpp>
+
+/**
+ * Large-kernel rectangular morphology.
+ * Implementation is in morphology.cpp.
+ *
+ * Uses the van Herk/Gil-Werman algorithm: three min/max operations per
+ * pixel per pass whatever the kernel size, so 15-31 px elements on edge maps
+ * and motion masks cost the same as 3 px ones. Results match cv::dilate /
+ * cv::erode with a rectangular element, default anchor and default border.
+ */
+enum MorphOp {
+    MORPH_OP_DILATE = 0,
+    MORPH_OP_ERODE,
+    MORPH_OP_OPEN,      // Erode then dilate: removes specks smaller than the element
+    MORPH_OP_CLOSE      // Dilate then erode: fills gaps smaller than the element
+};
+
+/**
+ * Apply a rectangular morphology operation to a CV_8UC1 image.
+ * dst may be the same Mat as src.
+ *
+ * @param kernel Element size in pixels (width, height), each >= 1
+ */
+void morphRect(const cv::Mat& src, cv::Mat& dst, cv::Size kernel, MorphOp op);
+
+#endif // MORPHOLOGY_H
@@ -1,6 +1,7 @@
 #include <jni.h>
 #include <android/log.h>
 #include <memory>
+#include <chrono>
 #include <cstring>
 #include <exception>
 #include "renderer.h"
@@ -117,24 +118,31 @@ Java_com_example_opencvflam_GLSurfaceNativeView_nativeOnCameraFrame(
 
     auto* renderer = reinterpret_cast<Renderer*>(handle);
 
-    jboolean isCopy = JNI_FALSE;
-    jbyte* dataPtr = env->GetByteArrayElements(data, &isCopy);
-    if (dataPtr == nullptr) {
-        LOGE("nativeOnCameraFrame: failed to get byte array");
-        return;
-    }
-
     jsize arrayLength = env->GetArrayLength(data);
     LOGI("Frame data size: %d bytes (expected: %d)", arrayLength, width * height * 3 / 2);
 
+    // Copy the Java array once, straight into a pooled NV21 buffer
+    FrameHandle frame = renderer->acquireCameraFrame();
+    if (!frame) {
+        LOGE("nativeOnCameraFrame: camera frame pool exhausted, dropping frame");
+        return;
+    }
+    if (width != frame->width || height != frame->height ||
+        static_cast<size_t>(arrayLength) < static_cast<size_t>(width) * height * 3 / 2 ||
+        static_cast<size_t>(arrayLength) > frame->capacity) {
+        LOGE("nativeOnCameraFrame: unexpected frame %dx%d (%d bytes)", width, height, arrayLength);
+        return;
+    }
+    env->GetByteArrayRegion(data, 0, arrayLength, reinterpret_cast<jbyte*>(frame->data));
+    frame->timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
     try {
-        renderer->onCameraFrame(reinterpret_cast<uint8_t*>(dataPtr), width, height);
+        renderer->onCameraFrame(frame);
         LOGI("Frame %d processed successfully", frameCount);
     } catch (const std::exception& e) {
         LOGE("onCameraFrame failed: %s", e.what());
     }
-
-    env->ReleaseByteArrayElements(data, dataPtr, JNI_ABORT);
 }
 
 JNIEXPORT void JNICALL
@@ -160,4 +168,342 @@ Java_com_example_opencvflam_GLSurfaceNativeView_nativeOnDrawFrame(
     }
 }
 
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeOnStreamFrame(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jint streamId,
+        jbyteArray data,
+        jint width,
+        jint height) {
+
+    if (handle == 0) {
+        LOGE("nativeOnStreamFrame: invalid handle");
+        return;
+    }
+    auto* renderer = reinterpret_cast<Renderer*>(handle);
+
+    jbyte* dataPtr = env->GetByteArrayElements(data, nullptr);
+    if (dataPtr == nullptr) {
+        LOGE("nativeOnStreamFrame: failed to get byte array");
+        return;
+    }
+
+    try {
+        renderer->onStreamFrame(streamId, reinterpret_cast<uint8_t*>(dataPtr), width, height);
+    } catch (const std::exception& e) {
+        LOGE("onStreamFrame failed: %s", e.what());
+    }
+
+    env->ReleaseByteArrayElements(data, dataPtr, JNI_ABORT);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeRemoveStream(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jint streamId) {
+
+    LOGI("nativeRemoveStream: %d", streamId);
+
+    if (handle != 0) {
+        reinterpret_cast<Renderer*>(handle)->removeStream(streamId);
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeSetCompositeLayout(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jint layout) {
+
+    if (handle != 0) {
+        reinterpret_cast<Renderer*>(handle)->setCompositeLayout(
+                layout == LAYOUT_PIP ? LAYOUT_PIP : LAYOUT_GRID);
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeLoadColorLut(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jstring path) {
+
+    if (handle == 0 || path == nullptr) {
+        LOGE("nativeLoadColorLut: invalid handle or path");
+        return;
+    }
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    if (pathChars == nullptr) {
+        return;
+    }
+    LOGI("nativeLoadColorLut: %s", pathChars);
+
+    try {
+        reinterpret_cast<Renderer*>(handle)->loadColorLut(pathChars);
+    } catch (const std::exception& e) {
+        LOGE("loadColorLut failed: %s", e.what());
+    }
+
+    env->ReleaseStringUTFChars(path, pathChars);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeClearColorLut(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle) {
+
+    if (handle != 0) {
+        reinterpret_cast<Renderer*>(handle)->clearColorLut();
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeLoadReferenceSet(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jstring dbPath) {
+
+    if (handle == 0 || dbPath == nullptr) {
+        LOGE("nativeLoadReferenceSet: invalid handle or path");
+        return;
+    }
+    const char* db = env->GetStringUTFChars(dbPath, nullptr);
+    if (db == nullptr) {
+        return;
+    }
+    LOGI("nativeLoadReferenceSet: %s", db);
+    try {
+        reinterpret_cast<Renderer*>(handle)->loadReferenceSet(db);
+    } catch (const std::exception& e) {
+        LOGE("loadReferenceSet failed: %s", e.what());
+    }
+    env->ReleaseStringUTFChars(dbPath, db);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeClearReferenceSet(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle) {
+
+    if (handle != 0) {
+        reinterpret_cast<Renderer*>(handle)->clearReferenceSet();
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeResetPanorama(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle) {
+
+    if (handle != 0) {
+        reinterpret_cast<Renderer*>(handle)->resetPanorama();
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeSavePanorama(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jstring path) {
+
+    if (handle == 0 || path == nullptr) {
+        LOGE("nativeSavePanorama: invalid handle or path");
+        return;
+    }
+    const char* file = env->GetStringUTFChars(path, nullptr);
+    if (file == nullptr) {
+        return;
+    }
+    LOGI("nativeSavePanorama: %s", file);
+    try {
+        reinterpret_cast<Renderer*>(handle)->savePanorama(file);
+    } catch (const std::exception& e) {
+        LOGE("savePanorama failed: %s", e.what());
+    }
+    env->ReleaseStringUTFChars(path, file);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeSetStabilization(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jboolean enabled) {
+
+    if (handle != 0) {
+        reinterpret_cast<Renderer*>(handle)->setStabilizationEnabled(enabled == JNI_TRUE);
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeSetPeopleDetection(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jboolean enabled) {
+
+    if (handle != 0) {
+        reinterpret_cast<Renderer*>(handle)->setPeopleDetectionEnabled(enabled == JNI_TRUE);
+    }
+}
+
+/**
+ * Contour mode: copy the newest polylines into direct buffers the Java side
+ * allocates once (ByteBuffer.allocateDirect(...).order(nativeOrder())):
+ * a FloatBuffer of x, y pairs and an IntBuffer of vertex counts per strip.
+ * Returns the number of strips written, or -1 if the buffers are not
+ * direct or not of those types.
+ */
+JNIEXPORT jint JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeCopyContours(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jobject vertices,
+        jobject counts) {
+
+    if (handle == 0 || vertices == nullptr || counts == nullptr) {
+        LOGE("nativeCopyContours: invalid handle or buffers");
+        return -1;
+    }
+    // Capacities are in elements of the buffer's own type; a plain
+    // ByteBuffer would report four times as many floats as it holds
+    jclass floatBuffer = env->FindClass("java/nio/FloatBuffer");
+    jclass intBuffer = env->FindClass("java/nio/IntBuffer");
+    const bool typed = floatBuffer != nullptr && intBuffer != nullptr &&
+                       env->IsInstanceOf(vertices, floatBuffer) &&
+                       env->IsInstanceOf(counts, intBuffer);
+    if (floatBuffer != nullptr) env->DeleteLocalRef(floatBuffer);
+    if (intBuffer != nullptr) env->DeleteLocalRef(intBuffer);
+    if (!typed) {
+        LOGE("nativeCopyContours: expected a FloatBuffer and an IntBuffer");
+        return -1;
+    }
+    auto* vertexData = static_cast<float*>(env->GetDirectBufferAddress(vertices));
+    auto* countData = static_cast<int*>(env->GetDirectBufferAddress(counts));
+    if (vertexData == nullptr || countData == nullptr) {
+        LOGE("nativeCopyContours: buffers must be direct");
+        return -1;
+    }
+    const jlong vertexCapacity = env->GetDirectBufferCapacity(vertices) / 2;
+    const jlong countCapacity = env->GetDirectBufferCapacity(counts);
+    return reinterpret_cast<Renderer*>(handle)->copyContours(
+            vertexData, static_cast<int>(vertexCapacity), countData, static_cast<int>(countCapacity));
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeResetCalibration(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle) {
+
+    if (handle != 0) {
+        reinterpret_cast<Renderer*>(handle)->resetCalibration();
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeLoadCalibration(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jstring path) {
+
+    if (handle == 0 || path == nullptr) {
+        LOGE("nativeLoadCalibration: invalid handle or path");
+        return;
+    }
+    const char* file = env->GetStringUTFChars(path, nullptr);
+    if (file == nullptr) {
+        return;
+    }
+    LOGI("nativeLoadCalibration: %s", file);
+    try {
+        reinterpret_cast<Renderer*>(handle)->loadCalibration(file);
+    } catch (const std::exception& e) {
+        LOGE("loadCalibration failed: %s", e.what());
+    }
+    env->ReleaseStringUTFChars(path, file);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeSaveCalibration(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jstring path) {
+
+    if (handle == 0 || path == nullptr) {
+        LOGE("nativeSaveCalibration: invalid handle or path");
+        return;
+    }
+    const char* file = env->GetStringUTFChars(path, nullptr);
+    if (file == nullptr) {
+        return;
+    }
+    LOGI("nativeSaveCalibration: %s", file);
+    try {
+        reinterpret_cast<Renderer*>(handle)->saveCalibration(file);
+    } catch (const std::exception& e) {
+        LOGE("saveCalibration failed: %s", e.what());
+    }
+    env->ReleaseStringUTFChars(path, file);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeClearCalibration(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle) {
+
+    if (handle != 0) {
+        reinterpret_cast<Renderer*>(handle)->clearCalibration();
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeLoadTemplate(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jstring path) {
+
+    if (handle == 0 || path == nullptr) {
+        LOGE("nativeLoadTemplate: invalid handle or path");
+        return;
+    }
+    const char* file = env->GetStringUTFChars(path, nullptr);
+    if (file == nullptr) {
+        return;
+    }
+    LOGI("nativeLoadTemplate: %s", file);
+    try {
+        reinterpret_cast<Renderer*>(handle)->loadTemplate(file);
+    } catch (const std::exception& e) {
+        LOGE("loadTemplate failed: %s", e.what());
+    }
+    env->ReleaseStringUTFChars(path, file);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_opencvflam_GLSurfaceNativeView_nativeClearTemplate(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle) {
+
+    if (handle != 0) {
+        reinterpret_cast<Renderer*>(handle)->clearTemplate();
+    }
+}
+
 } // extern "C"
\ No newline at end of file
@@ -0,0 +1,295 @@
+#include "panorama.h"
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "Panorama"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+/**
+ * panorama.cpp - Keyframe-to-keyframe registration and strip warping.
+ *
+ * Registration: ORB on the low-resolution luma, 2-NN Hamming matching
+ * against the previous keyframe (a few hundred descriptors each, so brute
+ * force is cheapest), ratio test, RANSAC homography. A result is accepted
+ * only if it has enough inliers and maps the frame to a convex quad of
+ * similar area, so one bad match cannot bend the whole panorama.
+ *
+ * Canvas: keyframe k maps into the canvas through
+ *     toCanvas_k = toCanvas_(k-1) * D * H(k -> k-1) * D^-1
+ * where D rescales luma coordinates to frame coordinates. The first
+ * keyframe is held back until the second one reveals the sweep direction,
+ * then placed at the matching end of the canvas. Each new keyframe only
+ * warps the columns beyond what is already covered (warpPerspective into a
+ * canvas ROI with BORDER_TRANSPARENT), so the warp cost per keyframe is one
+ * strip, not one frame, and does not grow with the panorama.
+ */
+
+static const float MATCH_RATIO = 0.8f;
+static const double RANSAC_THRESHOLD = 3.0;     // Luma pixels
+static const double MIN_AREA_RATIO = 0.7;
+static const double MAX_AREA_RATIO = 1.4;
+
+// Consecutive failed registrations before the loss is logged
+static const int LOST_LOG_FRAMES = 15;
+
+static void cornersOf(const cv::Size& size, std::vector<cv::Point2f>& corners) {
+    const float w = static_cast<float>(size.width), h = static_cast<float>(size.height);
+    corners = {{0, 0}, {w, 0}, {w, h}, {0, h}};
+}
+
+static cv::Rect2d warpedBounds(const cv::Size& size, const cv::Matx33d& m) {
+    std::vector<cv::Point2f> corners, warped;
+    cornersOf(size, corners);
+    cv::perspectiveTransform(corners, warped, cv::Matx33f(m));
+    double x0 = warped[0].x, y0 = warped[0].y, x1 = x0, y1 = y0;
+    for (const cv::Point2f& p : warped) {
+        x0 = std::min<double>(x0, p.x);
+        y0 = std::min<double>(y0, p.y);
+        x1 = std::max<double>(x1, p.x);
+        y1 = std::max<double>(y1, p.y);
+    }
+    return cv::Rect2d(x0, y0, x1 - x0, y1 - y0);
+}
+
+void Panorama::set(const PanoramaParams& params) {
+    PanoramaParams clamped = params;
+    clamped.registerWidth = std::max(clamped.registerWidth, 64);
+    clamped.registerInterval = std::max(clamped.registerInterval, 1);
+    clamped.keyframeStep = std::min(std::max(clamped.keyframeStep, 0.05f), 0.8f);
+    clamped.minInliers = std::max(clamped.minInliers, 8);
+    clamped.canvasScale = std::min(std::max(clamped.canvasScale, 0.1f), 1.0f);
+    clamped.canvasHeight = std::max(clamped.canvasHeight, 1.0f);
+    if (clamped == params_ && orb_) {
+        return;
+    }
+    params_ = clamped;
+    orb_ = cv::ORB::create(params_.maxFeatures, 1.2f, 4);
+    canvas_.release();
+    reset();
+    LOGI("Panorama: %d px registration, keyframe every %.0f%% of a frame, %d px canvas at %.2fx",
+         params_.registerWidth, params_.keyframeStep * 100.0f, params_.canvasWidth,
+         params_.canvasScale);
+}
+
+void Panorama::reset() {
+    framesUntilRegister_ = 0;
+    keyframes_ = 0;
+    sweep_ = 0;
+    full_ = false;
+    lastInliers_ = 0;
+    lostFrames_ = 0;
+    keyframePoints_.clear();
+    keyframeDescriptors_.release();
+    firstFrame_.release();
+    covered_ = cv::Rect();
+    if (!canvas_.empty()) {
+        canvas_.setTo(cv::Scalar::all(0));
+    }
+    preview_.release();
+    previewDirty_ = false;
+}
+
+PanoramaStep Panorama::lost() {
+    if (++lostFrames_ == LOST_LOG_FRAMES) {
+        LOGI("Panorama: lost track of keyframe %d (move back over it)", keyframes_);
+    }
+    return PANORAMA_LOST;
+}
+
+PanoramaStep Panorama::track(const cv::Mat& gray) {
+    CV_Assert(gray.type() == CV_8UC1);
+    if (full_) {
+        return PANORAMA_FULL;
+    }
+    if (!orb_) {
+        set(params_);
+    }
+    framesUntilRegister_ = params_.registerInterval - 1;
+    trackWidth_ = gray.cols;
+
+    orb_->detectAndCompute(gray, cv::noArray(), points_, descriptors_);
+    if (static_cast<int>(points_.size()) < params_.minInliers) {
+        return lost();
+    }
+
+    if (keyframes_ == 0) {
+        std::swap(keyframePoints_, points_);
+        std::swap(keyframeDescriptors_, descriptors_);
+        toKeyframe_ = cv::Matx33d::eye();
+        keyframes_ = 1;
+        return PANORAMA_KEYFRAME;
+    }
+
+    matcher_.knnMatch(descriptors_, keyframeDescriptors_, knn_, 2);
+    src_.clear();
+    dst_.clear();
+    for (const std::vector<cv::DMatch>& m : knn_) {
+        if (m.size() == 2 && m[0].distance < MATCH_RATIO * m[1].distance) {
+            src_.push_back(points_[m[0].queryIdx].pt);
+            dst_.push_back(keyframePoints_[m[0].trainIdx].pt);
+        }
+    }
+    if (static_cast<int>(src_.size()) < params_.minInliers) {
+        return lost();
+    }
+
+    const cv::Mat h = cv::findHomography(src_, dst_, cv::RANSAC, RANSAC_THRESHOLD, inlierMask_);
+    if (h.empty()) {
+        return lost();
+    }
+    const int inliers = cv::countNonZero(inlierMask_);
+    if (inliers < params_.minInliers) {
+        return lost();
+    }
+
+    // Pans barely change the frame's shape; anything else is a bad fit
+    const cv::Matx33d toKeyframe(h);
+    std::vector<cv::Point2f> corners, warped;
+    cornersOf(gray.size(), corners);
+    cv::perspectiveTransform(corners, warped, cv::Matx33f(toKeyframe));
+    const double areaRatio = cv::contourArea(warped) / gray.total();
+    if (!cv::isContourConvex(warped) || areaRatio < MIN_AREA_RATIO || areaRatio > MAX_AREA_RATIO) {
+        return lost();
+    }
+
+    lostFrames_ = 0;
+    lastInliers_ = inliers;
+
+    // Horizontal advance of the frame center over the previous keyframe
+    const cv::Vec3d center = toKeyframe * cv::Vec3d(gray.cols * 0.5, gray.rows * 0.5, 1.0);
+    const double advance = (center[0] / center[2] - gray.cols * 0.5) / gray.cols;
+    if (sweep_ == 0 && std::abs(advance) >= params_.keyframeStep) {
+        sweep_ = advance > 0 ? 1 : -1;
+    }
+    if (sweep_ == 0 || advance * sweep_ < params_.keyframeStep) {
+        return PANORAMA_TRACKED;
+    }
+
+    std::swap(keyframePoints_, points_);
+    std::swap(keyframeDescriptors_, descriptors_);
+    toKeyframe_ = toKeyframe;
+    ++keyframes_;
+    return PANORAMA_KEYFRAME;
+}
+
+void Panorama::placeCanvas(const cv::Size& frameSize) {
+    const double scale = params_.canvasScale;
+    const int height = cvCeil(frameSize.height * scale * params_.canvasHeight);
+    const int width = std::max(params_.canvasWidth, cvCeil(frameSize.width * scale) + 2);
+    if (canvas_.rows != height || canvas_.cols != width) {
+        canvas_.create(height, width, CV_8UC4);
+        LOGI("Panorama canvas: %dx%d (%.1f MB)", width, height, canvasBytes() / 1048576.0);
+    }
+    canvas_.setTo(cv::Scalar::all(0));
+    frameSize_ = frameSize;
+
+    // First keyframe at the end the sweep starts from, centered vertically
+    const double frameWidth = frameSize.width * scale;
+    const double x = sweep_ > 0 ? 1.0 : width - 1.0 - frameWidth;
+    const double y = (height - frameSize.height * scale) * 0.5;
+    toCanvas_ = cv::Matx33d(scale, 0, x,
+                            0, scale, y,
+                            0, 0, 1);
+}
+
+void Panorama::warpStrip(const cv::Mat& src, const cv::Matx33d& toCanvas, cv::Rect strip) {
+    strip &= cv::Rect(0, 0, canvas_.cols, canvas_.rows);
+    if (strip.empty()) {
+        return;
+    }
+    const cv::Matx33d shift(1, 0, -strip.x,
+                            0, 1, -strip.y,
+                            0, 0, 1);
+    // Same size and type, so warpPerspective writes straight into the canvas
+    cv::Mat roi = canvas_(strip);
+    cv::warpPerspective(src, roi, shift * toCanvas, strip.size(), cv::INTER_LINEAR,
+                        cv::BORDER_TRANSPARENT);
+    covered_ = covered_.empty() ? strip : (covered_ | strip);
+    previewDirty_ = true;
+}
+
+void Panorama::stitch(const cv::Mat& rgba) {
+    CV_Assert(rgba.type() == CV_8UC4);
+    if (keyframes_ == 1) {
+        // Placement needs the sweep direction; keep the frame until then
+        rgba.copyTo(firstFrame_);
+        return;
+    }
+    if (keyframes_ < 1 || trackWidth_ <= 0) {
+        return;
+    }
+    if (!firstFrame_.empty()) {
+        if (firstFrame_.size() != rgba.size()) {
+            reset();
+            return;
+        }
+        placeCanvas(rgba.size());
+        const cv::Rect2d first = warpedBounds(firstFrame_.size(), toCanvas_);
+        warpStrip(firstFrame_, toCanvas_, cv::Rect(cvFloor(first.x), cvFloor(first.y),
+                                                   cvCeil(first.width) + 1, cvCeil(first.height) + 1));
+        firstFrame_.release();
+    } else if (rgba.size() != frameSize_) {
+        // Processing size changed mid-sweep; the chain no longer applies
+        reset();
+        return;
+    }
+
+    const double s = static_cast<double>(rgba.cols) / trackWidth_;
+    const cv::Matx33d toFrame(s, 0, 0, 0, s, 0, 0, 0, 1);
+    const cv::Matx33d toLuma(1 / s, 0, 0, 0, 1 / s, 0, 0, 0, 1);
+    const cv::Matx33d next = toCanvas_ * toFrame * toKeyframe_ * toLuma;
+
+    // Only the columns past the covered area are new
+    const cv::Rect2d bounds = warpedBounds(rgba.size(), next);
+    int x0, x1;
+    if (sweep_ > 0) {
+        x0 = std::max(cvFloor(bounds.x), covered_.x + covered_.width - 1);
+        x1 = cvCeil(bounds.x + bounds.width);
+        full_ = x1 >= canvas_.cols;
+    } else {
+        x0 = cvFloor(bounds.x);
+        x1 = std::min(cvCeil(bounds.x + bounds.width), covered_.x + 1);
+        full_ = x0 <= 0;
+    }
+    warpStrip(rgba, next, cv::Rect(x0, cvFloor(bounds.y), x1 - x0, cvCeil(bounds.height) + 1));
+    toCanvas_ = next;
+
+    if (full_) {
+        LOGI("Panorama: canvas full after %d keyframes (%d px)", keyframes_, covered_.width);
+    }
+}
+
+void Panorama::drawPreview(cv::Mat& rgba) {
+    if (covered_.empty()) {
+        return;
+    }
+
+    // Fit the covered area into a band across the top quarter of the frame
+    const int bandHeight = std::max(rgba.rows / 4, 1);
+    const double fit = std::min(static_cast<double>(bandHeight) / covered_.height,
+                                static_cast<double>(rgba.cols) / covered_.width);
+    const cv::Size size(std::max(cvRound(covered_.width * fit), 1),
+                        std::max(cvRound(covered_.height * fit), 1));
+    if (previewDirty_ || preview_.size() != size) {
+        cv::resize(canvas_(covered_), preview_, size, 0, 0, cv::INTER_AREA);
+        previewDirty_ = false;
+    }
+    cv::Mat band = rgba(cv::Rect(0, 0, size.width, size.height));
+    preview_.copyTo(band);
+
+    const cv::Scalar color = full_ ? cv::Scalar(255, 255, 255, 255) :
+                             lostFrames_ > 0 ? cv::Scalar(255, 0, 0, 255) :
+                             cv::Scalar(0, 255, 0, 255);
+    cv::rectangle(rgba, cv::Rect(0, 0, size.width, size.height), color, 2);
+}
+
+bool Panorama::snapshot(cv::Mat& out) const {
+    if (covered_.empty()) {
+        return false;
+    }
+    canvas_(covered_).copyTo(out);
+    return true;
+}
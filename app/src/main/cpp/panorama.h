@@ -0,0 +1,122 @@
+#ifndef PANORAMA_H
+#define PANORAMA_H
+
+#include <cstddef>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+/**
+ * Live sweep panorama, built incrementally while the camera pans left or
+ * right. Implementation is in panorama.cpp.
+ *
+ * cv::Stitcher registers all images against each other and composites at
+ * the end, which is far too slow for a preview. Here each frame is only
+ * registered against the previous keyframe, using ORB on a low-resolution
+ * luma. Once the camera has moved keyframeStep of a frame width, the frame
+ * becomes the next keyframe. Its homography is chained onto the previous
+ * keyframe's, and only the newly uncovered strip is warped into a canvas
+ * that is allocated once. Memory therefore stays fixed however long the
+ * sweep runs; when the canvas is full the panorama stops growing.
+ */
+struct PanoramaParams {
+    int registerWidth = 320;        // Luma width used for features
+    int maxFeatures = 400;          // ORB features per registration
+    int registerInterval = 2;       // Frames between registration attempts
+    float keyframeStep = 0.2f;      // Advance (fraction of frame width) per keyframe
+    int minInliers = 25;            // Homography inliers to accept a registration
+    float canvasScale = 0.5f;       // Canvas resolution relative to the processed frame
+    int canvasWidth = 4096;         // Canvas width in canvas pixels
+    float canvasHeight = 1.5f;      // Canvas height in scaled frame heights (room for drift)
+
+    bool operator==(const PanoramaParams& o) const {
+        return registerWidth == o.registerWidth && maxFeatures == o.maxFeatures &&
+               registerInterval == o.registerInterval && keyframeStep == o.keyframeStep &&
+               minInliers == o.minInliers && canvasScale == o.canvasScale &&
+               canvasWidth == o.canvasWidth && canvasHeight == o.canvasHeight;
+    }
+};
+
+enum PanoramaStep {
+    PANORAMA_TRACKED = 0,   // Registered, not far enough along for a keyframe
+    PANORAMA_KEYFRAME,      // Became the next keyframe; call stitch() with the frame
+    PANORAMA_LOST,          // Registration failed (too few inliers, implausible warp)
+    PANORAMA_FULL           // The canvas is full; the sweep is over
+};
+
+class Panorama {
+public:
+    /** A change of parameters starts a new panorama. */
+    void set(const PanoramaParams& params);
+    const PanoramaParams& params() const { return params_; }
+
+    /** Drop the current sweep; the canvas allocation is kept. */
+    void reset();
+
+    /** True when the next frame should be registered. */
+    bool registrationDue() const { return framesUntilRegister_ <= 0; }
+
+    /** Count a frame that is not registered (registrationDue() was false). */
+    void skipFrame() { --framesUntilRegister_; }
+
+    /**
+     * Register a CV_8UC1 luma image (at most registerWidth wide) against the
+     * previous keyframe.
+     */
+    PanoramaStep track(const cv::Mat& gray);
+
+    /**
+     * Warp the strip that the new keyframe uncovers into the canvas. rgba is
+     * the full processed frame (CV_8UC4) that was passed to track() as luma.
+     */
+    void stitch(const cv::Mat& rgba);
+
+    /** Draw the running panorama, downscaled, across the top of rgba. */
+    void drawPreview(cv::Mat& rgba);
+
+    /** Copy of the covered part of the canvas (RGBA); false before two keyframes. */
+    bool snapshot(cv::Mat& out) const;
+
+    int keyframeCount() const { return keyframes_; }
+    int lastInliers() const { return lastInliers_; }
+    size_t canvasBytes() const { return canvas_.total() * canvas_.elemSize(); }
+
+private:
+    PanoramaStep lost();
+    void placeCanvas(const cv::Size& frameSize);
+    void warpStrip(const cv::Mat& src, const cv::Matx33d& toCanvas, cv::Rect strip);
+
+    PanoramaParams params_;
+    cv::Ptr<cv::ORB> orb_;
+    cv::BFMatcher matcher_{cv::NORM_HAMMING};
+
+    int framesUntilRegister_ = 0;
+    int keyframes_ = 0;
+    int sweep_ = 0;                 // +1 panning right, -1 left, 0 not yet known
+    bool full_ = false;
+    int lastInliers_ = 0;
+    int lostFrames_ = 0;
+    int trackWidth_ = 0;            // Width of the luma given to track()
+
+    // Features of the previous keyframe and of the frame being tracked
+    std::vector<cv::KeyPoint> keyframePoints_;
+    cv::Mat keyframeDescriptors_;
+    std::vector<cv::KeyPoint> points_;
+    cv::Mat descriptors_;
+    std::vector<std::vector<cv::DMatch>> knn_;
+    std::vector<cv::Point2f> src_;
+    std::vector<cv::Point2f> dst_;
+    cv::Mat inlierMask_;
+    cv::Matx33d toKeyframe_;        // New keyframe -> previous one, luma coordinates
+
+    cv::Mat canvas_;                // CV_8UC4, allocated once per frame size
+    cv::Size frameSize_;
+    cv::Mat firstFrame_;            // Held until the sweep direction is known
+    cv::Matx33d toCanvas_;          // Latest keyframe (frame coordinates) -> canvas
+    cv::Rect covered_;              // Canvas area written so far
+
+    cv::Mat preview_;
+    bool previewDirty_ = false;
+};
+
+#endif // PANORAMA_H
@@ -0,0 +1,268 @@
+#include "people_detector.h"
+#include "stats.h"
+#include <opencv2/imgproc.hpp>
+#include <android/log.h>
+#include <algorithm>
+
+#define LOG_TAG "PeopleDetector"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+/**
+ * people_detector.cpp - pruned HOG scan on a worker, IoU tracking.
+ *
+ * Scales: at scale s the detect image is shrunk by s, so the 64x128
+ * window covers 128 * s detect pixels. s runs from the smallest person
+ * (but not below 1, which would need upsampling) to the largest one, and
+ * stops where the shrunk image no longer holds a window. At 640 px with
+ * the defaults that is six scales. detectMultiScale at full resolution
+ * with its default step of 1.05 scans 35 on a 720p frame, each on
+ * up to four times as many pixels.
+ *
+ * Scans: windows from every scale of one scan are pooled before
+ * groupRectangles. A person normally fires at two neighbouring scales or
+ * stride positions, which is what groupThreshold asks for. A lone window
+ * is usually background.
+ *
+ * Tracks: greedy IoU association, largest overlap first per detection.
+ * Matched tracks blend their box towards the detection (EMA). Unmatched
+ * detections start a new track, and tracks unmatched for more than
+ * maxMissedScans scans are dropped.
+ */
+
+static const double GROUP_EPS = 0.2;            // groupRectangles similarity
+static const double SCALE_MS_KEEP = 0.9;        // EMA of per-scale scan time
+static const double INTERVAL_KEEP = 0.8;        // EMA of the time between scans
+
+static double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+}
+
+static std::vector<float> scaleLevels(const PeopleParams& params, cv::Size detectSize, cv::Size window) {
+    const double fit = std::min(static_cast<double>(detectSize.width) / window.width,
+                                static_cast<double>(detectSize.height) / window.height);
+    const double lo = std::max(1.0, static_cast<double>(params.minHeight) * detectSize.height / window.height);
+    const double hi = std::min(fit, static_cast<double>(params.maxHeight) * detectSize.height / window.height);
+    std::vector<float> scales;
+    for (double s = lo; s <= hi + 1e-6; s *= params.scaleStep) {
+        scales.push_back(static_cast<float>(s));
+    }
+    return scales;
+}
+
+static float overlap(const cv::Rect2f& a, const cv::Rect2f& b) {
+    const float inter = (a & b).area();
+    const float uni = a.area() + b.area() - inter;
+    return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+PeopleDetector::PeopleDetector() : worker_([this](const cv::Mat& luma) { process(luma); }) {
+}
+
+PeopleDetector::~PeopleDetector() {
+    worker_.stop();
+}
+
+void PeopleDetector::set(const PeopleParams& params) {
+    PeopleParams clamped = params;
+    clamped.detectWidth = std::max(clamped.detectWidth, 128);
+    clamped.minHeight = std::min(std::max(clamped.minHeight, 0.05f), 1.0f);
+    clamped.maxHeight = std::min(std::max(clamped.maxHeight, clamped.minHeight), 1.0f);
+    clamped.scaleStep = std::max(clamped.scaleStep, 1.05f);
+    clamped.levelsPerPass = std::max(clamped.levelsPerPass, 1);
+    clamped.stride = std::max(clamped.stride / 8, 1) * 8;   // HOG block stride
+    clamped.groupThreshold = std::max(clamped.groupThreshold, 0);
+    clamped.matchIou = std::min(std::max(clamped.matchIou, 0.05f), 1.0f);
+    clamped.smoothing = std::min(std::max(clamped.smoothing, 0.0f), 0.95f);
+    clamped.maxMissedScans = std::max(clamped.maxMissedScans, 0);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (configured_ && clamped == params_) {
+            return;
+        }
+        params_ = clamped;
+        configured_ = true;
+    }
+    reset();
+    LOGI("People detection: %d px, people %.0f-%.0f%% of the frame height, step %.2f, "
+         "%d scales per pass", clamped.detectWidth, clamped.minHeight * 100.0f,
+         clamped.maxHeight * 100.0f, clamped.scaleStep, clamped.levelsPerPass);
+}
+
+void PeopleDetector::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    status_ = PeopleStatus();
+    nextId_ = 1;
+}
+
+bool PeopleDetector::submit(const cv::Mat& luma) {
+    CV_Assert(luma.type() == CV_8UC1);
+    return worker_.submit(luma);
+}
+
+PeopleStatus PeopleDetector::status() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+}
+
+void PeopleDetector::process(const cv::Mat& luma) {
+    PeopleParams params;
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        params = params_;
+        generation = generation_;
+    }
+    scan(luma, params, generation);
+}
+
+void PeopleDetector::scan(const cv::Mat& luma, const PeopleParams& params, uint64_t generation) {
+    if (!hogReady_) {
+        hog_.setSVMDetector(cv::HOGDescriptor::getDefaultPeopleDetector());
+        hogReady_ = true;
+    }
+    const auto passStart = std::chrono::steady_clock::now();
+
+    const int width = std::min(params.detectWidth, luma.cols);
+    const cv::Size detectSize(width, std::max(cvRound(static_cast<double>(luma.rows) * width / luma.cols), 1));
+    if (detectSize == luma.size()) {
+        small_ = luma;
+    } else {
+        cv::resize(luma, small_, detectSize, 0, 0, cv::INTER_AREA);
+    }
+    const std::vector<float> scales = scaleLevels(params, detectSize, hog_.winSize);
+
+    // A reset or a new frame size abandons the scan in progress
+    if (generation != scanGeneration_ || detectSize != scanSize_) {
+        if (detectSize != scanSize_) {
+            if (scales.empty()) {
+                LOGE("People detection: %dx%d holds no %dx%d window at the requested sizes",
+                     detectSize.width, detectSize.height, hog_.winSize.width, hog_.winSize.height);
+            } else {
+                LOGI("People detection: %dx%d, %zu scales %.2f-%.2f", detectSize.width,
+                     detectSize.height, scales.size(), scales.front(), scales.back());
+            }
+        }
+        scanGeneration_ = generation;
+        scanSize_ = detectSize;
+        nextLevel_ = 0;
+        scanRects_.clear();
+        scanMs_ = 0.0;
+    }
+
+    const int first = nextLevel_;
+    const int last = std::min(first + params.levelsPerPass, static_cast<int>(scales.size()));
+    std::vector<double> levelMs;
+    for (int i = first; i < last; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        const cv::Mat* image = &small_;
+        if (scales[i] > 1.0f) {
+            cv::resize(small_, level_, cv::Size(cvRound(small_.cols / scales[i]), cvRound(small_.rows / scales[i])),
+                       0, 0, cv::INTER_LINEAR);
+            image = &level_;
+        }
+        hog_.detect(*image, found_, weights_, params.hitThreshold, cv::Size(params.stride, params.stride),
+                    cv::Size(0, 0));
+
+        const double sx = static_cast<double>(small_.cols) / image->cols;
+        const double sy = static_cast<double>(small_.rows) / image->rows;
+        for (const cv::Point& p : found_) {
+            scanRects_.emplace_back(cvRound(p.x * sx), cvRound(p.y * sy),
+                                    cvRound(hog_.winSize.width * sx), cvRound(hog_.winSize.height * sy));
+        }
+        levelMs.push_back(msSince(start));
+    }
+    nextLevel_ = last;
+
+    const bool scanDone = nextLevel_ >= static_cast<int>(scales.size());
+    std::vector<cv::Rect> detections;
+    if (scanDone) {
+        detections.swap(scanRects_);
+        cv::groupRectangles(detections, params.groupThreshold, GROUP_EPS);
+        nextLevel_ = 0;
+    }
+    const double passMs = msSince(passStart);
+    statsRecord(STAT_PEOPLE, passMs);
+    scanMs_ += passMs;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation != generation_) {
+        return;
+    }
+    if (status_.detectSize != detectSize || status_.scales != scales) {
+        status_.detectSize = detectSize;
+        status_.scales = scales;
+        status_.scaleMs.assign(scales.size(), 0.0);
+    }
+    for (size_t i = 0; i < levelMs.size(); ++i) {
+        double& average = status_.scaleMs[first + i];
+        average = average == 0.0 ? levelMs[i] : average * SCALE_MS_KEEP + levelMs[i] * (1.0 - SCALE_MS_KEEP);
+    }
+    if (!scanDone) {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (status_.scans > 0) {
+        const double interval = std::chrono::duration<double, std::milli>(now - lastScanEnd_).count();
+        status_.scanIntervalMs = status_.scanIntervalMs == 0.0 ? interval :
+                                 status_.scanIntervalMs * INTERVAL_KEEP + interval * (1.0 - INTERVAL_KEEP);
+    }
+    lastScanEnd_ = now;
+    status_.scanMs = scanMs_;
+    scanMs_ = 0.0;
+    ++status_.scans;
+    updateTracks(detections, detectSize, params);
+}
+
+void PeopleDetector::updateTracks(const std::vector<cv::Rect>& detections, cv::Size detectSize,
+                                  const PeopleParams& params) {
+    std::vector<PersonTrack>& tracks = status_.tracks;
+    std::vector<bool> matched(tracks.size(), false);
+    const float sx = 1.0f / detectSize.width;
+    const float sy = 1.0f / detectSize.height;
+    const float k = params.smoothing;
+
+    for (const cv::Rect& r : detections) {
+        const cv::Rect2f box(r.x * sx, r.y * sy, r.width * sx, r.height * sy);
+        int best = -1;
+        float bestIou = params.matchIou;
+        for (size_t i = 0; i < tracks.size(); ++i) {
+            const float iou = matched[i] ? 0.0f : overlap(tracks[i].box, box);
+            if (iou >= bestIou) {
+                bestIou = iou;
+                best = static_cast<int>(i);
+            }
+        }
+
+        if (best >= 0) {
+            PersonTrack& track = tracks[best];
+            track.box = cv::Rect2f(track.box.x * k + box.x * (1.0f - k),
+                                   track.box.y * k + box.y * (1.0f - k),
+                                   track.box.width * k + box.width * (1.0f - k),
+                                   track.box.height * k + box.height * (1.0f - k));
+            ++track.hits;
+            track.missed = 0;
+            matched[best] = true;
+        } else {
+            PersonTrack track;
+            track.id = nextId_++;
+            track.box = box;
+            track.hits = 1;
+            tracks.push_back(track);
+            matched.push_back(true);
+            ++status_.peopleSeen;
+        }
+    }
+
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        if (!matched[i]) {
+            ++tracks[i].missed;
+        }
+    }
+    tracks.erase(std::remove_if(tracks.begin(), tracks.end(), [&params](const PersonTrack& t) {
+        return t.missed > params.maxMissedScans;
+    }), tracks.end());
+}
@@ -0,0 +1,126 @@
+#ifndef PEOPLE_DETECTOR_H
+#define PEOPLE_DETECTOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/objdetect.hpp>
+#include "frame_worker.h"
+
+/**
+ * People detection and tracking for counting, with OpenCV's default HOG
+ * people detector. Implementation is in people_detector.cpp.
+ *
+ * Running detectMultiScale on full-resolution frames is far too slow for
+ * live use. This detector does less work, and does it on its own thread:
+ * - it scans a luma downscaled to detectWidth
+ * - it scans only the scales at which a person between minHeight and
+ *   maxHeight of the frame fills the 64x128 HOG window, with a coarser
+ *   step than detectMultiScale's default
+ * - one worker pass scans levelsPerPass of those scales, so a full scan
+ *   is spread over several submitted frames
+ * After each full scan the grouped detections update a set of tracks.
+ * Tracks carry stable ids and are smoothed, and they survive a few scans
+ * without a detection, so the boxes on screen neither flicker nor
+ * disappear between scans.
+ */
+struct PeopleParams {
+    int detectWidth = 640;          // Luma width the detector scans
+    float minHeight = 0.35f;        // Smallest person scanned, fraction of frame height
+    float maxHeight = 1.0f;         // Largest person scanned
+    float scaleStep = 1.2f;         // Ratio between scanned scales
+    int levelsPerPass = 2;          // Scales scanned per worker pass (one submitted frame)
+    int stride = 8;                 // Window stride, detect pixels (multiple of 8)
+    double hitThreshold = 0.0;      // SVM margin a window needs
+    int groupThreshold = 1;         // groupRectangles: a detection needs more windows than this
+    float matchIou = 0.3f;          // Overlap for a detection to continue a track
+    float smoothing = 0.5f;         // Track box EMA keep factor (0..0.95)
+    int maxMissedScans = 2;         // Scans a track survives without a detection
+
+    bool operator==(const PeopleParams& o) const {
+        return detectWidth == o.detectWidth && minHeight == o.minHeight &&
+               maxHeight == o.maxHeight && scaleStep == o.scaleStep &&
+               levelsPerPass == o.levelsPerPass && stride == o.stride &&
+               hitThreshold == o.hitThreshold && groupThreshold == o.groupThreshold &&
+               matchIou == o.matchIou && smoothing == o.smoothing &&
+               maxMissedScans == o.maxMissedScans;
+    }
+};
+
+struct PersonTrack {
+    int id = 0;
+    cv::Rect2f box;                 // Normalized frame coordinates (0..1)
+    int hits = 0;                   // Scans it was detected in
+    int missed = 0;                 // Scans since its last detection
+};
+
+/** Snapshot of the worker's state, for overlays and logs. */
+struct PeopleStatus {
+    std::vector<PersonTrack> tracks;
+    std::vector<float> scales;      // Scanned scales (person height / 128 detect pixels)
+    std::vector<double> scaleMs;    // Average scan time per scale
+    cv::Size detectSize;
+    int scans = 0;                  // Completed scans over all scales
+    int peopleSeen = 0;             // Tracks started since the last reset
+    double scanMs = 0.0;            // Compute time of the last full scan
+    double scanIntervalMs = 0.0;    // Average wall time between scans (1000 / detection rate)
+};
+
+class PeopleDetector {
+public:
+    PeopleDetector();
+    ~PeopleDetector();
+    PeopleDetector(const PeopleDetector&) = delete;
+    PeopleDetector& operator=(const PeopleDetector&) = delete;
+
+    /** A change of parameters drops the tracks. */
+    void set(const PeopleParams& params);
+
+    /** Drop tracks and the scan in progress; the worker keeps running. */
+    void reset();
+
+    /**
+     * Offer a CV_8UC1 luma frame (the NV21 Y plane works as is). Copies it
+     * and wakes the worker if the worker is idle; returns false (frame
+     * skipped) if not.
+     */
+    bool submit(const cv::Mat& luma);
+
+    PeopleStatus status() const;
+
+private:
+    void process(const cv::Mat& luma);
+    void scan(const cv::Mat& luma, const PeopleParams& params, uint64_t generation);
+    void updateTracks(const std::vector<cv::Rect>& detections, cv::Size detectSize,
+                      const PeopleParams& params);
+
+    mutable std::mutex mutex_;
+    uint64_t generation_ = 0;       // Bumped by reset(); stale work is discarded
+
+    PeopleParams params_;
+    bool configured_ = false;
+
+    PeopleStatus status_;
+    int nextId_ = 1;
+
+    // Worker-only state
+    cv::HOGDescriptor hog_;
+    bool hogReady_ = false;
+    cv::Mat small_;
+    cv::Mat level_;
+    int nextLevel_ = 0;             // First scale of the next pass
+    uint64_t scanGeneration_ = 0;   // Generation the partial scan belongs to
+    cv::Size scanSize_;             // Detect size the partial scan belongs to
+    std::vector<cv::Rect> scanRects_;   // Windows found so far this scan, detect pixels
+    double scanMs_ = 0.0;           // Compute time so far this scan
+    std::vector<cv::Point> found_;
+    std::vector<double> weights_;
+    std::chrono::steady_clock::time_point lastScanEnd_;
+
+    // Last, so it starts after and stops before the state it works on
+    FrameWorker worker_;
+};
+
+#endif // PEOPLE_DETECTOR_H
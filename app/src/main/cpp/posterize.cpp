@@ -0,0 +1,161 @@
+#include "posterize.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <android/log.h>
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+#define LOG_TAG "Posterize"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+/**
+ * posterize.cpp - Amortized k-means palette + 32^3 nearest-color lookup.
+ *
+ * Refresh: sampleCount random pixels go through cv::kmeans. After the first
+ * estimate the samples are pre-labelled with the current palette
+ * (KMEANS_USE_INITIAL_LABELS), so k-means only has to follow the scene
+ * drift: a handful of iterations, and palette entries keep their identity
+ * instead of being reshuffled by a fresh k-means++ seeding.
+ *
+ * Map: the top 5 bits of R, G and B form a 15-bit cell index into a 32 KB
+ * table of palette indices (L1-resident, like the 256-entry RGBA palette).
+ * Index computation runs on whole RGBA words with universal intrinsics;
+ * the two lookups per pixel are scalar.
+ */
+
+static const int CELL_BITS = 5;
+static const int CELLS = 1 << CELL_BITS;
+
+static inline int cellIndex(uint32_t rgba) {
+    // Little-endian RGBA word: R in bits 0-7, G in 8-15, B in 16-23
+    return static_cast<int>(((rgba >> 3) & 0x1f) << 10 | ((rgba >> 11) & 0x1f) << 5 |
+                            ((rgba >> 19) & 0x1f));
+}
+
+void Posterizer::set(const PosterizeParams& params) {
+    PosterizeParams clamped = params;
+    clamped.colors = std::min(std::max(clamped.colors, MIN_COLORS), MAX_COLORS);
+    clamped.refreshInterval = std::max(clamped.refreshInterval, 1);
+    clamped.sampleCount = std::max(clamped.sampleCount, clamped.colors * 16);
+    if (clamped == params_ && !centers_.empty()) {
+        return;
+    }
+    if (clamped.colors != params_.colors) {
+        centers_.release();
+    }
+    params_ = clamped;
+    framesUntilRefresh_ = 0;
+    LOGI("Posterize: %d colors, refresh every %d frames from %d samples",
+         params_.colors, params_.refreshInterval, params_.sampleCount);
+}
+
+void Posterizer::refresh(const cv::Mat& rgba) {
+    CV_Assert(rgba.type() == CV_8UC4);
+    const int count = params_.sampleCount;
+    const int k = params_.colors;
+    const bool warm = !centers_.empty() && centers_.rows == k && !lookup_.empty();
+
+    samples_.create(count, 3, CV_32F);
+    labels_.create(count, 1, CV_32S);
+    for (int i = 0; i < count; ++i) {
+        const int y = rng_.uniform(0, rgba.rows);
+        const int x = rng_.uniform(0, rgba.cols);
+        const uint8_t* px = rgba.ptr<uint8_t>(y) + x * 4;
+        float* sample = samples_.ptr<float>(i);
+        sample[0] = px[0];
+        sample[1] = px[1];
+        sample[2] = px[2];
+        if (warm) {
+            uint32_t word;
+            std::memcpy(&word, px, sizeof(word));
+            labels_.at<int>(i) = lookup_[cellIndex(word)];
+        }
+    }
+
+    // Warm starts only track drift; a cold start needs seeding and more rounds
+    const cv::TermCriteria criteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS,
+                                    warm ? 4 : 12, 1.0);
+    cv::kmeans(samples_, k, labels_, criteria, 1,
+               warm ? cv::KMEANS_USE_INITIAL_LABELS : cv::KMEANS_PP_CENTERS, centers_);
+
+    for (int i = 0; i < k; ++i) {
+        const float* c = centers_.ptr<float>(i);
+        const uint8_t entry[4] = {cv::saturate_cast<uint8_t>(c[0]), cv::saturate_cast<uint8_t>(c[1]),
+                                  cv::saturate_cast<uint8_t>(c[2]), 255};
+        std::memcpy(&palette_[i], entry, sizeof(entry));
+    }
+    rebuildLookup();
+
+    framesUntilRefresh_ = params_.refreshInterval;
+    ++refreshCount_;
+}
+
+void Posterizer::rebuildLookup() {
+    lookup_.resize(CELLS * CELLS * CELLS);
+    const int k = centers_.rows;
+    cv::parallel_for_(cv::Range(0, CELLS), [&](const cv::Range& range) {
+        for (int r = range.start; r < range.end; ++r) {
+            for (int g = 0; g < CELLS; ++g) {
+                for (int b = 0; b < CELLS; ++b) {
+                    // Nearest center to the middle of the cell
+                    const float cr = r * 8 + 4.0f, cg = g * 8 + 4.0f, cb = b * 8 + 4.0f;
+                    int best = 0;
+                    float bestDist = FLT_MAX;
+                    for (int i = 0; i < k; ++i) {
+                        const float* c = centers_.ptr<float>(i);
+                        const float dr = c[0] - cr, dg = c[1] - cg, db = c[2] - cb;
+                        const float dist = dr * dr + dg * dg + db * db;
+                        if (dist < bestDist) {
+                            bestDist = dist;
+                            best = i;
+                        }
+                    }
+                    lookup_[(r << 10) | (g << 5) | b] = static_cast<uint8_t>(best);
+                }
+            }
+        }
+    });
+}
+
+void Posterizer::map(cv::Mat& rgba) {
+    CV_Assert(rgba.type() == CV_8UC4);
+    --framesUntilRefresh_;
+    if (lookup_.empty()) {
+        return;
+    }
+
+    const uint8_t* lookup = lookup_.data();
+    const uint32_t* palette = palette_;
+    cv::parallel_for_(cv::Range(0, rgba.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; ++y) {
+            uint32_t* row = rgba.ptr<uint32_t>(y);
+            int x = 0;
+#if CV_SIMD
+            const int lanes = cv::VTraits<cv::v_uint32>::vlanes();
+            const cv::v_uint32 mask = cv::vx_setall_u32(0x1f);
+            uint32_t cells[cv::VTraits<cv::v_uint32>::max_nlanes];
+            for (; x <= rgba.cols - lanes; x += lanes) {
+                const cv::v_uint32 px = cv::vx_load(row + x);
+                const cv::v_uint32 cell = cv::v_or(
+                        cv::v_or(cv::v_shl<10>(cv::v_and(cv::v_shr<3>(px), mask)),
+                                 cv::v_shl<5>(cv::v_and(cv::v_shr<11>(px), mask))),
+                        cv::v_and(cv::v_shr<19>(px), mask));
+                cv::v_store(cells, cell);
+                for (int i = 0; i < lanes; ++i) {
+                    row[x + i] = palette[lookup[cells[i]]];
+                }
+            }
+#endif
+            for (; x < rgba.cols; ++x) {
+                row[x] = palette[lookup[cellIndex(row[x])]];
+            }
+        }
+    });
+}
+
+void Posterizer::apply(cv::Mat& rgba) {
+    if (refreshDue()) {
+        refresh(rgba);
+    }
+    map(rgba);
+}
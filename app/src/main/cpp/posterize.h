@@ -0,0 +1,78 @@
+#ifndef POSTERIZE_H
+#define POSTERIZE_H
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * Posterize: reduce each frame to K dominant colors.
+ * Implementation is in posterize.cpp.
+ *
+ * k-means over every pixel of every frame costs hundreds of milliseconds,
+ * so the palette is re-estimated only every refreshInterval frames, from a
+ * random subsample, starting from the previous palette (few iterations, no
+ * flicker). Between refreshes each pixel is mapped through a 32x32x32 table
+ * of nearest palette entries, which is one pass of shifts and lookups.
+ */
+struct PosterizeParams {
+    int colors = 8;                 // K, 2..64
+    int refreshInterval = 30;       // Frames between palette re-estimates
+    int sampleCount = 4096;         // Pixels fed to k-means per re-estimate
+
+    bool operator==(const PosterizeParams& o) const {
+        return colors == o.colors && refreshInterval == o.refreshInterval &&
+               sampleCount == o.sampleCount;
+    }
+};
+
+class Posterizer {
+public:
+    static constexpr int MIN_COLORS = 2;
+    static constexpr int MAX_COLORS = 64;
+
+    /** A change of K restarts the palette from scratch. */
+    void set(const PosterizeParams& params);
+    const PosterizeParams& params() const { return params_; }
+
+    /**
+     * Posterize an RGBA (CV_8UC4) image in place: refresh() when due, then
+     * map(). Callers that time the two separately use them directly.
+     */
+    void apply(cv::Mat& rgba);
+
+    /** True when the next frame should re-estimate the palette. */
+    bool refreshDue() const { return framesUntilRefresh_ <= 0 || centers_.empty(); }
+
+    /** Re-estimate the palette from a subsample of rgba and rebuild the lookup. */
+    void refresh(const cv::Mat& rgba);
+
+    /**
+     * Replace every pixel with its palette entry, in place; alpha becomes
+     * 255. Counts one frame towards the next refresh.
+     */
+    void map(cv::Mat& rgba);
+
+    /** Re-estimate on the next frame (e.g. after a scene change). */
+    void reset() { framesUntilRefresh_ = 0; }
+
+    /** Number of palette re-estimates so far (for diagnostics). */
+    uint64_t refreshCount() const { return refreshCount_; }
+
+private:
+    void rebuildLookup();
+
+    PosterizeParams params_;
+    int framesUntilRefresh_ = 0;
+    uint64_t refreshCount_ = 0;
+    cv::RNG rng_{0x5eed};
+
+    cv::Mat samples_;               // sampleCount x 3, CV_32F
+    cv::Mat labels_;                // sampleCount x 1, CV_32S
+    cv::Mat centers_;               // K x 3, CV_32F; empty until the first estimate
+
+    uint32_t palette_[MAX_COLORS] = {};         // RGBA, as stored in memory
+    std::vector<uint8_t> lookup_;               // 32^3 palette indices, r major
+};
+
+#endif // POSTERIZE_H
@@ -1,6 +1,25 @@
+#include "processor.h"
+#include "stats.h"
+#include "morphology.h"
+#include "color_mask.h"
+#include "chroma_effects.h"
+#include "luma_enhance.h"
+#include "temporal_denoise.h"
+#include "color_lut.h"
+#include "posterize.h"
+#include "recognizer.h"
+#include "panorama.h"
+#include "calibration.h"
+#include "template_matcher.h"
+#include "contour_vectors.h"
+#include "hough_detector.h"
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
 #include <android/log.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
 
 #define LOG_TAG "Processor"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -19,11 +38,63 @@
  * - Use cv::Mat wrapping pointers (no copy) where possible
  * - NV21 format: Y plane + interleaved VU (width*height + width*height/2 bytes)
  * - OpenCV conversion: COLOR_YUV2RGBA_NV21 (efficient native conversion)
+ * - When the view is smaller than the preview, downscaling is fused into the
+ *   YUV -> RGBA conversion so effects run on (and we upload) fewer pixels
+ * - Intermediates shared between stages (gray, half-scale gray, pyramid,
+ *   integral) come from a per-frame FrameContext, computed at most once
  * 
  * Processing modes:
  * 1. Passthrough: YUV -> RGBA only
- * 2. Grayscale: YUV -> RGBA -> Gray -> RGBA (4-channel for texture compatibility)
- * 3. Canny edges: YUV -> RGBA -> Gray -> Canny -> RGBA
+ * 2. Grayscale: YUV -> RGBA -> Gray -> pack
+ * 3. Canny edges: YUV -> RGBA -> Gray -> Canny -> pack
+ * 4. Thick edges: Canny edges dilated by a large rectangle (van Herk/Gil-Werman)
+ * 5. Color tracking: pixels in an HSV range keep their color, the rest go
+ *    gray, and the marker centroid is drawn. The mask is classified from
+ *    NV21 directly at chroma resolution (color_mask.cpp)
+ * 6. Posterize: K dominant colors; the palette is re-estimated every few
+ *    frames from a subsample and applied through a lookup (posterize.cpp)
+ * 7. Recognition: ORB features of a downscaled luma matched against a
+ *    reference set through an LSH index; the verified reference is outlined
+ *    and labelled (recognizer.cpp)
+ * 8. Panorama: sweep the camera left or right; each keyframe is registered
+ *    against the previous one at low resolution and its new strip warped
+ *    into a fixed-size canvas, shown downscaled across the top of the
+ *    frame (panorama.cpp)
+ * 9. Calibration: chessboard views are checked and collected on a worker
+ *    thread and calibrateCamera runs there once enough are in; the found
+ *    corners and progress are drawn (calibration.cpp)
+ * 10. Template: a known logo or fiducial is located coarse-to-fine on the
+ *    shared pyramid and tracked in a window around the last hit
+ *    (template_matcher.cpp)
+ * 11. Contours: Canny edges traced and simplified into polylines
+ *    (contour_vectors.cpp). The frame stays the camera image; the renderer
+ *    draws the polylines over it as GL line strips (processorContours)
+ * 
+ * In the Canny and contour modes, an optional Hough stage (HOUGH) finds
+ * straight lines and circles from the same edge map, restricted to a ROI
+ * and skipped while the edges have not changed (hough_detector.cpp). The
+ * renderer draws the results as GL lines (processorHough).
+ *
+ * YUV-domain stages run on the NV21 planes before conversion, in front of
+ * whichever mode is active: temporal denoise (DENOISE), color adjustments
+ * (COLOR_ADJUST: saturation, hue, tint, Y curve) and low-light enhancement
+ * (LUMA_ENHANCE: CLAHE + unsharp mask on Y). See temporal_denoise.cpp,
+ * chroma_effects.cpp and luma_enhance.cpp.
+ * 
+ * With a calibration installed (processorSetCalibration, or the calibration
+ * mode's own result), the converted frame is undistorted with cached remap
+ * tables before any mode runs. Stages that read the raw NV21 follow it: the
+ * color-track mask is remapped with the same tables, and stabilization and
+ * people detection get an undistorted luma (processorPreviewLuma).
+ * 
+ * An optional 3D LUT grade (color_lut.cpp) runs on the mode's result just
+ * before packing; gray results are expanded to RGBA first so they can pick
+ * up the grade's tint.
+ * 
+ * The final pack stage writes the mode's result (RGBA or single-channel)
+ * straight into the caller's buffer in the requested OutputFormat: RGBA8888,
+ * or RGB565 to halve upload bandwidth. Gray results pack directly to 565
+ * without being expanded to RGBA first.
  * 
  * Change PROCESSING_MODE to switch effects.
  */
@@ -32,39 +103,557 @@
 enum ProcessingMode {
     MODE_PASSTHROUGH = 0,  // No processing, just convert YUV to RGBA
     MODE_GRAYSCALE = 1,    // Grayscale effect
-    MODE_CANNY = 2         // Canny edge detection
+    MODE_CANNY = 2,        // Canny edge detection
+    MODE_THICK_EDGES = 3,  // Canny edges thickened with a large dilation
+    MODE_COLOR_TRACK = 4,  // Color splash + centroid of an HSV range
+    MODE_POSTERIZE = 5,    // Reduce to a K-color palette
+    MODE_RECOGNIZE = 6,    // Outline a known poster/product
+    MODE_PANORAMA = 7,     // Incremental sweep panorama with live preview
+    MODE_CALIBRATE = 8,    // Collect chessboard views and calibrate the camera
+    MODE_TEMPLATE = 9,     // Locate a known logo/fiducial
+    MODE_CONTOURS = 10     // Canny edges as polylines, drawn as GL lines
 };
 
 // Set desired processing mode here
 static const ProcessingMode PROCESSING_MODE = MODE_CANNY;
 
+// Structuring element for MODE_THICK_EDGES (pixels at processing resolution)
+static const int THICK_EDGE_KERNEL = 15;
+
+// Temporal denoise on NV21 ahead of every mode (before enhancement, which
+// would amplify the noise); disabled by default. E.g. {true} for Y only.
+// Keeps one history per stream (ProcessorStream).
+static const DenoiseParams DENOISE = {};
+
+// Color adjustment applied to NV21 ahead of every mode; identity skips the
+// stage. E.g. {1.4f} for more vivid color, {1.0f, 0.0f, -12, 10} for a warm tint.
+static const ColorAdjust COLOR_ADJUST = {};
+
+// Low-light enhancement on Y ahead of every mode; disabled by default.
+// E.g. {true, 2.0, 8, 0.8f, 1.0} for CLAHE on an 8x8 grid plus sharpening.
+static const LumaEnhanceParams LUMA_ENHANCE = {};
+
+// Marker color for MODE_COLOR_TRACK (OpenCV HSV units; this is saturated blue)
+static const HsvRange TRACK_RANGE = {100, 130, 120, 255, 60, 255};
+
+// MODE_POSTERIZE: 8 colors, palette re-estimated every 30 frames from 4096 pixels
+static const PosterizeParams POSTERIZE = {8, 30, 4096};
+
+// MODE_RECOGNIZE: ORB runs on the first pyramid level no wider than this
+static const int RECOGNIZE_MAX_WIDTH = 640;
+
+// Log recognition query time against the reference set size this often
+static const int RECOGNIZE_LOG_INTERVAL = 120;
+
+// MODE_PANORAMA: 320 px registration, keyframe every 20% of a frame width,
+// 4096 px canvas at half the processing resolution
+static const PanoramaParams PANORAMA = {};
+
+// MODE_CALIBRATE: 9x6 inner corners, checked at 640 px, 15 distinct views
+static const CalibrationParams CALIBRATION = {};
+
+// MODE_TEMPLATE: exhaustive search on pyramid level 3, top 3 peaks refined
+static const TemplateParams TEMPLATE = {};
+
+// MODE_CONTOURS: 1.5 px simplification, contours under 24 px dropped,
+// up to 16384 vertices in 2048 strips per frame
+static const ContourParams CONTOURS = {};
+
+// Hough lines/circles from the Canny edge map in MODE_CANNY and
+// MODE_CONTOURS; disabled by default. E.g. {true} for line segments over
+// the whole frame, {false, true, {0.25f, 0.25f, 0.5f, 0.5f}} for circles
+// in the central quarter.
+static const HoughParams HOUGH = {};
+
+// Log how often the Hough gate lets a frame through this often (frames)
+static const int HOUGH_LOG_INTERVAL = 300;
+
 // Reusable cv::Mat buffers (thread-local storage for GL thread safety)
 // These are allocated once and reused to avoid repeated allocations
-thread_local static cv::Mat yuvMat;
 thread_local static cv::Mat rgbaMat;
-thread_local static cv::Mat grayMat;
 thread_local static cv::Mat edgesMat;
-thread_local static bool initialized = false;
+thread_local static cv::Mat trackMask;
+thread_local static cv::Mat trackInverse;
+thread_local static cv::Mat trackGrayRgba;
+thread_local static ColorMask colorMask;
+thread_local static ChromaEffects chromaEffects;
+thread_local static LumaEnhancer lumaEnhancer;
+thread_local static cv::Mat undistortedMat;
+thread_local static Undistorter lumaUndistorter;
+thread_local static cv::Mat undistortedLuma;
+thread_local static ContourVectorizer contourVectorizer;
+thread_local static std::vector<uint8_t> adjustedNV21;
+
+// Derived-image cache for the frame being processed on this thread
+thread_local static FrameContext frameContext;
+
+/**
+ * Stages that carry state from one frame to the next, kept per stream.
+ */
+struct ProcessorStream {
+    bool camera = true;             // Feeds the panorama and calibration, is undistorted
+    TemporalDenoiser temporalDenoiser;
+    Posterizer posterizer;
+    Undistorter undistorter;
+    TemplateMatcher templateMatcher;
+    ContourGeometry contourGeometry;
+    HoughDetector houghDetector;
+    HoughResult houghResult;
+};
+
+// Camera preview state for frames processed without a stream
+thread_local static ProcessorStream previewStream;
+
+// Shared by all processing threads; swapped with std::atomic_store
+static std::shared_ptr<Recognizer> activeRecognizer;
+static std::shared_ptr<const TemplatePyramid> activeTemplate;
+
+// One sweep shared by all processing threads; the lock also covers
+// snapshots and resets requested from other threads
+static std::mutex panoramaMutex;
+static Panorama panorama;
+
+// Calibration worker (owns its thread) and the intrinsics in use for
+// undistortion; the latter is swapped with std::atomic_store
+static Calibrator calibrator;
+static std::shared_ptr<const CameraCalibration> activeCalibration;
 
 /**
  * Initialize reusable cv::Mat buffers.
  * 
- * Called once per thread on first frame.
- * Preallocates matrices to avoid allocation overhead on each frame.
+ * cv::Mat::create is a no-op when size and type already match, so this only
+ * allocates on the first frame and when the effective (downscaled) size changes.
  */
 static void initializeBuffers(int width, int height) {
-    if (!initialized) {
+    if (rgbaMat.cols != width || rgbaMat.rows != height) {
         LOGI("Initializing OpenCV buffers: %dx%d", width, height);
+    }
+
+    rgbaMat.create(height, width, CV_8UC4);
+    edgesMat.create(height, width, CV_8UC1);
+}
+
+void processorSetRecognizer(std::shared_ptr<Recognizer> recognizer) {
+    std::atomic_store(&activeRecognizer, std::move(recognizer));
+}
+
+void processorSetTemplate(std::shared_ptr<const TemplatePyramid> pyramid) {
+    std::atomic_store(&activeTemplate, std::move(pyramid));
+}
+
+void ProcessorStreamDeleter::operator()(ProcessorStream* stream) const {
+    delete stream;
+}
+
+ProcessorStreamPtr processorCreateStream(bool camera) {
+    ProcessorStreamPtr stream(new ProcessorStream());
+    stream->camera = camera;
+    return stream;
+}
+
+const ContourGeometry* processorContours() {
+    return PROCESSING_MODE == MODE_CONTOURS ? &previewStream.contourGeometry : nullptr;
+}
+
+const HoughResult* processorHough() {
+    const bool edgeMode = PROCESSING_MODE == MODE_CANNY || PROCESSING_MODE == MODE_CONTOURS;
+    return edgeMode && HOUGH.enabled() ? &previewStream.houghResult : nullptr;
+}
+
+/**
+ * Hough stage on this frame's Canny output (edgesMat). Circles vote on the
+ * cached gray image; STAT_HOUGH includes gated frames, so its average is
+ * the real per-frame cost.
+ */
+static void runHough(ProcessorStream& stream, const cv::Mat& edges) {
+    HoughDetector& houghDetector = stream.houghDetector;
+    HoughResult& houghResult = stream.houghResult;
+    {
+        ScopedStatTimer houghTimer(STAT_HOUGH);
+        houghDetector.set(HOUGH);
+        cv::Mat gray;
+        if (HOUGH.circles) {
+            gray = HOUGH.circlesHalfRes ? frameContext.grayHalf() : frameContext.gray();
+        }
+        houghDetector.detect(edges, gray, houghResult);
+    }
+    if (houghDetector.frames() % HOUGH_LOG_INTERVAL == 0) {
+        LOGI("Hough: transforms ran on %llu of %llu frames, %.2f ms per frame, %zu lines, %zu circles",
+             static_cast<unsigned long long>(houghDetector.runs()),
+             static_cast<unsigned long long>(houghDetector.frames()), statsAverageMs(STAT_HOUGH),
+             houghResult.lines.size(), houghResult.circles.size());
+    }
+}
+
+void processorResetPanorama() {
+    std::lock_guard<std::mutex> lock(panoramaMutex);
+    panorama.reset();
+}
+
+bool processorPanoramaSnapshot(cv::Mat& out) {
+    std::lock_guard<std::mutex> lock(panoramaMutex);
+    return panorama.snapshot(out);
+}
+
+void processorResetCalibration() {
+    calibrator.reset();
+}
+
+void processorSetCalibration(std::shared_ptr<const CameraCalibration> calibration) {
+    std::atomic_store(&activeCalibration, std::move(calibration));
+}
+
+std::shared_ptr<const CameraCalibration> processorCalibration() {
+    return std::atomic_load(&activeCalibration);
+}
+
+/**
+ * Intrinsics to undistort the camera preview with, or nullptr: none are
+ * installed, or the calibration mode is still collecting views of the raw
+ * lens.
+ */
+static std::shared_ptr<const CameraCalibration> undistortCalibration() {
+    std::shared_ptr<const CameraCalibration> calibration = std::atomic_load(&activeCalibration);
+    if (PROCESSING_MODE == MODE_CALIBRATE && !calibrator.result()) {
+        return nullptr;
+    }
+    return calibration;
+}
+
+cv::Mat processorPreviewLuma(const uint8_t* nv21Data, int width, int height) {
+    const cv::Mat luma(height, width, CV_8UC1, const_cast<uint8_t*>(nv21Data));
+    const std::shared_ptr<const CameraCalibration> calibration = undistortCalibration();
+    if (!calibration) {
+        return luma;
+    }
+    // Own maps: these are built for the full-resolution frame
+    ScopedStatTimer timer(STAT_UNDISTORT);
+    lumaUndistorter.set(calibration);
+    lumaUndistorter.apply(luma, undistortedLuma);
+    return undistortedLuma;
+}
+
+int processorMaxDownscale() {
+    switch (PROCESSING_MODE) {
+        case MODE_CANNY:
+        case MODE_THICK_EDGES:
+        case MODE_CONTOURS:
+            // Canny thresholds are tuned for full-resolution gradients;
+            // beyond 2x fine edges disappear.
+            return 2;
+        case MODE_RECOGNIZE:
+        case MODE_PANORAMA:
+            // ORB needs corners; both modes pick their own pyramid level
+            return 2;
+        case MODE_TEMPLATE:
+            // The template is cut at camera resolution; finer refinement
+            // levels are lost with every halving
+            return 2;
+        case MODE_PASSTHROUGH:
+        case MODE_GRAYSCALE:
+        case MODE_COLOR_TRACK:
+        case MODE_POSTERIZE:
+        case MODE_CALIBRATE:    // Checks the full-resolution Y plane itself
+        default:
+            return 8;
+    }
+}
+
+int processorChooseDownscale(int width, int height, int viewWidth, int viewHeight) {
+    if (viewWidth <= 0 || viewHeight <= 0) {
+        return 1;
+    }
+
+    const int maxFactor = processorMaxDownscale();
+    int factor = 1;
+    while (factor * 2 <= maxFactor) {
+        const int next = factor * 2;
+        if (width % next != 0 || height % next != 0) break;
+        if (width / next < viewWidth || height / next < viewHeight) break;
+        factor = next;
+    }
+    return factor;
+}
+
+static inline uint8_t clampToByte(int v) {
+    return static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline int log2Pow2(int v) {
+    int shift = 0;
+    while ((1 << shift) < v) shift++;
+    return shift;
+}
+
+/**
+ * NV21 -> RGBA with a box-filter downscale in the same pass.
+ *
+ * Each output pixel averages a factor x factor block of Y and the
+ * (factor/2) x (factor/2) VU samples covering it, then applies the same
+ * BT.601 video-range conversion (20-bit fixed point) as COLOR_YUV2RGBA_NV21.
+ * Reads every input byte once and writes only the reduced output.
+ *
+ * @param factor Power-of-two decimation factor, >= 2
+ */
+static void convertNV21ToRGBADownscaled(const uint8_t* nv21Data, int width, int height,
+                                        int factor, cv::Mat& rgbaOut) {
+    // ITU-R BT.601 coefficients scaled by 2^20 (matches OpenCV's cvtColor)
+    constexpr int kShift = 20;
+    constexpr int kCY  = 1220542;   // 1.164
+    constexpr int kCRV = 1673527;   // 1.596
+    constexpr int kCGV = -852492;   // -0.813
+    constexpr int kCGU = -409993;   // -0.391
+    constexpr int kCBU = 2116026;   // 2.018
+    constexpr int kRound = 1 << (kShift - 1);
+
+    const int outWidth = width / factor;
+    const int outHeight = height / factor;
+    const int chromaFactor = factor / 2;
+    const int yShift = 2 * log2Pow2(factor);
+    const int cShift = 2 * log2Pow2(chromaFactor);
+    const uint8_t* vuPlane = nv21Data + static_cast<size_t>(width) * height;
+
+    cv::parallel_for_(cv::Range(0, outHeight), [&](const cv::Range& range) {
+        for (int oy = range.start; oy < range.end; ++oy) {
+            const uint8_t* yBlock = nv21Data + static_cast<size_t>(oy) * factor * width;
+            const uint8_t* vuBlock = vuPlane + static_cast<size_t>(oy) * chromaFactor * width;
+            uint8_t* dst = rgbaOut.ptr<uint8_t>(oy);
+
+            for (int ox = 0; ox < outWidth; ++ox) {
+                int ySum = 0;
+                for (int dy = 0; dy < factor; ++dy) {
+                    const uint8_t* yRow = yBlock + dy * width + ox * factor;
+                    for (int dx = 0; dx < factor; ++dx) {
+                        ySum += yRow[dx];
+                    }
+                }
+
+                int vSum = 0;
+                int uSum = 0;
+                for (int dy = 0; dy < chromaFactor; ++dy) {
+                    const uint8_t* vuRow = vuBlock + dy * width + ox * chromaFactor * 2;
+                    for (int dx = 0; dx < chromaFactor; ++dx) {
+                        vSum += vuRow[2 * dx];
+                        uSum += vuRow[2 * dx + 1];
+                    }
+                }
+
+                const int y = std::max(0, (ySum >> yShift) - 16) * kCY;
+                const int v = (vSum >> cShift) - 128;
+                const int u = (uSum >> cShift) - 128;
+
+                dst[0] = clampToByte((y + kCRV * v + kRound) >> kShift);
+                dst[1] = clampToByte((y + kCGV * v + kCGU * u + kRound) >> kShift);
+                dst[2] = clampToByte((y + kCBU * u + kRound) >> kShift);
+                dst[3] = 255;
+                dst += 4;
+            }
+        }
+    });
+}
+
+static double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Point a derived Mat at pooled storage, or give it its own allocation when
+ * the pool is exhausted (already counted by the pool's stats).
+ */
+static void bindStorage(cv::Mat& mat, int rows, int cols, int type, uint8_t* data) {
+    if (data != nullptr) {
+        mat = cv::Mat(rows, cols, type, data);
+    } else {
+        mat.create(rows, cols, type);
+    }
+}
+
+void FrameContext::begin(const cv::Mat& rgba) {
+    for (FrameHandle& handle : handles_) {
+        handle.reset();
+    }
+    gray_.release();
+    grayHalf_.release();
+    for (cv::Mat& level : pyramid_) {
+        level.release();
+    }
+    integral_.release();
+    pyramidLevels_ = 0;
+    rgba_ = rgba;
+
+    // Pools only grow, so alternating stream sizes (compositing) never
+    // reallocate. Three 8-bit slots: gray, half gray, packed pyramid levels.
+    const size_t pixels = static_cast<size_t>(rgba.cols) * rgba.rows;
+    if (!bytePool_ || bytePool_->bufferBytes() < pixels) {
+        bytePool_.reset(new FramePool(pixels, 3, POOL_DERIVED));
+    }
+    const size_t integralBytes = static_cast<size_t>(rgba.cols + 1) * (rgba.rows + 1) * sizeof(int32_t);
+    if (!widePool_ || widePool_->bufferBytes() < integralBytes) {
+        widePool_.reset(new FramePool(integralBytes, 1, POOL_DERIVED_WIDE));
+    }
+}
+
+uint8_t* FrameContext::storage(Slot slot, size_t bytes) {
+    FrameHandle& handle = handles_[slot];
+    if (!handle) {
+        handle = (slot == SLOT_INTEGRAL ? widePool_ : bytePool_)->acquire();
+    }
+    return handle && handle->capacity >= bytes ? handle->data : nullptr;
+}
+
+const cv::Mat& FrameContext::gray() {
+    if (!gray_.empty()) {
+        statsCacheHit(CACHE_GRAY);
+        return gray_;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    bindStorage(gray_, height(), width(), CV_8UC1,
+                storage(SLOT_GRAY, static_cast<size_t>(width()) * height()));
+    cv::cvtColor(rgba_, gray_, cv::COLOR_RGBA2GRAY);
+    statsCacheMiss(CACHE_GRAY, msSince(start));
+    return gray_;
+}
+
+const cv::Mat& FrameContext::grayHalf() {
+    if (!grayHalf_.empty()) {
+        statsCacheHit(CACHE_GRAY_HALF);
+        return grayHalf_;
+    }
+
+    const cv::Mat& src = gray();
+    const auto start = std::chrono::steady_clock::now();
+    const int halfWidth = src.cols / 2;
+    const int halfHeight = src.rows / 2;
+    bindStorage(grayHalf_, halfHeight, halfWidth, CV_8UC1,
+                storage(SLOT_GRAY_HALF, static_cast<size_t>(halfWidth) * halfHeight));
+    cv::resize(src, grayHalf_, grayHalf_.size(), 0, 0, cv::INTER_AREA);
+    statsCacheMiss(CACHE_GRAY_HALF, msSince(start));
+    return grayHalf_;
+}
+
+const cv::Mat& FrameContext::pyramid(int level) {
+    level = std::min(std::max(level, 0), MAX_PYRAMID_LEVELS);
+    if (level == 0) {
+        return gray();
+    }
+    if (level <= pyramidLevels_) {
+        statsCacheHit(CACHE_PYRAMID);
+        return pyramid_[level];
+    }
 
-        // Preallocate matrices
-        // NV21 format: height + height/2 rows, 1 channel (Y + UV interleaved)
-        yuvMat = cv::Mat(height + height / 2, width, CV_8UC1);
-        rgbaMat = cv::Mat(height, width, CV_8UC4);
-        grayMat = cv::Mat(height, width, CV_8UC1);
-        edgesMat = cv::Mat(height, width, CV_8UC1);
+    // Levels 1..N share one pooled buffer, packed back to back
+    cv::Size sizes[MAX_PYRAMID_LEVELS + 1];
+    size_t offsets[MAX_PYRAMID_LEVELS + 1] = {};
+    sizes[0] = cv::Size(width(), height());
+    size_t total = 0;
+    for (int i = 1; i <= MAX_PYRAMID_LEVELS; ++i) {
+        sizes[i] = cv::Size((sizes[i - 1].width + 1) / 2, (sizes[i - 1].height + 1) / 2);
+        offsets[i] = total;
+        total += static_cast<size_t>(sizes[i].area());
+    }
+    uint8_t* base = storage(SLOT_PYRAMID, total);
+
+    for (int i = pyramidLevels_ + 1; i <= level; ++i) {
+        const cv::Mat& src = i == 1 ? gray() : pyramid_[i - 1];
+        const auto start = std::chrono::steady_clock::now();
+        bindStorage(pyramid_[i], sizes[i].height, sizes[i].width, CV_8UC1,
+                    base != nullptr ? base + offsets[i] : nullptr);
+        cv::pyrDown(src, pyramid_[i], sizes[i]);
+        pyramidLevels_ = i;
+        statsCacheMiss(CACHE_PYRAMID, msSince(start));
+    }
+    return pyramid_[level];
+}
+
+const cv::Mat& FrameContext::integral() {
+    if (!integral_.empty()) {
+        statsCacheHit(CACHE_INTEGRAL);
+        return integral_;
+    }
+
+    const cv::Mat& src = gray();
+    const auto start = std::chrono::steady_clock::now();
+    bindStorage(integral_, src.rows + 1, src.cols + 1, CV_32S,
+                storage(SLOT_INTEGRAL, static_cast<size_t>(src.rows + 1) * (src.cols + 1) * sizeof(int32_t)));
+    cv::integral(src, integral_, CV_32S);
+    statsCacheMiss(CACHE_INTEGRAL, msSince(start));
+    return integral_;
+}
+
+/**
+ * YUV-domain stages: denoise, color adjust, luma enhance.
+ *
+ * The input frame is shared and read-only, so the first active stage writes
+ * a private copy and the rest work on it in place. Returns the frame the
+ * rest of the pipeline should read (the input itself when all are off).
+ */
+static const uint8_t* preprocessYUV(ProcessorStream& stream, const uint8_t* nv21Data,
+                                    int width, int height) {
+    TemporalDenoiser& temporalDenoiser = stream.temporalDenoiser;
+    temporalDenoiser.set(DENOISE);
+    chromaEffects.set(COLOR_ADJUST);
+    lumaEnhancer.set(LUMA_ENHANCE);
+    const bool denoise = temporalDenoiser.enabled();
+    const bool adjust = !chromaEffects.isIdentity();
+    const bool enhance = lumaEnhancer.enabled();
+    if (!denoise && !adjust && !enhance) {
+        return nv21Data;
+    }
 
-        initialized = true;
-        LOGI("OpenCV buffers initialized");
+    const size_t lumaSize = static_cast<size_t>(width) * height;
+    adjustedNV21.resize(lumaSize * 3 / 2);
+    uint8_t* work = adjustedNV21.data();
+    const uint8_t* src = nv21Data;
+
+    if (denoise) {
+        ScopedStatTimer timer(STAT_DENOISE);
+        temporalDenoiser.apply(src, work, width, height);
+        src = work;
+    }
+
+    if (adjust || enhance) {
+        ScopedStatTimer timer(STAT_ENHANCE);
+        if (adjust) {
+            chromaEffects.apply(src, work, width, height);
+            src = work;
+        }
+        if (enhance) {
+            // Y only; carry VU over if nothing has copied it yet
+            lumaEnhancer.apply(src, work, width, height);
+            if (src != work) {
+                std::memcpy(work + lumaSize, src + lumaSize, lumaSize / 2);
+            }
+        }
+    }
+    return work;
+}
+
+/**
+ * Final pack stage: write a mode result into the output buffer.
+ *
+ * Accepts RGBA (CV_8UC4) or single-channel (CV_8UC1) results. Both cvtColor
+ * 565 packers are SIMD-vectorized in OpenCV and write through the wrapping
+ * Mat with no intermediate copy. OpenCV's "BGR565" with RGBA input places R
+ * in the high 5 bits, which is the GL_UNSIGNED_SHORT_5_6_5 layout.
+ */
+static void packOutput(const cv::Mat& result, OutputFormat format, uint8_t* pixelsOut) {
+    if (format == OUTPUT_RGB565) {
+        cv::Mat out565(result.rows, result.cols, CV_8UC2, pixelsOut);
+        cv::cvtColor(result, out565, result.channels() == 1 ?
+                                     cv::COLOR_GRAY2BGR565 : cv::COLOR_RGBA2BGR565);
+    } else {
+        if (result.data == pixelsOut) {
+            // Converted in place into the output buffer; nothing to pack
+            return;
+        }
+        cv::Mat outRgba(result.rows, result.cols, CV_8UC4, pixelsOut);
+        if (result.channels() == 1) {
+            cv::cvtColor(result, outRgba, cv::COLOR_GRAY2RGBA);
+        } else {
+            result.copyTo(outRgba);
+        }
     }
 }
 
@@ -76,7 +665,11 @@ static void initializeBuffers(int width, int height) {
  * @param nv21Data Input NV21 YUV data from camera
  * @param width Frame width
  * @param height Frame height
- * @param rgbaOut Output RGBA buffer (must be preallocated: width*height*4 bytes)
+ * @param pixelsOut Output buffer (must be preallocated: width*height*4 bytes)
+ * @param downscale Power-of-two decimation factor; output is
+ *                  (width/downscale) x (height/downscale)
+ * @param format Output pixel format (RGBA8888 or RGB565)
+ * @param grade Optional 3D LUT applied before packing (nullptr = none)
  * 
  * NV21 format layout:
  * - Bytes 0 to (width*height-1): Y plane (luminance)
@@ -87,51 +680,310 @@ static void initializeBuffers(int width, int height) {
  * - Reuses preallocated intermediate buffers
  * - cvtColor uses optimized SIMD implementations when available
  */
-void processFrame(const uint8_t* nv21Data, int width, int height, uint8_t* rgbaOut) {
-    // Initialize buffers on first call
-    initializeBuffers(width, height);
+void processFrame(const uint8_t* nv21Data, int width, int height, uint8_t* pixelsOut,
+                  int downscale, OutputFormat format, const ColorLut3D* grade,
+                  ProcessorStream* stream) {
+    ScopedStatTimer timer(STAT_PROCESS);
+    ProcessorStream& state = stream != nullptr ? *stream : previewStream;
+
+    const int outWidth = width / downscale;
+    const int outHeight = height / downscale;
+
+    // Initialize buffers on first call (and on effective size change)
+    initializeBuffers(outWidth, outHeight);
 
     try {
-        // Wrap NV21 data in cv::Mat (no copy)
-        // NV21 is stored as: height rows of Y + height/2 rows of interleaved VU
-        cv::Mat yuvInput(height + height / 2, width, CV_8UC1, (void*)nv21Data);
+        nv21Data = preprocessYUV(state, nv21Data, width, height);
+
+        // Undistort before any mode sees the frame
+        const std::shared_ptr<const CameraCalibration> calibration = undistortCalibration();
+        const bool undistort = calibration && state.camera;
+
+        // For RGBA output the working frame is the caller's buffer, so
+        // passthrough needs no copy; effects read it before overwriting it.
+        // With undistortion the conversion goes to scratch and the remap
+        // writes the working frame.
+        cv::Mat outputView;
+        if (format == OUTPUT_RGBA8888) {
+            outputView = cv::Mat(outHeight, outWidth, CV_8UC4, pixelsOut);
+        }
+        cv::Mat& frame = format == OUTPUT_RGBA8888 ? outputView : undistortedMat;
+        cv::Mat rgba = undistort || format != OUTPUT_RGBA8888 ? rgbaMat : frame;
 
-        // Convert NV21 to RGBA
-        // COLOR_YUV2RGBA_NV21: Y plane followed by VU interleaved
-        cv::cvtColor(yuvInput, rgbaMat, cv::COLOR_YUV2RGBA_NV21);
+        if (downscale > 1) {
+            // Downscale and convert in a single pass over the input
+            convertNV21ToRGBADownscaled(nv21Data, width, height, downscale, rgba);
+        } else {
+            // Wrap NV21 data in cv::Mat (no copy)
+            // NV21 is stored as: height rows of Y + height/2 rows of interleaved VU
+            cv::Mat yuvInput(height + height / 2, width, CV_8UC1, (void*)nv21Data);
+
+            // Convert NV21 to RGBA
+            // COLOR_YUV2RGBA_NV21: Y plane followed by VU interleaved
+            cv::cvtColor(yuvInput, rgba, cv::COLOR_YUV2RGBA_NV21);
+        }
+
+        if (undistort) {
+            ScopedStatTimer undistortTimer(STAT_UNDISTORT);
+            state.undistorter.set(calibration);
+            state.undistorter.apply(rgba, frame);
+            rgba = frame;
+        }
+
+        // Shared intermediates for this frame's stages
+        frameContext.begin(rgba);
 
         // Apply processing based on mode
+        const cv::Mat* result = &rgba;
         switch (PROCESSING_MODE) {
             case MODE_PASSTHROUGH:
-                // No additional processing, rgbaMat is ready
+                // No additional processing, rgba is ready
                 break;
 
             case MODE_GRAYSCALE: {
-                // Convert to grayscale and back to RGBA (for 4-channel texture)
-                cv::cvtColor(rgbaMat, grayMat, cv::COLOR_RGBA2GRAY);
-                cv::cvtColor(grayMat, rgbaMat, cv::COLOR_GRAY2RGBA);
+                // Grayscale; the pack stage expands it
+                result = &frameContext.gray();
                 break;
             }
 
             case MODE_CANNY: {
                 // Canny edge detection
-                // 1. Convert to grayscale
-                cv::cvtColor(rgbaMat, grayMat, cv::COLOR_RGBA2GRAY);
+                // 1. Grayscale (shared with any other stage this frame)
+                const cv::Mat& gray = frameContext.gray();
 
                 // 2. Apply Canny edge detector
                 // Parameters: low threshold = 80, high threshold = 160
                 // Lower thresholds = more edges, higher = fewer edges
-                cv::Canny(grayMat, edgesMat, 80, 160);
+                cv::Canny(gray, edgesMat, 80, 160);
+                if (HOUGH.enabled()) {
+                    runHough(state, edgesMat);
+                }
+
+                // 3. Edges are white on black; the pack stage expands them
+                result = &edgesMat;
+                break;
+            }
+
+            case MODE_THICK_EDGES: {
+                cv::Canny(frameContext.gray(), edgesMat, 80, 160);
+
+                // Constant cost per pixel regardless of kernel size
+                morphRect(edgesMat, edgesMat, cv::Size(THICK_EDGE_KERNEL, THICK_EDGE_KERNEL),
+                          MORPH_OP_DILATE);
+                result = &edgesMat;
+                break;
+            }
+
+            case MODE_COLOR_TRACK: {
+                // Classify from NV21 at chroma resolution; resampled only when
+                // the processing size is not already half the frame
+                colorMask.setRange(TRACK_RANGE);
+                colorMask.compute(nv21Data, width, height, rgba.size(), trackMask);
+                if (undistort) {
+                    // The mask comes from the raw NV21; bring it into the
+                    // undistorted frame's geometry (same maps, same size)
+                    ScopedStatTimer undistortTimer(STAT_UNDISTORT);
+                    state.undistorter.apply(trackMask, trackInverse);
+                    std::swap(trackMask, trackInverse);
+                }
+
+                // Everything outside the range goes gray
+                cv::bitwise_not(trackMask, trackInverse);
+                cv::cvtColor(frameContext.gray(), trackGrayRgba, cv::COLOR_GRAY2RGBA);
+                trackGrayRgba.copyTo(rgba, trackInverse);
+
+                const cv::Moments m = cv::moments(trackMask, true);
+                if (m.m00 > 0) {
+                    const cv::Point center(cvRound(m.m10 / m.m00), cvRound(m.m01 / m.m00));
+                    cv::circle(rgba, center, 12, cv::Scalar(255, 0, 0, 255), 2);
+                }
+                break;
+            }
+
+            case MODE_POSTERIZE: {
+                // Timed separately: the mapping runs every frame, the
+                // k-means re-estimate only every refreshInterval frames
+                state.posterizer.set(POSTERIZE);
+                if (state.posterizer.refreshDue()) {
+                    ScopedStatTimer reclusterTimer(STAT_RECLUSTER);
+                    state.posterizer.refresh(rgba);
+                }
+                ScopedStatTimer posterizeTimer(STAT_POSTERIZE);
+                state.posterizer.map(rgba);
+                break;
+            }
+
+            case MODE_RECOGNIZE: {
+                const std::shared_ptr<Recognizer> recognizer = std::atomic_load(&activeRecognizer);
+                if (!recognizer) {
+                    break;
+                }
+
+                // Downscaled luma from the shared pyramid
+                int level = 0;
+                while (level < FrameContext::MAX_PYRAMID_LEVELS &&
+                       (rgba.cols >> level) > RECOGNIZE_MAX_WIDTH) {
+                    ++level;
+                }
+                const cv::Mat& luma = frameContext.pyramid(level);
+
+                Recognition match;
+                bool found;
+                {
+                    ScopedStatTimer recognizeTimer(STAT_RECOGNIZE);
+                    found = recognizer->recognize(luma, match);
+                }
+                thread_local static int queries = 0;
+                if (++queries % RECOGNIZE_LOG_INTERVAL == 0) {
+                    LOGI("Recognition: %.1f ms per query, %d references / %zu features",
+                         statsAverageMs(STAT_RECOGNIZE), recognizer->referenceCount(),
+                         recognizer->featureCount());
+                }
+
+                if (found) {
+                    const float scale = static_cast<float>(rgba.cols) / luma.cols;
+                    std::vector<cv::Point> outline;
+                    for (const cv::Point2f& corner : match.corners) {
+                        outline.emplace_back(cvRound(corner.x * scale), cvRound(corner.y * scale));
+                    }
+                    cv::polylines(rgba, outline, true, cv::Scalar(0, 255, 0, 255), 3);
+                    cv::putText(rgba, match.name, outline[0] + cv::Point(4, -8),
+                                cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(0, 255, 0, 255), 2);
+                }
+                break;
+            }
+
+            case MODE_PANORAMA: {
+                if (!state.camera) {
+                    break;
+                }
+                std::lock_guard<std::mutex> lock(panoramaMutex);
+                panorama.set(PANORAMA);
+                if (panorama.registrationDue()) {
+                    int level = 0;
+                    while (level < FrameContext::MAX_PYRAMID_LEVELS &&
+                           (rgba.cols >> level) > PANORAMA.registerWidth) {
+                        ++level;
+                    }
+
+                    PanoramaStep step;
+                    {
+                        ScopedStatTimer registerTimer(STAT_PANO_REGISTER);
+                        step = panorama.track(frameContext.pyramid(level));
+                    }
+                    if (step == PANORAMA_KEYFRAME) {
+                        {
+                            ScopedStatTimer warpTimer(STAT_PANO_WARP);
+                            panorama.stitch(rgba);
+                        }
+                        LOGI("Panorama keyframe %d: %d inliers, register %.1f ms (avg %.1f), "
+                             "warp %.1f ms", panorama.keyframeCount(), panorama.lastInliers(),
+                             statsLastMs(STAT_PANO_REGISTER), statsAverageMs(STAT_PANO_REGISTER),
+                             statsLastMs(STAT_PANO_WARP));
+                    }
+                } else {
+                    panorama.skipFrame();
+                }
+                panorama.drawPreview(rgba);
+                break;
+            }
 
-                // 3. Convert back to RGBA (edges are white on black)
-                cv::cvtColor(edgesMat, rgbaMat, cv::COLOR_GRAY2RGBA);
+            case MODE_CALIBRATE: {
+                if (!state.camera) {
+                    break;
+                }
+                // The worker takes a copy of the full-resolution Y plane when
+                // it is idle; otherwise this frame is simply not checked
+                calibrator.set(CALIBRATION);
+                calibrator.submit(cv::Mat(height, width, CV_8UC1, const_cast<uint8_t*>(nv21Data)));
+
+                const CalibrationStatus status = calibrator.status();
+                char text[64];
+                if (status.state == CALIBRATION_DONE) {
+                    std::shared_ptr<const CameraCalibration> result = calibrator.result();
+                    if (result && result != calibration) {
+                        processorSetCalibration(std::move(result));
+                    }
+                    std::snprintf(text, sizeof(text), "Calibrated: RMS %.2f px", status.rms);
+                } else if (status.state == CALIBRATION_SOLVING) {
+                    std::snprintf(text, sizeof(text), "Calibrating (%d views)...", status.views);
+                } else {
+                    std::snprintf(text, sizeof(text), "Views %d/%d", status.views, status.viewsNeeded);
+                    if (status.boardFound && status.frameSize.width > 0) {
+                        const float scale = static_cast<float>(rgba.cols) / status.frameSize.width;
+                        std::vector<cv::Point2f> corners(status.corners);
+                        for (cv::Point2f& p : corners) {
+                            p *= scale;
+                        }
+                        cv::drawChessboardCorners(rgba, CALIBRATION.boardSize, corners, true);
+                    }
+                }
+                cv::putText(rgba, text, cv::Point(16, 40), cv::FONT_HERSHEY_SIMPLEX, 1.0,
+                            cv::Scalar(255, 255, 0, 255), 2);
+                break;
+            }
+
+            case MODE_CONTOURS: {
+                // Edges leave as geometry; the frame itself stays the camera
+                // image and the renderer draws the lines over it
+                {
+                    ScopedStatTimer contoursTimer(STAT_CONTOURS);
+                    state.contourGeometry.clear();
+                    cv::Canny(frameContext.gray(), edgesMat, 80, 160);
+                    contourVectorizer.set(CONTOURS);
+                    contourVectorizer.extract(edgesMat, state.contourGeometry);
+                }
+                // Timed on its own ("hough"), not as part of "contours"
+                if (HOUGH.enabled()) {
+                    runHough(state, edgesMat);
+                }
+                break;
+            }
+
+            case MODE_TEMPLATE: {
+                state.templateMatcher.set(TEMPLATE);
+                state.templateMatcher.setTemplate(std::atomic_load(&activeTemplate));
+                const int shift = log2Pow2(downscale);
+                const int coarse = state.templateMatcher.coarseLevel(rgba.size(), shift);
+                if (coarse < 0) {
+                    break;
+                }
+
+                // Levels up to the coarse one come from the shared pyramid
+                cv::Mat levels[FrameContext::MAX_PYRAMID_LEVELS + 1];
+                const int levelCount = std::min(coarse, FrameContext::MAX_PYRAMID_LEVELS) + 1;
+                for (int i = 0; i < levelCount; ++i) {
+                    levels[i] = frameContext.pyramid(i);
+                }
+
+                TemplateMatch hit;
+                bool found;
+                {
+                    ScopedStatTimer templateTimer(STAT_TEMPLATE);
+                    found = state.templateMatcher.match(levels, levelCount, shift, hit);
+                }
+                if (found) {
+                    char text[64];
+                    std::snprintf(text, sizeof(text), "%.2f%s", hit.score, hit.tracked ? "" : " (search)");
+                    cv::rectangle(rgba, hit.box, cv::Scalar(0, 255, 0, 255), 3);
+                    cv::putText(rgba, text, hit.box.tl() + cv::Point(4, -8),
+                                cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(0, 255, 0, 255), 2);
+                }
                 break;
             }
         }
 
-        // Copy result to output buffer
-        // rgbaMat.data points to RGBA pixels (width*height*4 bytes)
-        std::memcpy(rgbaOut, rgbaMat.data, width * height * 4);
+        if (grade) {
+            ScopedStatTimer gradeTimer(STAT_GRADE);
+            if (result->channels() == 1) {
+                cv::cvtColor(*result, rgba, cv::COLOR_GRAY2RGBA);
+                result = &rgba;
+            }
+            applyColorLut(*grade, rgba);
+        }
+
+        // Pack result into the output buffer in the requested format
+        packOutput(*result, format, pixelsOut);
 
     } catch (const cv::Exception& e) {
         LOGE("OpenCV exception: %s", e.what());
@@ -203,15 +1055,37 @@ void detectFaces(cv::Mat& input, std::vector<cv::Rect>& faces) {
  *    - MODE_PASSTHROUGH is fastest (just YUV conversion)
  *    - MODE_GRAYSCALE adds one extra conversion
  *    - MODE_CANNY adds grayscale + Canny (more expensive)
+ *    - MODE_THICK_EDGES adds one dilation on top of Canny; its cost does not
+ *      depend on THICK_EDGE_KERNEL
+ *    - MODE_POSTERIZE adds one lookup pass per frame, plus a small k-means
+ *      every POSTERIZE.refreshInterval frames ("posterize" and "recluster"
+ *      in the stats log)
+ *    - MODE_PANORAMA registers every PANORAMA.registerInterval frames at
+ *      low resolution ("pano-register") and warps one strip per keyframe
+ *      ("pano-warp"); the canvas is allocated once
+ *    - MODE_CALIBRATE does its board checks on a worker thread
+ *      ("calib-check"); the frame path only copies the Y plane when the
+ *      worker is idle
+ *    - An installed calibration costs one remap pass ("undistort"), plus
+ *      one of the mask in MODE_COLOR_TRACK and one of the full-resolution
+ *      luma while stabilization or people detection is on
+ *    - MODE_TEMPLATE searches exhaustively only on a coarse pyramid level,
+ *      and only near the last hit while tracking ("template")
+ *    - MODE_CONTOURS adds contour tracing and simplification to Canny
+ *      ("contours") but uploads only the vertices, a few tens of KB,
+ *      next to the camera frame ("contour-upload", "gpu-lines")
+ *    - HOUGH restricts the transforms to its ROI and skips them while the
+ *      edge map is unchanged; "hough" averages over all frames, gated ones
+ *      included
  * 
  * 3. Optimize Canny parameters:
  *    - Higher thresholds = fewer edges = faster
  *    - cv::Canny(input, output, 100, 200) vs (50, 150)
  * 
- * 4. Use cv::resize() to downsample before processing:
- *    cv::resize(input, smaller, cv::Size(width/2, height/2));
- *    // Process smaller image
- *    cv::resize(result, output, cv::Size(width, height));
+ * 4. Downsample before processing:
+ *    The renderer already passes a downscale factor derived from the
+ *    viewport size (capped by processorMaxDownscale()), so small views
+ *    (picture-in-picture, split screen) process fewer pixels automatically.
  * 
  * 5. Skip frames if FPS too low:
  *    static int frameCounter = 0;
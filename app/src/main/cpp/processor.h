@@ -0,0 +1,210 @@
+#ifndef PROCESSOR_H
+#define PROCESSOR_H
+
+#include <cstdint>
+#include <memory>
+#include <opencv2/core.hpp>
+#include "frame_pool.h"
+
+struct ColorLut3D;
+struct CameraCalibration;
+class Recognizer;
+struct TemplatePyramid;
+struct ContourGeometry;
+struct HoughResult;
+
+/**
+ * Processor API declaration.
+ * Implementation is in processor.cpp.
+ */
+
+/**
+ * Pixel format written by processFrame() and uploaded by the renderer.
+ */
+enum OutputFormat {
+    OUTPUT_RGBA8888 = 0,   // GL_RGBA / GL_UNSIGNED_BYTE, 4 bytes per pixel
+    OUTPUT_RGB565 = 1      // GL_RGB / GL_UNSIGNED_SHORT_5_6_5, 2 bytes per pixel
+};
+
+/**
+ * Bytes per pixel for an output format.
+ */
+inline int outputBytesPerPixel(OutputFormat format) {
+    return format == OUTPUT_RGB565 ? 2 : 4;
+}
+
+/**
+ * Largest power-of-two downscale factor the active processing mode tolerates.
+ * Effects that depend on fine detail (e.g. Canny) cap this lower than
+ * pure color conversion does.
+ */
+int processorMaxDownscale();
+
+/**
+ * Choose the processing/upload downscale factor for a viewport.
+ *
+ * Picks the largest power of two (up to processorMaxDownscale()) that keeps
+ * the processed image at least as large as the viewport in both dimensions
+ * and divides the frame size exactly. Returns 1 while the viewport is unknown.
+ */
+int processorChooseDownscale(int width, int height, int viewWidth, int viewHeight);
+
+/**
+ * Reference set used by the recognition mode (nullptr = none). Safe to call
+ * from any thread; the next frame picks it up. Processing keeps its own
+ * reference, so a replaced recognizer is destroyed after its last query.
+ */
+void processorSetRecognizer(std::shared_ptr<Recognizer> recognizer);
+
+/**
+ * Template for the template-matching mode (nullptr = none), cut at camera
+ * resolution. Safe to call from any thread; the next frame picks it up.
+ */
+void processorSetTemplate(std::shared_ptr<const TemplatePyramid> pyramid);
+
+/**
+ * Contour mode: polylines of the last camera preview frame processed on
+ * the calling thread, or nullptr in other modes. Valid until that thread's
+ * next processFrame(); the renderer reads it right after processing.
+ */
+const ContourGeometry* processorContours();
+
+/**
+ * Hough stage (Canny and contour modes, when enabled): lines and circles
+ * found in the calling thread's camera preview, or nullptr when the stage
+ * is off. Results
+ * are kept while the edge map is unchanged; `fresh` marks frames on which
+ * the transforms ran.
+ */
+const HoughResult* processorHough();
+
+/**
+ * Panorama mode: start a new sweep. Safe to call from any thread.
+ */
+void processorResetPanorama();
+
+/**
+ * Panorama mode: copy the panorama built so far (RGBA). Safe to call from
+ * any thread; returns false until the sweep has two keyframes.
+ */
+bool processorPanoramaSnapshot(cv::Mat& out);
+
+/**
+ * Calibration mode: discard collected views and start collecting again.
+ * Safe to call from any thread.
+ */
+void processorResetCalibration();
+
+/**
+ * Intrinsics for the undistortion stage (nullptr = off). Safe to call from
+ * any thread. The calibration mode installs its own result when it has one.
+ */
+void processorSetCalibration(std::shared_ptr<const CameraCalibration> calibration);
+std::shared_ptr<const CameraCalibration> processorCalibration();
+
+/**
+ * Full-resolution luma of a camera preview frame, in the same geometry as
+ * the processed frame: the NV21 Y plane itself, or an undistorted copy
+ * while the undistortion stage is on. Stages that read the Y plane outside
+ * processFrame() (stabilization, people detection) use it, so what they
+ * find lines up with the image it is drawn over. The result is valid until
+ * the calling thread's next call.
+ */
+cv::Mat processorPreviewLuma(const uint8_t* nv21Data, int width, int height);
+
+/**
+ * Per-frame cache of images derived from the converted RGBA frame.
+ *
+ * Each derived image is computed on first request and reused by every later
+ * stage of the same frame. Storage comes from frame pools owned by the
+ * context, so steady-state frames allocate nothing. processFrame() calls
+ * begin() for each frame, which invalidates everything from the previous one.
+ *
+ * rgba() aliases the frame's conversion buffer and is only valid until the
+ * pack stage; derived images stay valid until the next begin().
+ * Not thread-safe: one context per processing thread.
+ */
+class FrameContext {
+public:
+    static constexpr int MAX_PYRAMID_LEVELS = 4;
+
+    FrameContext() = default;
+    FrameContext(const FrameContext&) = delete;
+    FrameContext& operator=(const FrameContext&) = delete;
+
+    /** Start a new frame; drops all cached images. */
+    void begin(const cv::Mat& rgba);
+
+    const cv::Mat& rgba() const { return rgba_; }
+    int width() const { return rgba_.cols; }
+    int height() const { return rgba_.rows; }
+
+    /** CV_8UC1 luma at processing resolution */
+    const cv::Mat& gray();
+
+    /** CV_8UC1 gray at half resolution (area average) */
+    const cv::Mat& grayHalf();
+
+    /** Gaussian pyramid of gray(); level 0 is gray() itself */
+    const cv::Mat& pyramid(int level);
+
+    /** CV_32S integral image of gray(), (width+1) x (height+1) */
+    const cv::Mat& integral();
+
+private:
+    enum Slot { SLOT_GRAY = 0, SLOT_GRAY_HALF, SLOT_PYRAMID, SLOT_INTEGRAL, SLOT_COUNT };
+
+    uint8_t* storage(Slot slot, size_t bytes);
+
+    // Pools are declared before the handles so handles are released first
+    std::unique_ptr<FramePool> bytePool_;
+    std::unique_ptr<FramePool> widePool_;
+    FrameHandle handles_[SLOT_COUNT];
+
+    cv::Mat rgba_;
+    cv::Mat gray_;
+    cv::Mat grayHalf_;
+    cv::Mat pyramid_[MAX_PYRAMID_LEVELS + 1];
+    cv::Mat integral_;
+    int pyramidLevels_ = 0;         // Levels computed so far this frame (besides 0)
+};
+
+/**
+ * Frame-to-frame state of one input stream: denoise history, posterize
+ * palette, template tracking, contour and Hough results, undistortion
+ * maps. Frames processed without one use the calling thread's own, which
+ * belongs to the camera preview. The compositor gives each of its streams
+ * one, so streams never see each other's history.
+ *
+ * The panorama sweep and the calibration worker exist once per process and
+ * only follow the camera: they (and undistortion) run on streams created
+ * with camera = true and leave other streams' frames unchanged.
+ */
+struct ProcessorStream;
+
+struct ProcessorStreamDeleter {
+    void operator()(ProcessorStream* stream) const;
+};
+typedef std::unique_ptr<ProcessorStream, ProcessorStreamDeleter> ProcessorStreamPtr;
+
+ProcessorStreamPtr processorCreateStream(bool camera);
+
+/**
+ * Process camera frame: NV21 YUV -> RGBA (or RGB565) with optional effects.
+ *
+ * @param downscale Power-of-two decimation factor (1, 2, 4, 8). Output is
+ *                  (width/downscale) x (height/downscale) pixels.
+ * @param format    Pixel format of pixelsOut.
+ * @param grade     Optional 3D LUT applied to the result before packing, for
+ *                  callers whose output stays on the CPU (the renderer
+ *                  otherwise grades in its fragment shader).
+ * @param stream    State of the stream the frame belongs to; nullptr for
+ *                  the calling thread's camera preview.
+ */
+void processFrame(const uint8_t* nv21Data, int width, int height,
+                  uint8_t* pixelsOut, int downscale = 1,
+                  OutputFormat format = OUTPUT_RGBA8888,
+                  const ColorLut3D* grade = nullptr,
+                  ProcessorStream* stream = nullptr);
+
+#endif // PROCESSOR_H
@@ -0,0 +1,378 @@
+#include "recognizer.h"
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOG_TAG "Recognizer"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+/**
+ * recognizer.cpp - ORB + FLANN LSH recognition with homography check.
+ *
+ * Database layout (all offsets from the start of the file):
+ *   Header
+ *   Reference[referenceCount]          at referencesOffset
+ *   Feature[featureCount]              at featuresOffset (16-byte aligned)
+ *   uint8 descriptors[featureCount][32] at descriptorsOffset (64-byte aligned)
+ * Features are grouped by reference, in the same order as the descriptor
+ * rows and therefore as the LSH index points.
+ *
+ * Only the LSH parameters are stored, in the header. FLANN's own index
+ * file holds nothing else but a copy of the points, which its loader reads
+ * into a heap buffer it never frees. Hashing the mapped descriptors into
+ * the tables is one linear pass, much cheaper than extracting features
+ * from the reference images again.
+ *
+ * The index is cvflann::LshIndex over a cvflann::Matrix that wraps the
+ * mapped rows. cv::flann::Index would clone its input (features_clone),
+ * putting every descriptor on the heap a second time.
+ */
+
+static const char DB_MAGIC[8] = {'O', 'R', 'B', 'R', 'E', 'F', 'D', 'B'};
+static const uint32_t DB_VERSION = 2;
+static const int ORB_DESCRIPTOR_BYTES = 32;
+
+// LSH: 12 hash tables of 20-bit keys, probing neighbors at Hamming distance 2
+static const int LSH_TABLES = 12;
+static const int LSH_KEY_BITS = 20;
+static const int LSH_PROBE_LEVEL = 2;
+
+struct Recognizer::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t referenceCount;
+    uint32_t featureCount;
+    uint32_t descriptorBytes;
+    uint32_t referencesOffset;
+    uint32_t featuresOffset;
+    uint32_t descriptorsOffset;
+    uint32_t lshTables;
+    uint32_t lshKeyBits;
+    uint32_t lshProbeLevel;
+    uint32_t reserved;
+};
+
+struct Recognizer::Reference {
+    char name[NAME_BYTES];          // NUL-terminated
+    uint32_t width;                 // Size the features were extracted at
+    uint32_t height;
+    uint32_t firstFeature;
+    uint32_t featureCount;
+};
+
+struct Recognizer::Feature {
+    float x;
+    float y;
+    uint32_t reference;
+};
+
+static void setError(std::string* error, const std::string& message) {
+    if (error) {
+        *error = message;
+    }
+}
+
+static uint32_t alignUp(size_t value, size_t alignment) {
+    return static_cast<uint32_t>((value + alignment - 1) / alignment * alignment);
+}
+
+Recognizer::Recognizer() = default;
+
+Recognizer::~Recognizer() {
+    unmap();
+}
+
+void Recognizer::unmap() {
+    index_.reset();
+    descriptors_.release();
+    if (mapped_) {
+        munmap(mapped_, mappedBytes_);
+    }
+    mapped_ = nullptr;
+    mappedBytes_ = 0;
+    referenceCount_ = 0;
+    references_ = nullptr;
+    features_ = nullptr;
+}
+
+bool Recognizer::build(const std::vector<ReferenceImage>& refs, const std::string& dbPath,
+                       const RecognitionParams& params, std::string* error) {
+    if (refs.empty()) {
+        setError(error, "no reference images");
+        return false;
+    }
+
+    cv::Ptr<cv::ORB> orb = cv::ORB::create(params.maxFeatures);
+    std::vector<Reference> table(refs.size());
+    std::vector<Feature> features;
+    cv::Mat descriptors;
+    cv::Mat scaled;
+    std::vector<cv::KeyPoint> keypoints;
+    cv::Mat refDescriptors;
+    for (size_t r = 0; r < refs.size(); ++r) {
+        const cv::Mat& gray = refs[r].gray;
+        if (gray.empty() || gray.type() != CV_8UC1) {
+            setError(error, "reference '" + refs[r].name + "' is not an 8-bit gray image");
+            return false;
+        }
+        const double scale = std::min(1.0, static_cast<double>(REFERENCE_MAX_SIDE) /
+                                           std::max(gray.cols, gray.rows));
+        if (scale < 1.0) {
+            cv::resize(gray, scaled, cv::Size(), scale, scale, cv::INTER_AREA);
+        } else {
+            scaled = gray;
+        }
+        orb->detectAndCompute(scaled, cv::noArray(), keypoints, refDescriptors);
+
+        Reference& ref = table[r];
+        std::memset(&ref, 0, sizeof(ref));
+        std::strncpy(ref.name, refs[r].name.c_str(), NAME_BYTES - 1);
+        ref.width = static_cast<uint32_t>(scaled.cols);
+        ref.height = static_cast<uint32_t>(scaled.rows);
+        ref.firstFeature = static_cast<uint32_t>(features.size());
+        ref.featureCount = static_cast<uint32_t>(keypoints.size());
+        for (const cv::KeyPoint& kp : keypoints) {
+            features.push_back({kp.pt.x, kp.pt.y, static_cast<uint32_t>(r)});
+        }
+        if (!refDescriptors.empty()) {
+            descriptors.push_back(refDescriptors);
+        }
+        if (keypoints.size() < static_cast<size_t>(params.minInliers)) {
+            LOGI("Reference '%s' has only %zu features; it will rarely verify",
+                 refs[r].name.c_str(), keypoints.size());
+        }
+    }
+    if (descriptors.empty()) {
+        setError(error, "no features in any reference image");
+        return false;
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, DB_MAGIC, sizeof(DB_MAGIC));
+    header.version = DB_VERSION;
+    header.referenceCount = static_cast<uint32_t>(table.size());
+    header.featureCount = static_cast<uint32_t>(features.size());
+    header.descriptorBytes = ORB_DESCRIPTOR_BYTES;
+    header.referencesOffset = sizeof(Header);
+    header.featuresOffset = alignUp(header.referencesOffset + table.size() * sizeof(Reference), 16);
+    header.descriptorsOffset = alignUp(header.featuresOffset + features.size() * sizeof(Feature), 64);
+    header.lshTables = LSH_TABLES;
+    header.lshKeyBits = LSH_KEY_BITS;
+    header.lshProbeLevel = LSH_PROBE_LEVEL;
+
+    std::ofstream out(dbPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        setError(error, "cannot write " + dbPath);
+        return false;
+    }
+    const auto padTo = [&out](uint32_t offset) {
+        static const char zeros[64] = {};
+        const std::streamoff pad = offset - static_cast<std::streamoff>(out.tellp());
+        out.write(zeros, pad);
+    };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(Reference));
+    padTo(header.featuresOffset);
+    out.write(reinterpret_cast<const char*>(features.data()), features.size() * sizeof(Feature));
+    padTo(header.descriptorsOffset);
+    out.write(reinterpret_cast<const char*>(descriptors.data), descriptors.total());
+    if (!out) {
+        setError(error, "write failed: " + dbPath);
+        return false;
+    }
+    out.close();
+
+    LOGI("Built reference set: %zu references, %zu features -> %s", table.size(),
+         features.size(), dbPath.c_str());
+    return true;
+}
+
+bool Recognizer::load(const std::string& dbPath, const RecognitionParams& params, std::string* error) {
+    const auto start = std::chrono::steady_clock::now();
+    unmap();
+    params_ = params;
+
+    const int fd = open(dbPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        setError(error, "cannot open " + dbPath);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        close(fd);
+        setError(error, "truncated database " + dbPath);
+        return false;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        setError(error, "mmap failed for " + dbPath);
+        return false;
+    }
+    mapped_ = mapped;
+    mappedBytes_ = static_cast<size_t>(st.st_size);
+
+    const uint8_t* base = static_cast<const uint8_t*>(mapped_);
+    const Header* header = reinterpret_cast<const Header*>(base);
+    const uint64_t referencesEnd = header->referencesOffset +
+                                   static_cast<uint64_t>(header->referenceCount) * sizeof(Reference);
+    const uint64_t featuresEnd = header->featuresOffset +
+                                 static_cast<uint64_t>(header->featureCount) * sizeof(Feature);
+    const uint64_t descriptorsEnd = header->descriptorsOffset +
+                                    static_cast<uint64_t>(header->featureCount) * header->descriptorBytes;
+    if (std::memcmp(header->magic, DB_MAGIC, sizeof(DB_MAGIC)) != 0 || header->version != DB_VERSION ||
+        header->descriptorBytes != ORB_DESCRIPTOR_BYTES || header->referenceCount == 0 ||
+        header->featureCount == 0 || header->featuresOffset % 4 != 0 ||
+        header->lshTables == 0 || header->lshKeyBits == 0 || header->lshKeyBits > 32 ||
+        referencesEnd > mappedBytes_ || featuresEnd > mappedBytes_ || descriptorsEnd > mappedBytes_) {
+        unmap();
+        setError(error, "not a reference database (or wrong version): " + dbPath);
+        return false;
+    }
+
+    // Records are used as indices and C strings on the frame thread
+    const Reference* references = reinterpret_cast<const Reference*>(base + header->referencesOffset);
+    const Feature* features = reinterpret_cast<const Feature*>(base + header->featuresOffset);
+    for (uint32_t i = 0; i < header->referenceCount; ++i) {
+        if (std::memchr(references[i].name, '\0', NAME_BYTES) == nullptr) {
+            unmap();
+            setError(error, "corrupt reference table: " + dbPath);
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->featureCount; ++i) {
+        if (features[i].reference >= header->referenceCount) {
+            unmap();
+            setError(error, "corrupt feature table: " + dbPath);
+            return false;
+        }
+    }
+
+    referenceCount_ = static_cast<int>(header->referenceCount);
+    references_ = references;
+    features_ = features;
+    descriptors_ = cv::Mat(static_cast<int>(header->featureCount), ORB_DESCRIPTOR_BYTES, CV_8UC1,
+                           const_cast<uint8_t*>(base + header->descriptorsOffset));
+
+    // The index reads the mapped rows; unmap() drops it before unmapping
+    try {
+        const cvflann::Matrix<unsigned char> points(descriptors_.data, descriptors_.rows,
+                                                    descriptors_.cols);
+        index_.reset(new LshIndex(points, cvflann::LshIndexParams(
+                static_cast<int>(header->lshTables), static_cast<int>(header->lshKeyBits),
+                static_cast<int>(header->lshProbeLevel))));
+        index_->buildIndex();
+    } catch (const cv::Exception& e) {
+        LOGE("Indexing %s: %s", dbPath.c_str(), e.what());
+        unmap();
+        setError(error, "cannot index " + dbPath);
+        return false;
+    }
+
+    orb_ = cv::ORB::create(params_.maxFeatures);
+    votes_.assign(referenceCount_, 0);
+
+    const double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+    LOGI("Loaded reference set: %d references, %d features in %.1f ms", referenceCount_,
+         descriptors_.rows, ms);
+    return true;
+}
+
+bool Recognizer::recognize(const cv::Mat& gray, Recognition& out) {
+    out = Recognition();
+    if (!loaded()) {
+        return false;
+    }
+
+    orb_->detectAndCompute(gray, cv::noArray(), keypoints_, queryDescriptors_);
+    if (queryDescriptors_.rows < params_.minMatches) {
+        return false;
+    }
+
+    knnIndices_.create(queryDescriptors_.rows, 2, CV_32S);
+    knnDists_.create(queryDescriptors_.rows, 2, CV_32S);
+    cvflann::Matrix<unsigned char> queries(queryDescriptors_.data, queryDescriptors_.rows,
+                                           queryDescriptors_.cols, queryDescriptors_.step);
+    cvflann::Matrix<int> indices(knnIndices_.ptr<int>(), knnIndices_.rows, 2);
+    cvflann::Matrix<int> dists(knnDists_.ptr<int>(), knnDists_.rows, 2);
+    index_->knnSearch(queries, indices, dists, 2, cvflann::SearchParams(params_.checks));
+
+    // Ratio test, then one vote per surviving match for its reference
+    std::fill(votes_.begin(), votes_.end(), 0);
+    goodMatches_.clear();
+    for (int q = 0; q < knnIndices_.rows; ++q) {
+        const int* idx = knnIndices_.ptr<int>(q);
+        if (idx[0] < 0) {
+            continue;
+        }
+        const int d0 = knnDists_.ptr<int>(q)[0];
+        const int d1 = knnDists_.ptr<int>(q)[1];
+        if (d0 > params_.maxDistance || (idx[1] >= 0 && d0 >= params_.ratio * d1)) {
+            continue;
+        }
+        goodMatches_.emplace_back(q, idx[0]);
+        ++votes_[features_[idx[0]].reference];
+    }
+
+    // Verify the best-voted references; keep the one with most inliers
+    std::vector<int> order;
+    for (int r = 0; r < referenceCount_; ++r) {
+        if (votes_[r] >= params_.minMatches) {
+            order.push_back(r);
+        }
+    }
+    const size_t verify = std::min(order.size(), static_cast<size_t>(params_.candidates));
+    std::partial_sort(order.begin(), order.begin() + verify, order.end(),
+                      [this](int a, int b) { return votes_[a] > votes_[b]; });
+
+    cv::Mat bestHomography;
+    for (size_t c = 0; c < verify; ++c) {
+        const int r = order[c];
+        srcPoints_.clear();
+        dstPoints_.clear();
+        for (const std::pair<int, int>& match : goodMatches_) {
+            const Feature& feature = features_[match.second];
+            if (static_cast<int>(feature.reference) == r) {
+                srcPoints_.emplace_back(feature.x, feature.y);
+                dstPoints_.push_back(keypoints_[match.first].pt);
+            }
+        }
+        const cv::Mat homography = cv::findHomography(srcPoints_, dstPoints_, cv::RANSAC, 5.0,
+                                                      inlierMask_);
+        if (homography.empty()) {
+            continue;
+        }
+        const int inliers = cv::countNonZero(inlierMask_);
+        if (inliers >= params_.minInliers && inliers > out.inliers) {
+            out.reference = r;
+            out.matches = votes_[r];
+            out.inliers = inliers;
+            bestHomography = homography;
+        }
+    }
+    if (out.reference < 0) {
+        return false;
+    }
+
+    const Reference& ref = references_[out.reference];
+    out.name = ref.name;
+    const std::vector<cv::Point2f> outline = {
+            {0.0f, 0.0f}, {static_cast<float>(ref.width), 0.0f},
+            {static_cast<float>(ref.width), static_cast<float>(ref.height)},
+            {0.0f, static_cast<float>(ref.height)}};
+    std::vector<cv::Point2f> projected;
+    cv::perspectiveTransform(outline, projected, bestHomography);
+    std::copy(projected.begin(), projected.end(), out.corners);
+    return true;
+}
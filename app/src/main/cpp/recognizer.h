@@ -0,0 +1,119 @@
+#ifndef RECOGNIZER_H
+#define RECOGNIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <opencv2/flann.hpp>
+
+/**
+ * Planar object recognition (posters, product packaging) against a
+ * reference set. Implementation is in recognizer.cpp.
+ *
+ * Offline, build() extracts ORB features from every reference image and
+ * writes a reference database: a flat little-endian file (header with the
+ * LSH parameters, reference table, keypoints, 32-byte descriptors). load()
+ * maps it read-only and hashes the mapped descriptors into FLANN LSH
+ * tables. The tables hold row indices and the index reads the rows from
+ * the mapping, so the descriptors are never copied to the heap.
+ * At run time, recognize() extracts ORB from a downscaled luma image,
+ * queries the index for the two nearest reference descriptors of each
+ * feature (ratio test), votes per reference, and verifies the best-voted
+ * candidates with a RANSAC homography.
+ */
+struct RecognitionParams {
+    int maxFeatures = 500;          // ORB features per frame (and per reference)
+    int checks = 32;                // FLANN search checks
+    float ratio = 0.8f;             // Nearest / second-nearest Hamming distance
+    int maxDistance = 64;           // Reject matches further than this (of 256 bits)
+    int minMatches = 12;            // Votes a reference needs to be verified
+    int minInliers = 15;            // Homography inliers to accept a reference
+    int candidates = 3;             // Best-voted references that get verified
+};
+
+/** One reference image for build(): gray, any size (downscaled internally) */
+struct ReferenceImage {
+    std::string name;
+    cv::Mat gray;
+};
+
+struct Recognition {
+    int reference = -1;             // Index into the reference set
+    std::string name;
+    int matches = 0;                // Votes after the ratio test
+    int inliers = 0;
+    cv::Point2f corners[4];         // Reference outline in query image coordinates
+};
+
+class Recognizer {
+public:
+    // Longest side of a reference image when its features are extracted
+    static constexpr int REFERENCE_MAX_SIDE = 640;
+    static constexpr int NAME_BYTES = 48;
+
+    Recognizer();
+    ~Recognizer();
+    Recognizer(const Recognizer&) = delete;
+    Recognizer& operator=(const Recognizer&) = delete;
+
+    /**
+     * Offline: extract features from refs and write the database.
+     * Returns false and fills *error on failure.
+     */
+    static bool build(const std::vector<ReferenceImage>& refs, const std::string& dbPath,
+                      const RecognitionParams& params = RecognitionParams(), std::string* error = nullptr);
+
+    /** Map a database and index it; replaces anything loaded before. */
+    bool load(const std::string& dbPath, const RecognitionParams& params = RecognitionParams(),
+              std::string* error = nullptr);
+
+    bool loaded() const { return mapped_ != nullptr; }
+    int referenceCount() const { return referenceCount_; }
+    size_t featureCount() const { return static_cast<size_t>(descriptors_.rows); }
+
+    /**
+     * Find the best-verified reference in a CV_8UC1 image. Reuses internal
+     * buffers, so one thread at a time.
+     */
+    bool recognize(const cv::Mat& gray, Recognition& out);
+
+private:
+    struct Header;
+    struct Reference;
+    struct Feature;
+
+    // The templated index, not cv::flann::Index: the latter clones the
+    // points it is built on
+    typedef cvflann::LshIndex<cvflann::Hamming<unsigned char>> LshIndex;
+
+    void unmap();
+
+    RecognitionParams params_;
+    cv::Ptr<cv::ORB> orb_;
+    std::unique_ptr<LshIndex> index_;   // Reads descriptors_ (the mapping)
+
+    // Views into the mapped database
+    void* mapped_ = nullptr;
+    size_t mappedBytes_ = 0;
+    int referenceCount_ = 0;
+    const Reference* references_ = nullptr;
+    const Feature* features_ = nullptr;
+    cv::Mat descriptors_;
+
+    // Per-query scratch
+    std::vector<cv::KeyPoint> keypoints_;
+    cv::Mat queryDescriptors_;
+    cv::Mat knnIndices_;
+    cv::Mat knnDists_;
+    std::vector<int> votes_;
+    std::vector<std::pair<int, int>> goodMatches_;  // (query keypoint, reference feature)
+    std::vector<cv::Point2f> srcPoints_;
+    std::vector<cv::Point2f> dstPoints_;
+    cv::Mat inlierMask_;
+};
+
+#endif // RECOGNIZER_H
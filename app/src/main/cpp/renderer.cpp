@@ -1,30 +1,97 @@
 #include "renderer.h"
-#include <GLES2/gl2.h>
-#include <GLES2/gl2ext.h>
+#include "processor.h"
+#include "stats.h"
+#include "gl_ext.h"
+#include "gpu_timer.h"
+#include "gl_util.h"
+#include "frame_pool.h"
+#include "frame_sink.h"
+#include "color_lut.h"
+#include "recognizer.h"
+#include "stabilizer.h"
+#include "calibration.h"
+#include "template_matcher.h"
+#include "people_detector.h"
+#include "contour_vectors.h"
+#include "contour_layer.h"
+#include "hough_detector.h"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
 #include <android/log.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cfloat>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <cstring>
+#include <thread>
+#include <vector>
 
 #define LOG_TAG "Renderer"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-// Forward declaration of processor functions
-extern void processFrame(const uint8_t* nv21Data, int width, int height, uint8_t* rgbaOut);
+// Default output format (RGBA8888 for quality, RGB565 for bandwidth)
+static const OutputFormat DEFAULT_OUTPUT_FORMAT = OUTPUT_RGBA8888;
 
-// Shader sources
+// Stabilize the displayed preview by default (toggle at runtime with
+// Renderer::setStabilizationEnabled)
+static const bool STABILIZE = false;
+
+// Log stabilization cost this often (frames)
+static const int STABILIZE_LOG_INTERVAL = 120;
+
+// Detect and track people by default (toggle at runtime with
+// Renderer::setPeopleDetectionEnabled). Boxes are drawn as a GL overlay.
+static const bool DETECT_PEOPLE = false;
+
+// People detection: 640 px luma, people 35-100% of the frame height,
+// two scales per worker pass
+static const PeopleParams PEOPLE = {};
+
+// Log per-scale scan times and the detection rate this often (scans)
+static const int PEOPLE_LOG_SCANS = 30;
+
+// Vertex capacity of the Hough overlay (a segment takes 2 vertices, a
+// circle 33); strips beyond it are not drawn
+static const int HOUGH_LAYER_VERTICES = 2048;
+
+// Number of textures in the upload ring (1 = single texture).
+// With 2-3 slots, uploads go to a texture the GPU is not sampling, so the
+// driver neither stalls nor shadow-copies on glTexSubImage2D.
+static const int TEXTURE_RING_SIZE = 3;
+static const int MAX_TEXTURE_RING = 4;
+
+// Pooled frame buffers: NV21 inputs handed to JNI, and processed outputs.
+// Sized for one frame in flight per stage plus consumers holding the latest.
+// Sinks get their own share of output buffers so they can never starve the
+// display path; addSink() rejects sinks whose queues would exceed it.
+static const int CAMERA_POOL_SIZE = 4;
+static const int DISPLAY_OUTPUT_BUFFERS = 4;
+static const int SINK_OUTPUT_BUFFERS = 8;
+static const int OUTPUT_POOL_SIZE = DISPLAY_OUTPUT_BUFFERS + SINK_OUTPUT_BUFFERS;
+
+// Shader sources. u_texTransform maps screen to texture coordinates; it
+// carries the stabilization correction and is the identity otherwise.
 static constexpr const char* vertexShaderSource = R"(
     attribute vec4 a_position;
     attribute vec2 a_texCoord;
+    uniform mat3 u_texTransform;
     varying vec2 v_texCoord;
 
     void main() {
         gl_Position = a_position;
-        v_texCoord = a_texCoord;
+        v_texCoord = (u_texTransform * vec3(a_texCoord, 1.0)).xy;
     }
 )";
 
+static const GLfloat IDENTITY_TRANSFORM[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+
 static constexpr const char* fragmentShaderSource = R"(
     precision mediump float;
     varying vec2 v_texCoord;
@@ -35,24 +102,457 @@ static constexpr const char* fragmentShaderSource = R"(
     }
 )";
 
-// Private helper function for shader compilation
-static GLuint compileShader(GLenum type, const char* source) {
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, nullptr);
-    glCompileShader(shader);
+// Same quad, graded through a 3D LUT packed as N blue slices of N x N side
+// by side in one 2D texture (GLES2 has no 3D textures). Bilinear filtering
+// interpolates red/green inside a slice; the two nearest slices are blended
+// for blue. Texel addressing in an N*N-wide texture needs highp.
+static constexpr const char* gradeFragmentShaderSource = R"(
+    #ifdef GL_FRAGMENT_PRECISION_HIGH
+    precision highp float;
+    #else
+    precision mediump float;
+    #endif
+    varying vec2 v_texCoord;
+    uniform sampler2D u_texture;
+    uniform sampler2D u_lut;
+    uniform float u_lutSize;
+
+    void main() {
+        vec4 color = texture2D(u_texture, v_texCoord);
+        float maxIndex = u_lutSize - 1.0;
+        float blue = color.b * maxIndex;
+        float slice0 = floor(blue);
+        float slice1 = min(slice0 + 1.0, maxIndex);
+        vec2 inSlice = (color.rg * maxIndex + 0.5) / vec2(u_lutSize * u_lutSize, u_lutSize);
+        vec3 lo = texture2D(u_lut, vec2(inSlice.x + slice0 / u_lutSize, inSlice.y)).rgb;
+        vec3 hi = texture2D(u_lut, vec2(inSlice.x + slice1 / u_lutSize, inSlice.y)).rgb;
+        gl_FragColor = vec4(mix(lo, hi, blue - slice0), color.a);
+    }
+)";
+
+// ========== Performance HUD ==========
+//
+// Optional overlay with per-stage bars, an FPS sparkline and a dropped-frame
+// counter. Everything is emitted as textured quads into one dynamic VBO and
+// drawn with a single glDrawArrays. Text comes from a baked 3x5 glyph atlas
+// uploaded once per context; nothing is rasterized on the CPU per frame.
+
+// Show the HUD by default (toggle at runtime with Renderer::setHudEnabled)
+static const bool SHOW_HUD = false;
+
+static constexpr const char* hudVertexShaderSource = R"(
+    attribute vec2 a_position;
+    attribute vec2 a_texCoord;
+    attribute vec4 a_color;
+    varying vec2 v_texCoord;
+    varying vec4 v_color;
+
+    void main() {
+        gl_Position = vec4(a_position, 0.0, 1.0);
+        v_texCoord = a_texCoord;
+        v_color = a_color;
+    }
+)";
+
+static constexpr const char* hudFragmentShaderSource = R"(
+    precision mediump float;
+    varying vec2 v_texCoord;
+    varying vec4 v_color;
+    uniform sampler2D u_atlas;
+
+    void main() {
+        gl_FragColor = vec4(v_color.rgb, v_color.a * texture2D(u_atlas, v_texCoord).a);
+    }
+)";
+
+// Glyph order in the atlas; the cell after the last glyph is solid (for bars)
+static const char HUD_GLYPHS[] = " 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ.-:+/";
+
+// 3x5 bitmaps, one string of 15 bits per glyph (rows top to bottom)
+static const char* const HUD_GLYPH_BITS[] = {
+        "000000000000000",  // ' '
+        "111101101101111", "010110010010111", "111001111100111", "111001111001111",
+        "101101111001001", "111100111001111", "111100111101111", "111001001001001",
+        "111101111101111", "111101111001111",
+        "010101111101101", "110101110101110", "011100100100011", "110101101101110",
+        "111100110100111", "111100110100100", "011100101101011", "101101111101101",
+        "111010010010111", "001001001101010", "101101110101101", "100100100100111",
+        "101111111101101", "110101101101101", "010101101101010", "110101110100100",
+        "010101101110011", "110101110101101", "011100010001110", "111010010010010",
+        "101101101101111", "101101101101010", "101101111111101", "101101010101101",
+        "101101010010010", "111001010100111",
+        "000000000000010",  // '.'
+        "000000111000000",  // '-'
+        "000010000010000",  // ':'
+        "000010111010000",  // '+'
+        "001001010100100",  // '/'
+};
+
+static constexpr int HUD_GLYPH_COUNT = sizeof(HUD_GLYPHS) - 1;
+static constexpr int HUD_CELL_W = 4;      // 3 px glyph + 1 px gap
+static constexpr int HUD_CELL_H = 6;      // 5 px glyph + 1 px gap
+static constexpr int HUD_ATLAS_W = (HUD_GLYPH_COUNT + 1) * HUD_CELL_W;
+static constexpr int HUD_MAX_QUADS = 512;
+
+struct HudVertex {
+    GLfloat x, y;
+    GLfloat u, v;
+    GLubyte r, g, b, a;
+};
+
+struct HudColor {
+    GLubyte r, g, b, a;
+};
+
+struct Hud {
+    bool enabled = SHOW_HUD;
+
+    GLuint program = 0;
+    GLuint atlas = 0;
+    GLuint vbo = 0;
+    GLint positionLoc = -1;
+    GLint texCoordLoc = -1;
+    GLint colorLoc = -1;
+    GLint atlasLoc = -1;
+
+    // Rebuilt every frame, capacity reserved once
+    std::vector<HudVertex> vertices;
+    int screenWidth = 0;
+    int screenHeight = 0;
+};
+
+static void hudCreate(Hud& hud) {
+    hud.program = linkProgram(hudVertexShaderSource, hudFragmentShaderSource);
+    hud.positionLoc = glGetAttribLocation(hud.program, "a_position");
+    hud.texCoordLoc = glGetAttribLocation(hud.program, "a_texCoord");
+    hud.colorLoc = glGetAttribLocation(hud.program, "a_color");
+    hud.atlasLoc = glGetUniformLocation(hud.program, "u_atlas");
+
+    // Expand the baked bitmaps into an alpha atlas (once per context)
+    GLubyte pixels[HUD_CELL_H][HUD_ATLAS_W] = {};
+    for (int g = 0; g < HUD_GLYPH_COUNT; ++g) {
+        for (int bit = 0; bit < 15; ++bit) {
+            if (HUD_GLYPH_BITS[g][bit] == '1') {
+                pixels[bit / 3][g * HUD_CELL_W + bit % 3] = 255;
+            }
+        }
+    }
+    for (int y = 0; y < HUD_CELL_H; ++y) {
+        for (int x = 0; x < HUD_CELL_W; ++x) {
+            pixels[y][HUD_GLYPH_COUNT * HUD_CELL_W + x] = 255;
+        }
+    }
+
+    glGenTextures(1, &hud.atlas);
+    glBindTexture(GL_TEXTURE_2D, hud.atlas);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, HUD_ATLAS_W, HUD_CELL_H,
+                 0, GL_ALPHA, GL_UNSIGNED_BYTE, pixels);
+
+    glGenBuffers(1, &hud.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, hud.vbo);
+    glBufferData(GL_ARRAY_BUFFER, HUD_MAX_QUADS * 6 * sizeof(HudVertex), nullptr, GL_STREAM_DRAW);
+
+    hud.vertices.reserve(HUD_MAX_QUADS * 6);
+}
+
+static void hudDestroy(Hud& hud) {
+    if (hud.program != 0) glDeleteProgram(hud.program);
+    if (hud.atlas != 0) glDeleteTextures(1, &hud.atlas);
+    if (hud.vbo != 0) glDeleteBuffers(1, &hud.vbo);
+    hud.program = 0;
+    hud.atlas = 0;
+    hud.vbo = 0;
+}
+
+/**
+ * Append a quad given in screen pixels (origin top-left) and atlas texels.
+ */
+static void hudQuad(Hud& hud, float x0, float y0, float x1, float y1,
+                    float u0, float v0, float u1, float v1, HudColor c) {
+    if (hud.vertices.size() + 6 > static_cast<size_t>(HUD_MAX_QUADS * 6)) {
+        return;
+    }
+
+    const float sx = 2.0f / hud.screenWidth;
+    const float sy = 2.0f / hud.screenHeight;
+    const float nx0 = x0 * sx - 1.0f, nx1 = x1 * sx - 1.0f;
+    const float ny0 = 1.0f - y0 * sy, ny1 = 1.0f - y1 * sy;
+    u0 /= HUD_ATLAS_W; u1 /= HUD_ATLAS_W;
+    v0 /= HUD_CELL_H;  v1 /= HUD_CELL_H;
+
+    const HudVertex quad[6] = {
+            {nx0, ny0, u0, v0, c.r, c.g, c.b, c.a}, {nx1, ny0, u1, v0, c.r, c.g, c.b, c.a},
+            {nx0, ny1, u0, v1, c.r, c.g, c.b, c.a}, {nx1, ny0, u1, v0, c.r, c.g, c.b, c.a},
+            {nx1, ny1, u1, v1, c.r, c.g, c.b, c.a}, {nx0, ny1, u0, v1, c.r, c.g, c.b, c.a},
+    };
+    hud.vertices.insert(hud.vertices.end(), quad, quad + 6);
+}
+
+static void hudRect(Hud& hud, float x0, float y0, float x1, float y1, HudColor c) {
+    // Sample the middle of the solid cell
+    const float u = HUD_GLYPH_COUNT * HUD_CELL_W + HUD_CELL_W * 0.5f;
+    const float v = HUD_CELL_H * 0.5f;
+    hudQuad(hud, x0, y0, x1, y1, u, v, u, v, c);
+}
+
+/**
+ * Append text at (x, y); each glyph pixel is `scale` screen pixels.
+ * Returns the x position after the last glyph.
+ */
+static float hudText(Hud& hud, float x, float y, float scale, const char* text, HudColor c) {
+    for (const char* p = text; *p; ++p) {
+        const char ch = static_cast<char>(std::toupper(static_cast<unsigned char>(*p)));
+        const char* found = std::strchr(HUD_GLYPHS, ch);
+        if (found != nullptr && ch != ' ') {
+            const float u = static_cast<float>((found - HUD_GLYPHS) * HUD_CELL_W);
+            hudQuad(hud, x, y, x + 3 * scale, y + 5 * scale, u, 0.0f, u + 3.0f, 5.0f, c);
+        }
+        x += HUD_CELL_W * scale;
+    }
+    return x;
+}
+
+static HudColor hudBudgetColor(double ms) {
+    if (ms < 16.7) return {80, 220, 80, 255};
+    if (ms < 33.3) return {240, 200, 40, 255};
+    return {240, 70, 60, 255};
+}
+
+/**
+ * Start a new frame's HUD vertex list. Overlays and the stats panel are
+ * appended to it and drawn in one batch.
+ */
+static void hudBegin(Hud& hud, int screenWidth, int screenHeight) {
+    hud.vertices.clear();
+    hud.screenWidth = screenWidth;
+    hud.screenHeight = screenHeight;
+}
+
+/**
+ * Append the stats panel to the HUD vertex list.
+ */
+static void hudBuild(Hud& hud) {
+    const int screenWidth = hud.screenWidth;
+    const int screenHeight = hud.screenHeight;
+    if (screenWidth <= 0 || screenHeight <= 0) {
+        return;
+    }
+
+    const float scale = static_cast<float>(std::max(2, std::min(screenWidth, screenHeight) / 240));
+    const float line = 7 * scale;
+    const float left = 4 * scale;
+    const float barX = left + 15 * HUD_CELL_W * scale;
+    const float barMax = 40 * scale;       // 33.3 ms budget
+    const float panelW = barX + barMax + 8 * HUD_CELL_W * scale;
+    const HudColor white = {235, 235, 235, 255};
+    char text[32];
+
+    // Rows only for stages that ran within the sparkline's window; the
+    // draw interval is shown as FPS
+    StatStage stages[STAT_COUNT];
+    int stageRows = 0;
+    for (int i = 0; i < STAT_COUNT; ++i) {
+        const StatStage stage = static_cast<StatStage>(i);
+        if (stage != STAT_DRAW_INTERVAL && statsStageActive(stage, STATS_HISTORY_SIZE)) {
+            stages[stageRows++] = stage;
+        }
+    }
+
+    // Panel background; height = stage rows + FPS row + sparkline
+    const float sparkH = 12 * scale;
+    const float panelH = (stageRows + 1) * line + sparkH + 3 * scale;
+    hudRect(hud, 0, 0, panelW, panelH, {0, 0, 0, 160});
+
+    float y = 2 * scale;
+    for (int row = 0; row < stageRows; ++row) {
+        const StatStage stage = stages[row];
+
+        const double ms = statsAverageMs(stage);
+        hudText(hud, left, y, scale, statsStageName(stage), white);
+        const float barW = static_cast<float>(std::min(ms / 33.3, 1.0)) * barMax;
+        hudRect(hud, barX, y, barX + std::max(barW, scale), y + 5 * scale, hudBudgetColor(ms));
+        std::snprintf(text, sizeof(text), "%.1f", ms);
+        hudText(hud, barX + barMax + 2 * scale, y, scale, text, white);
+        y += line;
+    }
+
+    const double intervalMs = statsAverageMs(STAT_DRAW_INTERVAL);
+    std::snprintf(text, sizeof(text), "FPS %.1f DROP %llu",
+                  intervalMs > 0.0 ? 1000.0 / intervalMs : 0.0,
+                  static_cast<unsigned long long>(statsDroppedFrames()));
+    hudText(hud, left, y, scale, text, white);
+    y += line;
+
+    // FPS sparkline from recent draw intervals (full height = 60 FPS)
+    float history[STATS_HISTORY_SIZE];
+    const int count = statsHistory(STAT_DRAW_INTERVAL, history, STATS_HISTORY_SIZE);
+    const float bottom = y + sparkH;
+    for (int i = 0; i < count; ++i) {
+        const float fps = history[i] > 0.0f ? 1000.0f / history[i] : 0.0f;
+        const float h = std::min(fps / 60.0f, 1.0f) * sparkH;
+        const float x = left + i * scale;
+        hudRect(hud, x, bottom - std::max(h, 1.0f), x + scale, bottom, hudBudgetColor(history[i]));
+    }
+}
+
+/**
+ * Append outlines of tracked people. Boxes are in normalized frame
+ * coordinates; the inverse of the drawn frame's texture transform (see the
+ * vertex shader) takes them to the screen, so they follow a stabilized
+ * preview.
+ */
+static void hudPeople(Hud& hud, const std::vector<PersonTrack>& tracks, const GLfloat* texTransform) {
+    if (tracks.empty() || hud.screenWidth <= 0 || hud.screenHeight <= 0) {
+        return;
+    }
+    cv::Matx33f toTexture;
+    for (int col = 0; col < 3; ++col) {
+        for (int row = 0; row < 3; ++row) {
+            toTexture(row, col) = texTransform[col * 3 + row];
+        }
+    }
+    const cv::Matx33f toScreen = toTexture.inv();
+
+    const float scale = static_cast<float>(std::max(2, std::min(hud.screenWidth, hud.screenHeight) / 240));
+    const HudColor green = {60, 230, 90, 255};
+    char text[16];
+    for (const PersonTrack& track : tracks) {
+        // Screen-aligned bounds of the transformed box
+        float x0 = FLT_MAX, y0 = FLT_MAX, x1 = -FLT_MAX, y1 = -FLT_MAX;
+        const cv::Point2f corners[4] = {track.box.tl(), {track.box.x + track.box.width, track.box.y},
+                                        track.box.br(), {track.box.x, track.box.y + track.box.height}};
+        for (const cv::Point2f& c : corners) {
+            const cv::Vec3f p = toScreen * cv::Vec3f(c.x, c.y, 1.0f);
+            x0 = std::min(x0, p[0] * hud.screenWidth);
+            x1 = std::max(x1, p[0] * hud.screenWidth);
+            y0 = std::min(y0, p[1] * hud.screenHeight);
+            y1 = std::max(y1, p[1] * hud.screenHeight);
+        }
+        hudRect(hud, x0, y0, x1, y0 + scale, green);
+        hudRect(hud, x0, y1 - scale, x1, y1, green);
+        hudRect(hud, x0, y0, x0 + scale, y1, green);
+        hudRect(hud, x1 - scale, y0, x1, y1, green);
+        std::snprintf(text, sizeof(text), "%d", track.id);
+        hudText(hud, x0 + 2 * scale, y0 + 2 * scale, scale, text, green);
+    }
+}
+
+static void hudDraw(Hud& hud) {
+    if (hud.vertices.empty()) {
+        return;
+    }
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glUseProgram(hud.program);
 
-    // Check compile status
-    GLint compileStatus = 0;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
-    if (compileStatus != GL_TRUE) {
-        GLchar log[512];
-        glGetShaderInfoLog(shader, 512, nullptr, log);
-        LOGE("Shader compilation failed: %s", log);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, hud.atlas);
+    glUniform1i(hud.atlasLoc, 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, hud.vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, hud.vertices.size() * sizeof(HudVertex),
+                    hud.vertices.data());
+
+    glEnableVertexAttribArray(hud.positionLoc);
+    glVertexAttribPointer(hud.positionLoc, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex),
+                          (void*)offsetof(HudVertex, x));
+    glEnableVertexAttribArray(hud.texCoordLoc);
+    glVertexAttribPointer(hud.texCoordLoc, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex),
+                          (void*)offsetof(HudVertex, u));
+    glEnableVertexAttribArray(hud.colorLoc);
+    glVertexAttribPointer(hud.colorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(HudVertex),
+                          (void*)offsetof(HudVertex, r));
+
+    // One batched draw for the whole HUD
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(hud.vertices.size()));
+
+    glDisableVertexAttribArray(hud.positionLoc);
+    glDisableVertexAttribArray(hud.texCoordLoc);
+    glDisableVertexAttribArray(hud.colorLoc);
+    glDisable(GL_BLEND);
+}
+
+/**
+ * One texture in the upload ring.
+ *
+ * Fences are only created when the context supports them (ES 3.0+);
+ * otherwise slots rotate round-robin and GL ordering guarantees correctness.
+ */
+struct TextureSlot {
+    GLuint texture = 0;
+    int width = 0;
+    int height = 0;
+    OutputFormat format = DEFAULT_OUTPUT_FORMAT;
+
+    bool gpuGrade = false;          // Contents still need the LUT applied when drawn
+    GLfloat texTransform[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};  // Column-major, see vertex shader
+
+    GLsync uploadFence = nullptr;   // Signaled when the upload has landed
+    GLsync drawFence = nullptr;     // Signaled when the last draw sampling it finished
+    uint64_t sequence = 0;          // Frame sequence of the contents (0 = empty)
+    uint64_t houghVersion = 0;      // Hough result in the slot's line buffer
+};
+
+/**
+ * Non-blocking fence poll. Deletes and clears the fence once signaled.
+ */
+static bool pollFence(const GlExtensions& ext, GLsync& fence) {
+    if (fence == nullptr) {
+        return true;
     }
 
-    return shader;
+    GLenum result = ext.clientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+        ext.deleteSync(fence);
+        fence = nullptr;
+        return true;
+    }
+    return false;
 }
 
+static void replaceFence(const GlExtensions& ext, GLsync& fence) {
+    if (!ext.hasFenceSync) {
+        return;
+    }
+    if (fence != nullptr) {
+        ext.deleteSync(fence);
+    }
+    fence = ext.fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/**
+ * Camera quad program with the 3D LUT stage.
+ */
+struct GradeProgram {
+    GLuint program = 0;
+    GLint positionLoc = -1;
+    GLint texCoordLoc = -1;
+    GLint textureLoc = -1;
+    GLint texTransformLoc = -1;
+    GLint lutLoc = -1;
+    GLint lutSizeLoc = -1;
+};
+
+/**
+ * Hand-off from LUT loader threads to the GL thread.
+ *
+ * Shared with the (detached) loaders so a slow parse may outlive the
+ * renderer. Requests are numbered and only the newest one is delivered;
+ * the GL thread checks `ready` once per frame and only then takes the lock.
+ */
+struct LutMailbox {
+    std::mutex mutex;
+    std::atomic<bool> ready{false};
+    uint64_t latestRequest = 0;
+    std::shared_ptr<const ColorLut3D> lut;     // nullptr = grading off
+};
+
 // Private implementation structure
 struct RendererImpl {
     int previewWidth;
@@ -61,23 +561,232 @@ struct RendererImpl {
     int screenHeight = 0;
 
     GLuint program = 0;
-    GLuint texture = 0;
     GLuint vbo = 0;
 
+    // Upload ring; draw picks the newest slot whose upload has completed
+    GlExtensions glExt;
+    GpuTimer gpuTimer;
+    TextureSlot ring[MAX_TEXTURE_RING];
+    int ringSize = TEXTURE_RING_SIZE;
+    int requestedRingSize = TEXTURE_RING_SIZE;
+    int writeIndex = 0;
+    int displayIndex = -1;
+    uint64_t frameSequence = 0;
+    std::chrono::steady_clock::time_point lastDrawTime;
+
     GLint positionLoc;
     GLint texCoordLoc;
     GLint textureLoc;
+    GLint texTransformLoc;
+
+    // Effective processing/upload size (preview size / downscale)
+    int downscale = 1;
+
+    // Requested output format (each ring slot tracks its allocated format)
+    OutputFormat outputFormat = DEFAULT_OUTPUT_FORMAT;
+
+    // Frame memory; handles are passed around instead of copying pixels
+    std::unique_ptr<FramePool> cameraPool;
+    std::unique_ptr<FramePool> outputPool;
+    FrameHandle latestOutput;       // Most recent processed frame
+
+    // Secondary consumers (recording, export, analytics); declared after the
+    // pools so sink threads are joined before the pools are destroyed
+    SinkRegistry sinks;
 
-    uint8_t* rgbaBuffer = nullptr;
     bool hasFrame = false;
+    uint64_t lastDrawnSequence = 0;
+
+    Hud hud;
+
+    // Multi-stream path; used instead of the ring while extra streams exist
+    Compositor compositor;
+
+    // Color grading. The active LUT is only touched on the GL thread; new
+    // ones arrive through the mailbox.
+    GradeProgram grade;
+    GLuint lutTexture = 0;
+    GLint maxTextureSize = 0;
+    std::shared_ptr<const ColorLut3D> lut;
+    bool lutOnGpu = false;          // lutTexture holds `lut`
+    std::shared_ptr<LutMailbox> lutMailbox = std::make_shared<LutMailbox>();
+
+    // Preview stabilization; the correction travels with each ring slot and
+    // is applied to texture coordinates when the slot is drawn
+    std::atomic<bool> stabilize{STABILIZE};
+    Stabilizer stabilizer;
+    bool stabilizerActive = false;
+    uint64_t stabilizedFrames = 0;
+
+    // People detection; owns its worker thread, boxes are drawn with the HUD
+    std::atomic<bool> detectPeople{DETECT_PEOPLE};
+    PeopleDetector peopleDetector;
+    bool peopleActive = false;
+    int peopleLoggedScans = 0;
+
+    // Contour mode: polylines as GL line strips, one buffer per ring slot,
+    // and a copy of the newest frame's for readers on other threads
+    // (copyContours)
+    ContourLayer contourLayer;
+    std::mutex contourMutex;
+    ContourGeometry contourExport;
+
+    // Hough lines and circles; a slot's buffer is rewritten only when the
+    // transforms have produced a newer result than the one it holds
+    ContourLayer houghLayer;
+    uint64_t houghVersion = 0;
 };
 
+/**
+ * Pick the ring slot for the next upload.
+ *
+ * Skips the slot currently on screen, prefers a slot whose last draw has
+ * finished on the GPU, and otherwise falls back to round-robin order.
+ */
+static int acquireUploadSlot(RendererImpl* impl) {
+    const int count = impl->ringSize;
+    for (int i = 0; i < count; ++i) {
+        const int index = (impl->writeIndex + i) % count;
+        if (count > 1 && index == impl->displayIndex) {
+            continue;
+        }
+        if (pollFence(impl->glExt, impl->ring[index].drawFence)) {
+            impl->writeIndex = (index + 1) % count;
+            return index;
+        }
+    }
+
+    int index = impl->writeIndex;
+    if (count > 1 && index == impl->displayIndex) {
+        index = (index + 1) % count;
+    }
+    impl->writeIndex = (index + 1) % count;
+    return index;
+}
+
+/**
+ * Pick the slot to draw: the newest one whose upload has completed, or the
+ * newest overall if none has (GL ordering still makes that correct).
+ */
+static int selectDrawSlot(RendererImpl* impl) {
+    int newest = -1;
+    int newestReady = -1;
+    for (int i = 0; i < impl->ringSize; ++i) {
+        TextureSlot& slot = impl->ring[i];
+        if (slot.sequence == 0) {
+            continue;
+        }
+        if (newest < 0 || slot.sequence > impl->ring[newest].sequence) {
+            newest = i;
+        }
+        if (pollFence(impl->glExt, slot.uploadFence) &&
+            (newestReady < 0 || slot.sequence > impl->ring[newestReady].sequence)) {
+            newestReady = i;
+        }
+    }
+    return newestReady >= 0 ? newestReady : newest;
+}
+
+static void releaseRing(RendererImpl* impl, bool deleteObjects) {
+    for (TextureSlot& slot : impl->ring) {
+        if (deleteObjects) {
+            if (slot.texture != 0) {
+                glDeleteTextures(1, &slot.texture);
+            }
+            if (impl->glExt.hasFenceSync) {
+                if (slot.uploadFence) impl->glExt.deleteSync(slot.uploadFence);
+                if (slot.drawFence) impl->glExt.deleteSync(slot.drawFence);
+            }
+        }
+        slot = TextureSlot();
+    }
+    impl->writeIndex = 0;
+    impl->displayIndex = -1;
+}
+
+/**
+ * True while extra streams are active and frames go through the compositor.
+ */
+static bool compositing(const RendererImpl* impl) {
+    // Stream 0 alone (or nothing) uses the single-texture ring path
+    const int extra = impl->compositor.streamCount() - (impl->compositor.hasStream(0) ? 1 : 0);
+    return extra > 0;
+}
+
+/**
+ * Upload the active LUT to its texture. LUTs wider than the GL texture
+ * limit (N*N texels) stay CPU-only.
+ */
+static void uploadLutTexture(RendererImpl* impl) {
+    impl->lutOnGpu = false;
+    if (!impl->lut || impl->grade.program == 0) {
+        return;
+    }
+    const ColorLut3D& lut = *impl->lut;
+    if (lut.textureWidth() > impl->maxTextureSize) {
+        LOGI("LUT %d^3 needs a %d-wide texture (max %d); grading on the CPU",
+             lut.size, lut.textureWidth(), impl->maxTextureSize);
+        return;
+    }
+
+    if (impl->lutTexture == 0) {
+        glGenTextures(1, &impl->lutTexture);
+        glBindTexture(GL_TEXTURE_2D, impl->lutTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, impl->lutTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, lut.textureWidth(), lut.textureHeight(), 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, lut.texture.data());
+    impl->lutOnGpu = true;
+}
+
+/**
+ * Take a newly loaded (or cleared) LUT from the mailbox. Called once per
+ * frame on the GL thread; costs one atomic load when nothing changed.
+ */
+static void adoptPendingLut(RendererImpl* impl) {
+    LutMailbox& mailbox = *impl->lutMailbox;
+    if (!mailbox.ready.load(std::memory_order_acquire)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mailbox.mutex);
+        impl->lut = std::move(mailbox.lut);
+        mailbox.ready.store(false, std::memory_order_relaxed);
+    }
+    uploadLutTexture(impl);
+    if (impl->lut) {
+        LOGI("Color grade: '%s' (%d^3, %s)", impl->lut->title.c_str(), impl->lut->size,
+             impl->lutOnGpu ? "GPU" : "CPU");
+    } else {
+        LOGI("Color grade off");
+    }
+}
+
+/**
+ * Make the grade program current with the LUT bound to texture unit 1.
+ */
+static void useGradeProgram(RendererImpl* impl) {
+    glUseProgram(impl->grade.program);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, impl->lutTexture);
+    glUniform1i(impl->grade.lutLoc, 1);
+    glUniform1f(impl->grade.lutSizeLoc, static_cast<GLfloat>(impl->lut->size));
+    glActiveTexture(GL_TEXTURE0);
+}
+
 // Constructor
 Renderer::Renderer(int previewWidth, int previewHeight) {
     impl_ = new RendererImpl();
     impl_->previewWidth = previewWidth;
     impl_->previewHeight = previewHeight;
-    impl_->rgbaBuffer = new uint8_t[previewWidth * previewHeight * 4];
+    impl_->cameraPool.reset(new FramePool(
+            static_cast<size_t>(previewWidth) * previewHeight * 3 / 2, CAMERA_POOL_SIZE, POOL_CAMERA));
+    impl_->outputPool.reset(new FramePool(
+            static_cast<size_t>(previewWidth) * previewHeight * 4, OUTPUT_POOL_SIZE, POOL_OUTPUT));
 
     LOGI("Renderer created: %dx%d", previewWidth, previewHeight);
 }
@@ -89,14 +798,25 @@ Renderer::~Renderer() {
         if (impl_->program != 0) {
             glDeleteProgram(impl_->program);
         }
-        if (impl_->texture != 0) {
-            glDeleteTextures(1, &impl_->texture);
+        if (impl_->grade.program != 0) {
+            glDeleteProgram(impl_->grade.program);
         }
+        if (impl_->lutTexture != 0) {
+            glDeleteTextures(1, &impl_->lutTexture);
+        }
+        releaseRing(impl_, true);
+        hudDestroy(impl_->hud);
+        impl_->gpuTimer.release(true);
+        impl_->compositor.release(true);
+        impl_->contourLayer.release(true);
+        impl_->houghLayer.release(true);
         if (impl_->vbo != 0) {
             glDeleteBuffers(1, &impl_->vbo);
         }
 
-        delete[] impl_->rgbaBuffer;
+        // Handles must be released before the pools they came from
+        impl_->sinks.removeAll();
+        impl_->latestOutput.reset();
         delete impl_;
     }
 
@@ -106,45 +826,54 @@ Renderer::~Renderer() {
 void Renderer::onSurfaceCreated() {
     LOGI("onSurfaceCreated");
 
-    // Compile shaders
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-
-    // Link program
-    impl_->program = glCreateProgram();
-    glAttachShader(impl_->program, vertexShader);
-    glAttachShader(impl_->program, fragmentShader);
-    glLinkProgram(impl_->program);
+    // Compile and link shaders
+    impl_->program = linkProgram(vertexShaderSource, fragmentShaderSource);
 
-    // Check link status
-    GLint linkStatus = 0;
-    glGetProgramiv(impl_->program, GL_LINK_STATUS, &linkStatus);
-    if (linkStatus != GL_TRUE) {
-        GLchar log[512];
-        glGetProgramInfoLog(impl_->program, 512, nullptr, log);
-        LOGE("Shader link failed: %s", log);
-    }
-
-    // Clean up shaders
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // Resolve optional features (fence sync, timer queries) for this context
+    loadGlExtensions(impl_->glExt);
+    impl_->gpuTimer.init(impl_->glExt);
 
     // Get attribute/uniform locations
     impl_->positionLoc = glGetAttribLocation(impl_->program, "a_position");
     impl_->texCoordLoc = glGetAttribLocation(impl_->program, "a_texCoord");
     impl_->textureLoc = glGetUniformLocation(impl_->program, "u_texture");
+    impl_->texTransformLoc = glGetUniformLocation(impl_->program, "u_texTransform");
 
-    // Create texture
-    glGenTextures(1, &impl_->texture);
-    glBindTexture(GL_TEXTURE_2D, impl_->texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GradeProgram& grade = impl_->grade;
+    grade.program = linkProgram(vertexShaderSource, gradeFragmentShaderSource);
+    grade.positionLoc = glGetAttribLocation(grade.program, "a_position");
+    grade.texCoordLoc = glGetAttribLocation(grade.program, "a_texCoord");
+    grade.textureLoc = glGetUniformLocation(grade.program, "u_texture");
+    grade.texTransformLoc = glGetUniformLocation(grade.program, "u_texTransform");
+    grade.lutLoc = glGetUniformLocation(grade.program, "u_lut");
+    grade.lutSizeLoc = glGetUniformLocation(grade.program, "u_lutSize");
+
+    // The previous context's LUT texture is gone; re-upload the active grade
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &impl_->maxTextureSize);
+    impl_->lutTexture = 0;
+    uploadLutTexture(impl_);
+
+    // Create texture ring (previous context's objects are already gone)
+    releaseRing(impl_, false);
+    impl_->ringSize = std::min(std::max(impl_->requestedRingSize, 1), MAX_TEXTURE_RING);
+    for (int i = 0; i < impl_->ringSize; ++i) {
+        TextureSlot& slot = impl_->ring[i];
+        glGenTextures(1, &slot.texture);
+        glBindTexture(GL_TEXTURE_2D, slot.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    // Allocate texture storage
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, impl_->previewWidth, impl_->previewHeight,
-                 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        // Allocate texture storage at the current effective size
+        slot.width = impl_->previewWidth / impl_->downscale;
+        slot.height = impl_->previewHeight / impl_->downscale;
+        slot.format = impl_->outputFormat;
+        allocateOutputTexture(slot.width, slot.height, slot.format);
+    }
+    impl_->hasFrame = false;
+    LOGI("Texture ring: %d slot(s), fences %s", impl_->ringSize,
+         impl_->glExt.hasFenceSync ? "on" : "off");
 
     // Create VBO for fullscreen quad
     GLfloat quadVertices[] = {
@@ -159,6 +888,18 @@ void Renderer::onSurfaceCreated() {
     glBindBuffer(GL_ARRAY_BUFFER, impl_->vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 
+    // HUD resources are cheap; create them so the HUD can be toggled at runtime
+    const bool hudEnabled = impl_->hud.enabled;
+    impl_->hud = Hud();
+    impl_->hud.enabled = hudEnabled;
+    hudCreate(impl_->hud);
+
+    impl_->compositor.onSurfaceCreated();
+    impl_->contourLayer.onSurfaceCreated(ContourParams().maxVertices, impl_->ringSize);
+    impl_->houghLayer.onSurfaceCreated(HOUGH_LAYER_VERTICES, impl_->ringSize);
+    impl_->houghLayer.setColor(0.2f, 0.9f, 1.0f, 1.0f);
+    impl_->houghLayer.setLineWidth(3.0f);
+
     LOGI("OpenGL setup complete");
 }
 
@@ -166,65 +907,594 @@ void Renderer::onSurfaceChanged(int width, int height) {
     LOGI("onSurfaceChanged: %dx%d", width, height);
     impl_->screenWidth = width;
     impl_->screenHeight = height;
+    impl_->compositor.setViewport(width, height);
     glViewport(0, 0, width, height);
 }
 
-void Renderer::onCameraFrame(const uint8_t* nv21Data, int width, int height) {
-    if (width != impl_->previewWidth || height != impl_->previewHeight) {
+void Renderer::setTextureRingSize(int count) {
+    LOGI("Texture ring size: %d (applied on next onSurfaceCreated)", count);
+    impl_->requestedRingSize = count;
+}
+
+void Renderer::setHudEnabled(bool enabled) {
+    impl_->hud.enabled = enabled;
+}
+
+void Renderer::setStabilizationEnabled(bool enabled) {
+    LOGI("Stabilization %s", enabled ? "on" : "off");
+    impl_->stabilize.store(enabled, std::memory_order_relaxed);
+}
+
+void Renderer::setPeopleDetectionEnabled(bool enabled) {
+    LOGI("People detection %s", enabled ? "on" : "off");
+    impl_->detectPeople.store(enabled, std::memory_order_relaxed);
+}
+
+int Renderer::copyContours(float* vertices, int vertexCapacity, int* counts, int countCapacity) {
+    std::lock_guard<std::mutex> lock(impl_->contourMutex);
+    const ContourGeometry& geometry = impl_->contourExport;
+    int strips = 0;
+    int used = 0;
+    for (int count : geometry.stripCounts) {
+        if (strips >= countCapacity || used + count > vertexCapacity) {
+            break;
+        }
+        std::memcpy(vertices + used * 2, &geometry.vertices[used], count * sizeof(cv::Point2f));
+        counts[strips++] = count;
+        used += count;
+    }
+    return strips;
+}
+
+int Renderer::addSink(std::shared_ptr<FrameSink> sink, SinkDropPolicy policy, int queueDepth) {
+    return impl_->sinks.addSink(std::move(sink), policy, queueDepth, SINK_OUTPUT_BUFFERS);
+}
+
+void Renderer::removeSink(int sinkId) {
+    impl_->sinks.removeSink(sinkId);
+}
+
+bool Renderer::sinkStats(int sinkId, SinkStats& out) const {
+    return impl_->sinks.sinkStats(sinkId, out);
+}
+
+void Renderer::loadColorLut(const std::string& path) {
+    std::shared_ptr<LutMailbox> mailbox = impl_->lutMailbox;
+    uint64_t request;
+    {
+        std::lock_guard<std::mutex> lock(mailbox->mutex);
+        request = ++mailbox->latestRequest;
+    }
+
+    // Parsing a large cube takes tens of milliseconds; keep it off the
+    // frame path. The current grade stays active until the new one lands.
+    std::thread([mailbox, path, request]() {
+        std::string error;
+        std::shared_ptr<const ColorLut3D> lut = loadCubeLut(path, &error);
+        if (!lut) {
+            LOGE("loadColorLut: %s: %s", path.c_str(), error.c_str());
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mailbox->mutex);
+        if (request != mailbox->latestRequest) {
+            return;     // Superseded by a later load or clear
+        }
+        mailbox->lut = std::move(lut);
+        mailbox->ready.store(true, std::memory_order_release);
+    }).detach();
+}
+
+void Renderer::clearColorLut() {
+    LutMailbox& mailbox = *impl_->lutMailbox;
+    std::lock_guard<std::mutex> lock(mailbox.mutex);
+    ++mailbox.latestRequest;
+    mailbox.lut.reset();
+    mailbox.ready.store(true, std::memory_order_release);
+}
+
+void Renderer::loadReferenceSet(const std::string& dbPath) {
+    // Mapping the database and hashing it into the LSH tables takes a while
+    // for large sets; processing only sees the finished recognizer
+    std::thread([dbPath]() {
+        auto recognizer = std::make_shared<Recognizer>();
+        std::string error;
+        try {
+            if (!recognizer->load(dbPath, RecognitionParams(), &error)) {
+                LOGE("loadReferenceSet: %s", error.c_str());
+                return;
+            }
+        } catch (const cv::Exception& e) {
+            LOGE("loadReferenceSet: %s", e.what());
+            return;
+        }
+        processorSetRecognizer(std::move(recognizer));
+    }).detach();
+}
+
+void Renderer::clearReferenceSet() {
+    processorSetRecognizer(nullptr);
+}
+
+void Renderer::resetPanorama() {
+    processorResetPanorama();
+}
+
+void Renderer::savePanorama(const std::string& path) {
+    // The snapshot is one copy under the panorama lock; encoding runs after
+    std::thread([path]() {
+        cv::Mat rgba;
+        if (!processorPanoramaSnapshot(rgba)) {
+            LOGE("savePanorama: no panorama yet");
+            return;
+        }
+        cv::Mat bgr;
+        cv::cvtColor(rgba, bgr, cv::COLOR_RGBA2BGR);
+        try {
+            if (!cv::imwrite(path, bgr)) {
+                LOGE("savePanorama: cannot write %s", path.c_str());
+                return;
+            }
+        } catch (const cv::Exception& e) {
+            LOGE("savePanorama: %s", e.what());
+            return;
+        }
+        LOGI("Panorama saved: %s (%dx%d)", path.c_str(), bgr.cols, bgr.rows);
+    }).detach();
+}
+
+void Renderer::resetCalibration() {
+    processorResetCalibration();
+}
+
+void Renderer::loadCalibration(const std::string& path) {
+    std::thread([path]() {
+        std::string error;
+        std::shared_ptr<CameraCalibration> calibration = ::loadCalibration(path, &error);
+        if (!calibration) {
+            LOGE("loadCalibration: %s", error.c_str());
+            return;
+        }
+        LOGI("Calibration loaded: %s (%dx%d, RMS %.3f px)", path.c_str(),
+             calibration->imageSize.width, calibration->imageSize.height, calibration->rms);
+        processorSetCalibration(std::move(calibration));
+    }).detach();
+}
+
+void Renderer::saveCalibration(const std::string& path) {
+    std::shared_ptr<const CameraCalibration> calibration = processorCalibration();
+    if (!calibration) {
+        LOGE("saveCalibration: not calibrated yet");
+        return;
+    }
+    std::thread([path, calibration]() {
+        std::string error;
+        if (!::saveCalibration(*calibration, path, &error)) {
+            LOGE("saveCalibration: %s", error.c_str());
+            return;
+        }
+        LOGI("Calibration saved: %s", path.c_str());
+    }).detach();
+}
+
+void Renderer::clearCalibration() {
+    processorSetCalibration(nullptr);
+}
+
+void Renderer::loadTemplate(const std::string& path) {
+    std::thread([path]() {
+        cv::Mat gray;
+        try {
+            gray = cv::imread(path, cv::IMREAD_GRAYSCALE);
+        } catch (const cv::Exception& e) {
+            LOGE("loadTemplate: %s", e.what());
+            return;
+        }
+        if (gray.empty()) {
+            LOGE("loadTemplate: cannot read %s", path.c_str());
+            return;
+        }
+        const size_t slash = path.find_last_of('/');
+        std::string error;
+        std::shared_ptr<TemplatePyramid> pyramid =
+                buildTemplatePyramid(gray, slash == std::string::npos ? path : path.substr(slash + 1), &error);
+        if (!pyramid) {
+            LOGE("loadTemplate: %s: %s", path.c_str(), error.c_str());
+            return;
+        }
+        LOGI("Template loaded: %s (%dx%d, %zu levels)", path.c_str(), gray.cols, gray.rows,
+             pyramid->levels.size());
+        processorSetTemplate(std::move(pyramid));
+    }).detach();
+}
+
+void Renderer::clearTemplate() {
+    processorSetTemplate(nullptr);
+}
+
+void Renderer::setOutputFormat(OutputFormat format) {
+    LOGI("Output format: %s", format == OUTPUT_RGB565 ? "RGB565" : "RGBA8888");
+    impl_->outputFormat = format;
+    impl_->compositor.setOutputFormat(format);
+}
+
+/**
+ * Extra streams go straight to the compositor. Only the stream that
+ * delivered a frame is processed and uploaded; drawing stays one call.
+ */
+void Renderer::onStreamFrame(int streamId, const uint8_t* nv21Data, int width, int height) {
+    if (streamId <= 0) {
+        LOGE("onStreamFrame: stream 0 is the camera preview, use onCameraFrame");
+        return;
+    }
+    if (impl_->compositor.updateStream(streamId, nv21Data, width, height)) {
+        impl_->hasFrame = true;
+    }
+}
+
+void Renderer::removeStream(int streamId) {
+    if (streamId <= 0) {
+        return;
+    }
+    impl_->compositor.removeStream(streamId);
+
+    // Back to the single-stream path once only the camera preview is left
+    if (!compositing(impl_)) {
+        impl_->compositor.removeStream(0);
+    }
+}
+
+void Renderer::setCompositeLayout(CompositeLayout layout) {
+    impl_->compositor.setLayout(layout);
+}
+/**
+ * Log per-scale scan times and the effective detection rate every
+ * PEOPLE_LOG_SCANS scans.
+ */
+static void logPeopleDetection(RendererImpl* impl) {
+    const PeopleStatus status = impl->peopleDetector.status();
+    if (status.scans < impl->peopleLoggedScans + PEOPLE_LOG_SCANS) {
+        return;
+    }
+    impl->peopleLoggedScans = status.scans;
+
+    // Empty when no window fits the detect size
+    char scales[256] = "";
+    int len = 0;
+    for (size_t i = 0; i < status.scales.size() && len < static_cast<int>(sizeof(scales)) - 1; ++i) {
+        const int written = std::snprintf(scales + len, sizeof(scales) - len, " %.2f:%.1f",
+                                          status.scales[i], status.scaleMs[i]);
+        if (written < 0) {
+            break;
+        }
+        // snprintf returns the untruncated length
+        len = std::min(len + written, static_cast<int>(sizeof(scales)) - 1);
+    }
+    LOGI("People: %zu tracked, %d seen; scan %.1f ms at %dx%d, %.1f scans/s; scale:ms%s",
+         status.tracks.size(), status.peopleSeen, status.scanMs, status.detectSize.width,
+         status.detectSize.height, status.scanIntervalMs > 0.0 ? 1000.0 / status.scanIntervalMs : 0.0,
+         scales);
+}
+
+/**
+ * Process one NV21 frame into a pooled output buffer and upload it.
+ */
+static void processAndUpload(RendererImpl* impl, const uint8_t* nv21Data,
+                             int width, int height, int64_t timestampNs) {
+    if (width != impl->previewWidth || height != impl->previewHeight) {
         LOGE("Frame size mismatch: expected %dx%d, got %dx%d",
-             impl_->previewWidth, impl_->previewHeight, width, height);
+             impl->previewWidth, impl->previewHeight, width, height);
         return;
     }
 
-    // Process frame with OpenCV
-    processFrame(nv21Data, width, height, impl_->rgbaBuffer);
+    // Multi-stream mode: the camera preview is stream 0 of the composite
+    if (compositing(impl)) {
+        impl->compositor.updateStream(0, nv21Data, width, height);
+        statsFrameDone();
+        return;
+    }
 
-    // Upload to texture
-    glBindTexture(GL_TEXTURE_2D, impl_->texture);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // Stabilization and people detection see the Y plane in the processed
+    // frame's geometry (undistorted while a calibration is installed), so
+    // their results line up with the image they are drawn over
+    const bool stabilize = impl->stabilize.load(std::memory_order_relaxed);
+    const bool detectPeople = impl->detectPeople.load(std::memory_order_relaxed);
+    cv::Mat luma;
+    if (stabilize || detectPeople) {
+        luma = processorPreviewLuma(nv21Data, width, height);
+    }
+
+    // Track every frame, including ones dropped below, so the path stays
+    // continuous
+    if (stabilize) {
+        {
+            ScopedStatTimer timer(STAT_STABILIZE);
+            impl->stabilizer.update(luma);
+        }
+        if (++impl->stabilizedFrames % STABILIZE_LOG_INTERVAL == 0) {
+            LOGI("Stabilization: %.2f ms per frame, %d points, no frames held back "
+                 "(smoothed path lags ~%.1f frames)", statsAverageMs(STAT_STABILIZE),
+                 impl->stabilizer.trackedPoints(), impl->stabilizer.pathLagFrames());
+        }
+    } else if (impl->stabilizerActive) {
+        impl->stabilizer.reset();
+    }
+    impl->stabilizerActive = stabilize;
+
+    // The people detector copies the luma only when its worker is idle;
+    // scanning never holds up this thread
+    if (detectPeople) {
+        impl->peopleDetector.set(PEOPLE);
+        impl->peopleDetector.submit(luma);
+        logPeopleDetection(impl);
+    } else if (impl->peopleActive) {
+        impl->peopleDetector.reset();
+        impl->peopleLoggedScans = 0;
+    }
+    impl->peopleActive = detectPeople;
+
+    // Process and upload no more pixels than the viewport can show
+    impl->downscale = processorChooseDownscale(width, height,
+                                                impl->screenWidth, impl->screenHeight);
+    const int outWidth = width / impl->downscale;
+    const int outHeight = height / impl->downscale;
+    const OutputFormat format = impl->outputFormat;
+
+    // Output goes to a pooled buffer; if consumers still hold every buffer,
+    // drop this frame rather than block or allocate
+    FrameHandle output = impl->outputPool->acquire();
+    if (!output) {
+        statsAddDroppedFrames(1);
+        return;
+    }
+    output->width = outWidth;
+    output->height = outHeight;
+    output->format = format == OUTPUT_RGB565 ? FRAME_RGB565 : FRAME_RGBA8888;
+    output->timestampNs = timestampNs;
+
+    // Grade in the fragment shader unless the pixels themselves must carry
+    // it (sinks see the CPU buffer) or the LUT is too large for a texture
+    const bool gradeOnCpu = impl->lut && (!impl->lutOnGpu || impl->sinks.sinkCount() > 0);
 
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, impl_->previewWidth, impl_->previewHeight,
-                    GL_RGBA, GL_UNSIGNED_BYTE, impl_->rgbaBuffer);
+    // Process frame with OpenCV (final pack stage writes the upload format)
+    processFrame(nv21Data, width, height, output->data, impl->downscale, format,
+                 gradeOnCpu ? impl->lut.get() : nullptr);
 
-    impl_->hasFrame = true;  // Mark that we have valid frame data
+    // Contour mode: keep a copy for readers on other threads; the vertices
+    // go to the GPU with the slot's texture below
+    const ContourGeometry* contours = processorContours();
+    if (contours) {
+        std::lock_guard<std::mutex> lock(impl->contourMutex);
+        impl->contourExport = *contours;
+    }
+    const HoughResult* hough = processorHough();
+    if (hough && hough->fresh) {
+        ++impl->houghVersion;
+    }
+
+    // Hand the finished frame to the sinks before the upload so their work
+    // overlaps ours; the buffer is read-only from here on
+    impl->sinks.publish(output);
+
+    // Upload to the next free texture in the ring
+    const int slotIndex = acquireUploadSlot(impl);
+    TextureSlot& slot = impl->ring[slotIndex];
+    glBindTexture(GL_TEXTURE_2D, slot.texture);
+
+    // Reallocate texture storage only when the effective size or format changes
+    if (outWidth != slot.width || outHeight != slot.height || format != slot.format) {
+        LOGI("Texture %d resize: %dx%d -> %dx%d (downscale %d, %s)", slotIndex,
+             slot.width, slot.height, outWidth, outHeight, impl->downscale,
+             format == OUTPUT_RGB565 ? "RGB565" : "RGBA8888");
+        slot.width = outWidth;
+        slot.height = outHeight;
+        slot.format = format;
+        allocateOutputTexture(outWidth, outHeight, format);
+    }
+
+    {
+        ScopedStatTimer timer(STAT_UPLOAD);
+        ScopedGpuTimer gpuTimer(impl->gpuTimer, GPU_UPLOAD);
+        uploadOutputTexture(0, 0, outWidth, outHeight, format, output->data);
+    }
+
+    // Line buffers travel with the slot, so they match the texture they are
+    // drawn over and are only rewritten once the slot's last draw finished
+    if (contours) {
+        {
+            ScopedStatTimer timer(STAT_CONTOUR_UPLOAD);
+            impl->contourLayer.upload(slotIndex, *contours);
+        }
+        statsAddUploadBytes(impl->contourLayer.uploadedBytes());
+    }
+    if (hough && slot.houghVersion != impl->houghVersion) {
+        impl->houghLayer.upload(slotIndex, hough->overlay);
+        statsAddUploadBytes(impl->houghLayer.uploadedBytes());
+        slot.houghVersion = impl->houghVersion;
+    }
+    replaceFence(impl->glExt, slot.uploadFence);
+    slot.sequence = ++impl->frameSequence;
+    slot.gpuGrade = impl->lut && !gradeOnCpu;
+    if (stabilize) {
+        // Column-major for glUniformMatrix3fv
+        const cv::Matx33f& m = impl->stabilizer.textureTransform();
+        for (int col = 0; col < 3; ++col) {
+            for (int row = 0; row < 3; ++row) {
+                slot.texTransform[col * 3 + row] = m(row, col);
+            }
+        }
+    } else {
+        std::memcpy(slot.texTransform, IDENTITY_TRANSFORM, sizeof(IDENTITY_TRANSFORM));
+    }
+
+    statsAddUploadBytes(static_cast<uint64_t>(outWidth) * outHeight * outputBytesPerPixel(format));
+    statsFrameDone();
+    impl->sinks.logStats();
+
+    impl->latestOutput = std::move(output);
+    impl->hasFrame = true;  // Mark that we have valid frame data
 }
 
-void Renderer::onDrawFrame() {
-    // Clear screen
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+FrameHandle Renderer::acquireCameraFrame() {
+    FrameHandle frame = impl_->cameraPool->acquire();
+    if (frame) {
+        frame->width = impl_->previewWidth;
+        frame->height = impl_->previewHeight;
+        frame->format = FRAME_NV21;
+    }
+    return frame;
+}
 
-    // FIXED: Only skip if we've NEVER received a frame
-    // Once hasFrame is true, it stays true
-    if (!impl_->hasFrame) {
+void Renderer::onCameraFrame(const FrameHandle& frame) {
+    if (!frame || frame->format != FRAME_NV21) {
+        LOGE("onCameraFrame: invalid frame handle");
         return;
     }
+    processAndUpload(impl_, frame->data, frame->width, frame->height, frame->timestampNs);
+}
+
+void Renderer::onCameraFrame(const uint8_t* nv21Data, int width, int height) {
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    processAndUpload(impl_, nv21Data, width, height, now);
+}
+
+/**
+ * Draw the newest completed texture of the upload ring as a fullscreen quad.
+ */
+static void drawRingFrame(RendererImpl* impl) {
+    const int slotIndex = selectDrawSlot(impl);
+    if (slotIndex < 0) {
+        return;
+    }
+    TextureSlot& slot = impl->ring[slotIndex];
+    impl->displayIndex = slotIndex;
+
+    // Frames uploaded after the last drawn one but superseded before display
+    if (slot.sequence > impl->lastDrawnSequence + 1 && impl->lastDrawnSequence != 0) {
+        statsAddDroppedFrames(slot.sequence - impl->lastDrawnSequence - 1);
+    }
+    impl->lastDrawnSequence = std::max(impl->lastDrawnSequence, slot.sequence);
+
+    // Use shader program (the grading variant if the frame was not graded
+    // on the CPU and a LUT is still active)
+    GLint positionLoc = impl->positionLoc;
+    GLint texCoordLoc = impl->texCoordLoc;
+    GLint textureLoc = impl->textureLoc;
+    GLint texTransformLoc = impl->texTransformLoc;
+    if (slot.gpuGrade && impl->lutOnGpu) {
+        useGradeProgram(impl);
+        positionLoc = impl->grade.positionLoc;
+        texCoordLoc = impl->grade.texCoordLoc;
+        textureLoc = impl->grade.textureLoc;
+        texTransformLoc = impl->grade.texTransformLoc;
+    } else {
+        glUseProgram(impl->program);
+    }
 
-    // Use shader program
-    glUseProgram(impl_->program);
+    // Stabilization correction of this frame (identity when off)
+    glUniformMatrix3fv(texTransformLoc, 1, GL_FALSE, slot.texTransform);
 
     // Bind texture
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, impl_->texture);
-    glUniform1i(impl_->textureLoc, 0);
+    glBindTexture(GL_TEXTURE_2D, slot.texture);
+    glUniform1i(textureLoc, 0);
 
     // Bind VBO and set up vertex attributes
-    glBindBuffer(GL_ARRAY_BUFFER, impl_->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, impl->vbo);
 
     // Position attribute
-    glEnableVertexAttribArray(impl_->positionLoc);
-    glVertexAttribPointer(impl_->positionLoc, 2, GL_FLOAT, GL_FALSE,
+    glEnableVertexAttribArray(positionLoc);
+    glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE,
                           4 * sizeof(GLfloat), (void*)0);
 
     // Texture coordinate attribute
-    glEnableVertexAttribArray(impl_->texCoordLoc);
-    glVertexAttribPointer(impl_->texCoordLoc, 2, GL_FLOAT, GL_FALSE,
+    glEnableVertexAttribArray(texCoordLoc);
+    glVertexAttribPointer(texCoordLoc, 2, GL_FLOAT, GL_FALSE,
                           4 * sizeof(GLfloat), (void*)(2 * sizeof(GLfloat)));
 
     // Draw fullscreen quad
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    {
+        ScopedGpuTimer gpuTimer(impl->gpuTimer, GPU_DRAW);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
 
     // Clean up
-    glDisableVertexAttribArray(impl_->positionLoc);
-    glDisableVertexAttribArray(impl_->texCoordLoc);
+    glDisableVertexAttribArray(positionLoc);
+    glDisableVertexAttribArray(texCoordLoc);
+
+    // The slot's own line buffers, before the fence that releases them
+    const bool contours = processorContours() != nullptr;
+    const bool hough = processorHough() != nullptr;
+    if (contours || hough) {
+        ScopedGpuTimer gpuTimer(impl->gpuTimer, GPU_LINES);
+        if (contours) {
+            impl->contourLayer.draw(slotIndex, slot.texTransform);
+        }
+        if (hough) {
+            impl->houghLayer.draw(slotIndex, slot.texTransform);
+        }
+    }
+
+    // The slot may be reused for upload once this draw has finished reading it
+    replaceFence(impl->glExt, slot.drawFence);
+}
+
+void Renderer::onDrawFrame() {
+    // Clear screen
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // A newly loaded grade takes effect at this frame boundary
+    adoptPendingLut(impl_);
+
+    // FIXED: Only skip if we've NEVER received a frame
+    // Once hasFrame is true, it stays true
+    if (!impl_->hasFrame) {
+        return;
+    }
+
+    // Results from queries issued one or two frames ago
+    impl_->gpuTimer.collect();
+
+    // Draw-to-draw interval; its jitter shows upload-induced stalls
+    const auto now = std::chrono::steady_clock::now();
+    if (impl_->lastDrawTime.time_since_epoch().count() != 0) {
+        statsRecord(STAT_DRAW_INTERVAL,
+                    std::chrono::duration<double, std::milli>(now - impl_->lastDrawTime).count());
+    }
+    impl_->lastDrawTime = now;
+
+    if (compositing(impl_)) {
+        ScopedGpuTimer gpuTimer(impl_->gpuTimer, GPU_DRAW);
+        if (impl_->lutOnGpu) {
+            // Composited streams are only graded on the GPU
+            useGradeProgram(impl_);
+            glUniformMatrix3fv(impl_->grade.texTransformLoc, 1, GL_FALSE, IDENTITY_TRANSFORM);
+            impl_->compositor.draw(impl_->grade.program, impl_->grade.positionLoc,
+                                   impl_->grade.texCoordLoc, impl_->grade.textureLoc);
+        } else {
+            // Composited streams are not stabilized
+            glUseProgram(impl_->program);
+            glUniformMatrix3fv(impl_->texTransformLoc, 1, GL_FALSE, IDENTITY_TRANSFORM);
+            impl_->compositor.draw(impl_->program, impl_->positionLoc,
+                                   impl_->texCoordLoc, impl_->textureLoc);
+        }
+    } else {
+        drawRingFrame(impl_);
+    }
+
+    // Overlays share the HUD's batch: people boxes, then the stats panel
+    hudBegin(impl_->hud, impl_->screenWidth, impl_->screenHeight);
+    if (impl_->peopleActive && !compositing(impl_) && impl_->displayIndex >= 0) {
+        hudPeople(impl_->hud, impl_->peopleDetector.status().tracks,
+                  impl_->ring[impl_->displayIndex].texTransform);
+    }
+    if (impl_->hud.enabled) {
+        ScopedStatTimer timer(STAT_HUD);
+        hudBuild(impl_->hud);
+    }
+    if (!impl_->hud.vertices.empty()) {
+        ScopedGpuTimer gpuTimer(impl_->gpuTimer, GPU_HUD);
+        hudDraw(impl_->hud);
+    }
 }
\ No newline at end of file
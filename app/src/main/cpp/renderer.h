@@ -3,6 +3,11 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
+#include "processor.h"
+#include "compositor.h"
+#include "frame_pool.h"
+#include "frame_sink.h"
 
 // Forward declare implementation structure
 struct RendererImpl;
@@ -19,8 +24,84 @@ public:
     void onSurfaceCreated();
     void onSurfaceChanged(int width, int height);
     void onCameraFrame(const uint8_t* nv21Data, int width, int height);
+
+    // Zero-copy input path: take a pooled NV21 buffer (empty handle when the
+    // pool is exhausted), fill it, and pass the handle back in.
+    FrameHandle acquireCameraFrame();
+    void onCameraFrame(const FrameHandle& frame);
     void onDrawFrame();
 
+    // Pixel format for processing output and texture upload.
+    // RGB565 halves upload bandwidth on constrained devices.
+    void setOutputFormat(OutputFormat format);
+
+    // Number of textures in the upload ring (1-4), applied on the next
+    // onSurfaceCreated(). Defaults to TEXTURE_RING_SIZE in renderer.cpp.
+    void setTextureRingSize(int count);
+
+    // Additional camera streams (ids 1..Compositor::MAX_STREAMS-1). While any
+    // is active, onCameraFrame feeds stream 0 and all streams are composited.
+    void onStreamFrame(int streamId, const uint8_t* nv21Data, int width, int height);
+    void removeStream(int streamId);
+    void setCompositeLayout(CompositeLayout layout);
+
+    // Film-style color grade from a .cube 3D LUT. The file is parsed on a
+    // background thread and the new grade takes over at a frame boundary;
+    // the previous one stays active until then. Applied in the fragment
+    // shader, or on the CPU while sinks need graded pixels.
+    void loadColorLut(const std::string& path);
+    void clearColorLut();
+
+    // Reference set for the recognition mode, built offline with
+    // Recognizer::build(). Mapped and indexed on a background thread; frames
+    // keep using the previous set (if any) until it is ready.
+    void loadReferenceSet(const std::string& dbPath);
+    void clearReferenceSet();
+
+    // Panorama mode: start a new sweep, or write the panorama built so far
+    // to an image file (format from the extension) on a background thread.
+    void resetPanorama();
+    void savePanorama(const std::string& path);
+
+    // Camera calibration (calibration mode and undistortion stage). Files
+    // are OpenCV FileStorage (.yml/.xml/.json) and are read and written on
+    // a background thread. Loading installs the undistortion; clearing
+    // removes it.
+    void resetCalibration();
+    void loadCalibration(const std::string& path);
+    void saveCalibration(const std::string& path);
+    void clearCalibration();
+
+    // Template for the template-matching mode: an image file of the logo or
+    // fiducial as it appears at camera resolution. Decoded and its pyramid
+    // built on a background thread.
+    void loadTemplate(const std::string& path);
+    void clearTemplate();
+
+    // On-screen performance HUD (stage bars, FPS sparkline, dropped frames)
+    void setHudEnabled(bool enabled);
+
+    // Stabilize the displayed preview. The correction is applied to texture
+    // coordinates when drawing; processed pixels (and sinks) are unchanged.
+    void setStabilizationEnabled(bool enabled);
+
+    // Detect and track people (HOG) on a worker thread and outline them
+    // over the preview; processed pixels (and sinks) are unchanged.
+    void setPeopleDetectionEnabled(bool enabled);
+
+    // Contour mode: copy the polylines of the newest processed frame
+    // (x, y pairs in normalized frame coordinates, y down; strips back to
+    // back with their vertex counts). Returns the number of strips written;
+    // strips that do not fit the buffers are left out. Thread-safe.
+    int copyContours(float* vertices, int vertexCapacity, int* counts, int countCapacity);
+
+    // Extra consumers of every processed frame, each on its own thread.
+    // Returns -1 when the sink's queue would not fit in the buffers
+    // reserved for sinks. Composited frames are not published.
+    int addSink(std::shared_ptr<FrameSink> sink, SinkDropPolicy policy, int queueDepth = 2);
+    void removeSink(int sinkId);
+    bool sinkStats(int sinkId, SinkStats& out) const;
+
 private:
     RendererImpl* impl_;
 };
@@ -0,0 +1,165 @@
+#include "stabilizer.h"
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "Stabilizer"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+/**
+ * stabilizer.cpp - LK tracking, similarity fit, causal path smoothing.
+ *
+ * Motion: corners found with goodFeaturesToTrack on the previous analysis
+ * frame are tracked into the current one. Points that survive are reused
+ * for the next frame, and detection only runs again once fewer than
+ * minCorners remain. That keeps the per-frame cost at roughly one LK pass
+ * over a 320 px image. The RANSAC similarity is re-expressed about the
+ * image center, so that rotation and translation stay independent.
+ *
+ * Path: p_t = p_(t-1) + motion_t, and s_t = k * s_(t-1) + (1 - k) * p_t.
+ * The correction s_t - p_t is clamped to what the crop margin can hide.
+ * After clamping, s_t is pulled back to p_t + correction, so a long pan
+ * does not leave the filter stuck at the margin.
+ *
+ * Display: with W the correction about the image center and Z the crop
+ * zoom, the screen shows Z * W * frame. The sampling transform is therefore
+ * (Z * W)^-1, rescaled from analysis pixels to normalized texture
+ * coordinates.
+ */
+
+static const int LK_WINDOW = 21;
+static const int LK_LEVELS = 3;
+static const double RANSAC_THRESHOLD = 2.0;     // Analysis pixels
+static const int MIN_MOTION_POINTS = 12;
+static const double MAX_LOG_SCALE = 0.05;
+
+void Stabilizer::set(const StabilizeParams& params) {
+    StabilizeParams clamped = params;
+    clamped.analysisWidth = std::max(clamped.analysisWidth, 64);
+    clamped.maxCorners = std::max(clamped.maxCorners, MIN_MOTION_POINTS * 2);
+    clamped.minCorners = std::min(std::max(clamped.minCorners, MIN_MOTION_POINTS), clamped.maxCorners);
+    clamped.smoothing = std::min(std::max(clamped.smoothing, 0.0f), 0.99f);
+    clamped.cropRatio = std::min(std::max(clamped.cropRatio, 0.5f), 1.0f);
+    clamped.maxAngle = std::max(clamped.maxAngle, 0.0f);
+    if (configured_ && clamped == params_) {
+        return;
+    }
+    params_ = clamped;
+    configured_ = true;
+    reset();
+    LOGI("Stabilizer: %d px analysis, smoothing %.2f (path lag ~%.1f frames), crop %.0f%%",
+         params_.analysisWidth, params_.smoothing, pathLagFrames(), params_.cropRatio * 100.0f);
+}
+
+void Stabilizer::reset() {
+    prev_.release();
+    prevPoints_.clear();
+    to_.clear();
+    trackedPoints_ = 0;
+    path_ = cv::Vec4d();
+    smooth_ = cv::Vec4d();
+    correction_ = cv::Vec4d();
+    textureTransform_ = cv::Matx33f::eye();
+}
+
+bool Stabilizer::update(const cv::Mat& luma) {
+    CV_Assert(luma.type() == CV_8UC1);
+    if (!configured_) {
+        set(params_);
+    }
+
+    const int width = std::min(params_.analysisWidth, luma.cols);
+    const cv::Size size(width, std::max(cvRound(static_cast<double>(luma.rows) * width / luma.cols), 1));
+    if (size == luma.size()) {
+        luma.copyTo(curr_);
+    } else {
+        cv::resize(luma, curr_, size, 0, 0, cv::INTER_AREA);
+    }
+    if (prev_.size() != curr_.size()) {
+        reset();
+    }
+
+    // Frame-to-frame motion about the image center: dx, dy, angle, log scale
+    cv::Vec4d motion;
+    bool tracked = false;
+    from_.clear();
+    to_.clear();
+    if (static_cast<int>(prevPoints_.size()) >= MIN_MOTION_POINTS) {
+        cv::calcOpticalFlowPyrLK(prev_, curr_, prevPoints_, currPoints_, status_, error_,
+                                 cv::Size(LK_WINDOW, LK_WINDOW), LK_LEVELS);
+        for (size_t i = 0; i < status_.size(); ++i) {
+            if (status_[i]) {
+                from_.push_back(prevPoints_[i]);
+                to_.push_back(currPoints_[i]);
+            }
+        }
+    }
+    if (static_cast<int>(from_.size()) >= MIN_MOTION_POINTS) {
+        const cv::Mat fit = cv::estimateAffinePartial2D(from_, to_, inliers_, cv::RANSAC,
+                                                        RANSAC_THRESHOLD);
+        if (!fit.empty()) {
+            const cv::Matx23d a(fit);
+            const double cx = curr_.cols * 0.5, cy = curr_.rows * 0.5;
+            motion[0] = a(0, 0) * cx + a(0, 1) * cy + a(0, 2) - cx;
+            motion[1] = a(1, 0) * cx + a(1, 1) * cy + a(1, 2) - cy;
+            motion[2] = std::atan2(a(1, 0), a(0, 0));
+            motion[3] = std::log(std::hypot(a(0, 0), a(1, 0)));
+            tracked = true;
+
+            // Outliers (moving objects) are not worth tracking further
+            size_t kept = 0;
+            for (size_t i = 0; i < to_.size(); ++i) {
+                if (inliers_[i]) {
+                    to_[kept++] = to_[i];
+                }
+            }
+            to_.resize(kept);
+        }
+    }
+    if (!tracked) {
+        to_.clear();
+    }
+    trackedPoints_ = static_cast<int>(to_.size());
+
+    // Causal smoothing of the camera path
+    const double k = params_.smoothing;
+    path_ += motion;
+    smooth_ = smooth_ * k + path_ * (1.0 - k);
+
+    // Clamp the correction to what the crop hides
+    const double margin = (1.0 - params_.cropRatio) * 0.5;
+    cv::Vec4d c = smooth_ - path_;
+    c[0] = std::min(std::max(c[0], -margin * curr_.cols), margin * curr_.cols);
+    c[1] = std::min(std::max(c[1], -margin * curr_.rows), margin * curr_.rows);
+    c[2] = std::min(std::max(c[2], -static_cast<double>(params_.maxAngle)),
+                    static_cast<double>(params_.maxAngle));
+    c[3] = std::min(std::max(c[3], -MAX_LOG_SCALE), MAX_LOG_SCALE);
+    smooth_ = path_ + c;
+    correction_ = c;
+
+    // Screen = Z * W * frame; sample with (Z * W)^-1 in normalized coordinates
+    const double cx = curr_.cols * 0.5, cy = curr_.rows * 0.5;
+    const double s = std::exp(c[3]), cosA = s * std::cos(c[2]), sinA = s * std::sin(c[2]);
+    const cv::Matx33d w(cosA, -sinA, cx + c[0] - cosA * cx + sinA * cy,
+                        sinA, cosA, cy + c[1] - sinA * cx - cosA * cy,
+                        0, 0, 1);
+    const double z = 1.0 / params_.cropRatio;
+    const cv::Matx33d zoom(z, 0, cx - z * cx,
+                           0, z, cy - z * cy,
+                           0, 0, 1);
+    const cv::Matx33d toPixels(curr_.cols, 0, 0, 0, curr_.rows, 0, 0, 0, 1);
+    const cv::Matx33d toNormalized(1.0 / curr_.cols, 0, 0, 0, 1.0 / curr_.rows, 0, 0, 0, 1);
+    textureTransform_ = cv::Matx33f(toNormalized * (zoom * w).inv() * toPixels);
+
+    // Surviving points carry over; top up with fresh corners when too few
+    if (static_cast<int>(to_.size()) >= params_.minCorners) {
+        std::swap(prevPoints_, to_);
+    } else {
+        cv::goodFeaturesToTrack(curr_, prevPoints_, params_.maxCorners, 0.01, 8);
+    }
+    std::swap(prev_, curr_);
+    return tracked;
+}
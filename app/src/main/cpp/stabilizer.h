@@ -0,0 +1,94 @@
+#ifndef STABILIZER_H
+#define STABILIZER_H
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * Real-time video stabilization for the display path.
+ * Implementation is in stabilizer.cpp.
+ *
+ * Sparse corners are tracked on a downscaled luma between consecutive
+ * frames (pyramidal Lucas-Kanade), and the frame-to-frame motion is fitted
+ * as a similarity with estimateAffinePartial2D. The accumulated camera path
+ * is smoothed with a causal exponential filter, so no frames are held
+ * back. The difference between the smoothed and the raw path is the
+ * correction.
+ *
+ * The correction is not applied to pixels. textureTransform() returns it,
+ * together with a fixed zoom that hides the borders, as a 3x3 transform of
+ * normalized texture coordinates. The renderer applies it in the vertex
+ * shader, so stabilization needs no warp pass over the image.
+ */
+struct StabilizeParams {
+    int analysisWidth = 320;        // Luma width used for tracking
+    int maxCorners = 200;           // Corners tracked between frames
+    int minCorners = 80;            // Re-detect when fewer survive tracking
+    float smoothing = 0.9f;         // EMA keep factor of the camera path (0..0.99)
+    float cropRatio = 0.9f;         // Visible fraction of the frame (sets the zoom)
+    float maxAngle = 0.05f;         // Largest rotation correction, radians
+
+    bool operator==(const StabilizeParams& o) const {
+        return analysisWidth == o.analysisWidth && maxCorners == o.maxCorners &&
+               minCorners == o.minCorners && smoothing == o.smoothing &&
+               cropRatio == o.cropRatio && maxAngle == o.maxAngle;
+    }
+};
+
+class Stabilizer {
+public:
+    /** A change of parameters restarts the path. */
+    void set(const StabilizeParams& params);
+    const StabilizeParams& params() const { return params_; }
+
+    /** Forget the path (e.g. after the camera was switched). */
+    void reset();
+
+    /**
+     * Track a CV_8UC1 luma image (any size; the NV21 Y plane works as is)
+     * against the previous one and update the correction. Returns false
+     * when the motion could not be estimated; the correction then decays
+     * as if the camera had held still.
+     */
+    bool update(const cv::Mat& luma);
+
+    /**
+     * Display -> texture mapping of normalized coordinates (u, v in 0..1,
+     * v down) for the latest frame, row-major. Identity before the first
+     * update.
+     */
+    const cv::Matx33f& textureTransform() const { return textureTransform_; }
+
+    /** Correction of the latest frame in analysis pixels: dx, dy, angle, log scale. */
+    const cv::Vec4d& correction() const { return correction_; }
+
+    /** Average lag of the smoothed path behind the raw one, in frames. */
+    double pathLagFrames() const { return params_.smoothing / (1.0 - params_.smoothing); }
+
+    /** Corners that agreed with the latest motion estimate. */
+    int trackedPoints() const { return trackedPoints_; }
+    cv::Size analysisSize() const { return prev_.size(); }
+
+private:
+    StabilizeParams params_;
+    bool configured_ = false;
+
+    cv::Mat prev_;
+    cv::Mat curr_;
+    std::vector<cv::Point2f> prevPoints_;
+    std::vector<cv::Point2f> currPoints_;
+    std::vector<uint8_t> status_;
+    std::vector<float> error_;
+    std::vector<cv::Point2f> from_;
+    std::vector<cv::Point2f> to_;
+    std::vector<uint8_t> inliers_;
+
+    int trackedPoints_ = 0;
+    cv::Vec4d path_;                // Accumulated dx, dy, angle, log scale
+    cv::Vec4d smooth_;
+    cv::Vec4d correction_;
+    cv::Matx33f textureTransform_ = cv::Matx33f::eye();
+};
+
+#endif // STABILIZER_H
@@ -0,0 +1,275 @@
+#include "stats.h"
+#include <android/log.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+#define LOG_TAG "Stats"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+/**
+ * stats.cpp - Per-stage timing accumulation.
+ *
+ * Values are stored as microseconds in atomics so the processing and GL
+ * threads can record without locking. The EMA (alpha = 1/16) smooths
+ * frame-to-frame jitter while still reacting within a second at 30 FPS.
+ */
+
+struct StageSlot {
+    std::atomic<int64_t> emaUs{-1};
+    std::atomic<int64_t> lastUs{0};
+    std::atomic<int64_t> jitterUs{0};
+
+    // Recent samples for sparklines (ring, writeCount % size is next slot)
+    std::atomic<int32_t> historyUs[STATS_HISTORY_SIZE] = {};
+    std::atomic<uint32_t> writeCount{0};
+    std::atomic<uint64_t> lastFrame{0};     // frameCount at the latest sample
+};
+
+struct PoolSlot {
+    std::atomic<int> inUse{0};
+    std::atomic<int> peakInUse{0};
+    std::atomic<int> capacity{0};
+    std::atomic<uint64_t> exhausted{0};
+};
+
+struct CacheSlot {
+    // Since the last summary
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<int64_t> savedUs{0};
+
+    std::atomic<int64_t> computeEmaUs{-1};
+};
+
+static StageSlot stageSlots[STAT_COUNT];
+static PoolSlot poolSlots[POOL_COUNT];
+static CacheSlot cacheSlots[CACHE_COUNT];
+static std::atomic<uint64_t> uploadBytes{0};
+static std::atomic<uint64_t> frameCount{0};
+static std::atomic<uint64_t> droppedFrames{0};
+
+static const char* const stageNames[STAT_COUNT] = {
+        "process",
+        "upload",
+        "draw-interval",
+        "hud",
+        "gpu-upload",
+        "gpu-draw",
+        "gpu-hud",
+        "enhance",
+        "denoise",
+        "grade",
+        "posterize",
+        "recluster",
+        "recognize",
+        "pano-register",
+        "pano-warp",
+        "stabilize",
+        "calib-check",
+        "undistort",
+        "template",
+        "people",
+        "contours",
+        "contour-upload",
+        "gpu-lines",
+        "hough",
+};
+
+static const char* const poolNames[POOL_COUNT] = {
+        "camera",
+        "output",
+        "derived",
+        "derived-wide",
+};
+
+static const char* const cacheNames[CACHE_COUNT] = {
+        "gray",
+        "gray-half",
+        "pyramid",
+        "integral",
+};
+
+void statsRecord(StatStage stage, double ms) {
+    StageSlot& slot = stageSlots[stage];
+    const int64_t us = static_cast<int64_t>(ms * 1000.0);
+    slot.lastUs.store(us, std::memory_order_relaxed);
+
+    const uint32_t index = slot.writeCount.load(std::memory_order_relaxed);
+    slot.historyUs[index % STATS_HISTORY_SIZE].store(static_cast<int32_t>(us),
+                                                     std::memory_order_relaxed);
+    slot.writeCount.store(index + 1, std::memory_order_release);
+    slot.lastFrame.store(frameCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    const int64_t prev = slot.emaUs.load(std::memory_order_relaxed);
+    const int64_t next = prev < 0 ? us : prev + (us - prev) / 16;
+    slot.emaUs.store(next, std::memory_order_relaxed);
+
+    if (prev >= 0) {
+        const int64_t deviation = us > prev ? us - prev : prev - us;
+        const int64_t jitter = slot.jitterUs.load(std::memory_order_relaxed);
+        slot.jitterUs.store(jitter + (deviation - jitter) / 16, std::memory_order_relaxed);
+    }
+}
+
+double statsAverageMs(StatStage stage) {
+    const int64_t us = stageSlots[stage].emaUs.load(std::memory_order_relaxed);
+    return us < 0 ? 0.0 : us / 1000.0;
+}
+
+double statsLastMs(StatStage stage) {
+    return stageSlots[stage].lastUs.load(std::memory_order_relaxed) / 1000.0;
+}
+
+double statsJitterMs(StatStage stage) {
+    return stageSlots[stage].jitterUs.load(std::memory_order_relaxed) / 1000.0;
+}
+
+int statsHistory(StatStage stage, float* outMs, int maxCount) {
+    const StageSlot& slot = stageSlots[stage];
+    const uint32_t written = slot.writeCount.load(std::memory_order_acquire);
+    const int count = static_cast<int>(std::min<uint32_t>(
+            written, static_cast<uint32_t>(std::min(maxCount, STATS_HISTORY_SIZE))));
+
+    const uint32_t first = written - count;
+    for (int i = 0; i < count; ++i) {
+        outMs[i] = slot.historyUs[(first + i) % STATS_HISTORY_SIZE].load(
+                std::memory_order_relaxed) / 1000.0f;
+    }
+    return count;
+}
+
+bool statsStageActive(StatStage stage, int frames) {
+    const StageSlot& slot = stageSlots[stage];
+    if (slot.writeCount.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    const uint64_t last = slot.lastFrame.load(std::memory_order_relaxed);
+    const uint64_t now = frameCount.load(std::memory_order_relaxed);
+    return last >= now || now - last < static_cast<uint64_t>(std::max(frames, 1));
+}
+
+const char* statsStageName(StatStage stage) {
+    return stageNames[stage];
+}
+
+void statsAddUploadBytes(uint64_t bytes) {
+    uploadBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void statsPoolUpdate(StatPool pool, int inUse, int capacity) {
+    PoolSlot& slot = poolSlots[pool];
+    slot.inUse.store(inUse, std::memory_order_relaxed);
+    slot.capacity.store(capacity, std::memory_order_relaxed);
+
+    int peak = slot.peakInUse.load(std::memory_order_relaxed);
+    while (inUse > peak &&
+           !slot.peakInUse.compare_exchange_weak(peak, inUse, std::memory_order_relaxed)) {
+    }
+}
+
+void statsPoolExhausted(StatPool pool) {
+    poolSlots[pool].exhausted.fetch_add(1, std::memory_order_relaxed);
+}
+
+void statsCacheHit(StatCache cache) {
+    CacheSlot& slot = cacheSlots[cache];
+    slot.hits.fetch_add(1, std::memory_order_relaxed);
+    const int64_t cost = slot.computeEmaUs.load(std::memory_order_relaxed);
+    if (cost > 0) {
+        slot.savedUs.fetch_add(cost, std::memory_order_relaxed);
+    }
+}
+
+void statsCacheMiss(StatCache cache, double computeMs) {
+    CacheSlot& slot = cacheSlots[cache];
+    slot.misses.fetch_add(1, std::memory_order_relaxed);
+
+    const int64_t us = static_cast<int64_t>(computeMs * 1000.0);
+    const int64_t prev = slot.computeEmaUs.load(std::memory_order_relaxed);
+    slot.computeEmaUs.store(prev < 0 ? us : prev + (us - prev) / 16, std::memory_order_relaxed);
+}
+
+void statsAddDroppedFrames(uint64_t count) {
+    droppedFrames.fetch_add(count, std::memory_order_relaxed);
+}
+
+uint64_t statsDroppedFrames() {
+    return droppedFrames.load(std::memory_order_relaxed);
+}
+
+void statsReset() {
+    for (StageSlot& slot : stageSlots) {
+        slot.emaUs.store(-1, std::memory_order_relaxed);
+        slot.lastUs.store(0, std::memory_order_relaxed);
+        slot.jitterUs.store(0, std::memory_order_relaxed);
+        slot.writeCount.store(0, std::memory_order_relaxed);
+        slot.lastFrame.store(0, std::memory_order_relaxed);
+    }
+    for (PoolSlot& slot : poolSlots) {
+        slot.peakInUse.store(slot.inUse.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        slot.exhausted.store(0, std::memory_order_relaxed);
+    }
+    for (CacheSlot& slot : cacheSlots) {
+        slot.hits.store(0, std::memory_order_relaxed);
+        slot.misses.store(0, std::memory_order_relaxed);
+        slot.savedUs.store(0, std::memory_order_relaxed);
+        slot.computeEmaUs.store(-1, std::memory_order_relaxed);
+    }
+    uploadBytes.store(0, std::memory_order_relaxed);
+    frameCount.store(0, std::memory_order_relaxed);
+    droppedFrames.store(0, std::memory_order_relaxed);
+}
+
+void statsFrameDone(int interval) {
+    const uint64_t frames = frameCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (interval <= 0 || frames % interval != 0) {
+        return;
+    }
+
+    char summary[1024];
+    int len = 0;
+    for (int i = 0; i < STAT_COUNT && len < static_cast<int>(sizeof(summary)); ++i) {
+        const StatStage stage = static_cast<StatStage>(i);
+        if (stageSlots[i].emaUs.load(std::memory_order_relaxed) < 0) {
+            continue;
+        }
+        len += std::snprintf(summary + len, sizeof(summary) - len, " %s %.2f+-%.2f ms,",
+                             stageNames[i], statsAverageMs(stage), statsJitterMs(stage));
+    }
+    for (int i = 0; i < POOL_COUNT && len < static_cast<int>(sizeof(summary)); ++i) {
+        const PoolSlot& slot = poolSlots[i];
+        const int capacity = slot.capacity.load(std::memory_order_relaxed);
+        if (capacity == 0) {
+            continue;
+        }
+        len += std::snprintf(summary + len, sizeof(summary) - len,
+                             " pool %s %d/%d (peak %d, exhausted %llu),", poolNames[i],
+                             slot.inUse.load(std::memory_order_relaxed), capacity,
+                             slot.peakInUse.load(std::memory_order_relaxed),
+                             static_cast<unsigned long long>(
+                                     slot.exhausted.load(std::memory_order_relaxed)));
+    }
+    for (int i = 0; i < CACHE_COUNT && len < static_cast<int>(sizeof(summary)); ++i) {
+        CacheSlot& slot = cacheSlots[i];
+        const uint64_t hits = slot.hits.exchange(0, std::memory_order_relaxed);
+        const uint64_t misses = slot.misses.exchange(0, std::memory_order_relaxed);
+        const int64_t savedUs = slot.savedUs.exchange(0, std::memory_order_relaxed);
+        if (hits + misses == 0) {
+            continue;
+        }
+        len += std::snprintf(summary + len, sizeof(summary) - len,
+                             " cache %s %.0f%% hit (saved %.2f ms/frame),", cacheNames[i],
+                             100.0 * hits / static_cast<double>(hits + misses),
+                             savedUs / 1000.0 / interval);
+    }
+    if (len == 0) {
+        summary[0] = '\0';
+    }
+
+    const uint64_t bytes = uploadBytes.exchange(0, std::memory_order_relaxed);
+    LOGI("Frame %llu:%s %llu KB/frame uploaded, %llu dropped",
+         static_cast<unsigned long long>(frames), summary,
+         static_cast<unsigned long long>(bytes / interval / 1024),
+         static_cast<unsigned long long>(statsDroppedFrames()));
+}
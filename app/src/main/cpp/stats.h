@@ -0,0 +1,130 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Lightweight per-stage timing statistics.
+ * Implementation is in stats.cpp.
+ *
+ * Stages record wall-clock durations in milliseconds; each stage keeps an
+ * exponential moving average, an EMA of the absolute deviation (jitter)
+ * and the last sample. Recording is lock-free
+ * (relaxed atomics) so it can be called from any thread.
+ */
+enum StatStage {
+    STAT_PROCESS = 0,   // processFrame() total
+    STAT_UPLOAD,        // glTexSubImage2D (CPU side)
+    STAT_DRAW_INTERVAL, // Time between consecutive onDrawFrame() calls
+    STAT_HUD,           // HUD vertex build (CPU side)
+    STAT_GPU_UPLOAD,    // Texture upload as executed on the GPU (timer query)
+    STAT_GPU_DRAW,      // Camera quad draw on the GPU
+    STAT_GPU_HUD,       // HUD draw on the GPU
+    STAT_ENHANCE,       // NV21-domain color adjust / luma enhancement
+    STAT_DENOISE,       // Temporal denoise
+    STAT_GRADE,         // 3D LUT color grade on the CPU
+    STAT_POSTERIZE,     // Posterize palette mapping (every frame)
+    STAT_RECLUSTER,     // Posterize palette re-estimate (every N frames)
+    STAT_RECOGNIZE,     // ORB + LSH query + homography verification
+    STAT_PANO_REGISTER, // Panorama: registration against the previous keyframe
+    STAT_PANO_WARP,     // Panorama: warping a new keyframe's strip into the canvas
+    STAT_STABILIZE,     // Preview stabilization: tracking + path smoothing
+    STAT_CALIB_CHECK,   // Calibration worker: board check + corner refinement
+    STAT_UNDISTORT,     // Undistortion remap
+    STAT_TEMPLATE,      // Pyramid template matching
+    STAT_PEOPLE,        // People detection worker: one pass of HOG scales
+    STAT_CONTOURS,      // Contour vectors: Canny + findContours + approxPolyDP
+    STAT_CONTOUR_UPLOAD, // Contour vertex buffer update (CPU side)
+    STAT_GPU_LINES,     // Contour/Hough line overlays drawn on the GPU
+    STAT_HOUGH,         // Hough lines/circles incl. change gating (every edge frame)
+    STAT_COUNT
+};
+
+void statsRecord(StatStage stage, double ms);
+double statsAverageMs(StatStage stage);
+double statsLastMs(StatStage stage);
+double statsJitterMs(StatStage stage);
+const char* statsStageName(StatStage stage);
+
+/**
+ * True if the stage recorded a sample within the last `frames` frames
+ * (counted by statsFrameDone). Stages of inactive modes keep their old
+ * average, so overlays use this to leave them out.
+ */
+bool statsStageActive(StatStage stage, int frames);
+
+/**
+ * Frame pools reporting occupancy ("pressure") and exhaustion.
+ */
+enum StatPool {
+    POOL_CAMERA = 0,    // NV21 input buffers filled by JNI
+    POOL_OUTPUT,        // Processed RGBA/RGB565 frames
+    POOL_DERIVED,       // Per-frame derived 8-bit images (gray, half, pyramid)
+    POOL_DERIVED_WIDE,  // Per-frame derived 32-bit images (integral)
+    POOL_COUNT
+};
+
+void statsPoolUpdate(StatPool pool, int inUse, int capacity);
+void statsPoolExhausted(StatPool pool);
+
+/**
+ * Per-frame derived-image cache (FrameContext in processor.cpp). A miss
+ * records what computing the image cost; each hit counts that cost as saved.
+ */
+enum StatCache {
+    CACHE_GRAY = 0,
+    CACHE_GRAY_HALF,
+    CACHE_PYRAMID,
+    CACHE_INTEGRAL,
+    CACHE_COUNT
+};
+
+void statsCacheHit(StatCache cache);
+void statsCacheMiss(StatCache cache, double computeMs);
+
+// Number of recent samples kept per stage for sparklines
+static const int STATS_HISTORY_SIZE = 64;
+
+/**
+ * Copy up to maxCount most recent samples of a stage (oldest first).
+ * Returns the number of samples written.
+ */
+int statsHistory(StatStage stage, float* outMs, int maxCount);
+
+// Bytes uploaded to the GPU, accumulated per frame
+void statsAddUploadBytes(uint64_t bytes);
+
+// Frames processed and uploaded but replaced before they were ever drawn
+void statsAddDroppedFrames(uint64_t count);
+uint64_t statsDroppedFrames();
+
+/**
+ * Clear all stage averages, history and counters (e.g. between benchmark runs).
+ */
+void statsReset();
+
+/**
+ * Count one frame and log a summary of all stages every `interval` frames.
+ */
+void statsFrameDone(int interval = 120);
+
+/**
+ * RAII timer that records its lifetime into a stage.
+ */
+class ScopedStatTimer {
+public:
+    explicit ScopedStatTimer(StatStage stage)
+        : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedStatTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        statsRecord(stage_, std::chrono::duration<double, std::milli>(elapsed).count());
+    }
+
+private:
+    StatStage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#endif // STATS_H
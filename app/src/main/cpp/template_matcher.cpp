@@ -0,0 +1,211 @@
+#include "template_matcher.h"
+#include <opencv2/imgproc.hpp>
+#include <android/log.h>
+#include <algorithm>
+
+#define LOG_TAG "TemplateMatcher"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+/**
+ * template_matcher.cpp - coarse-to-fine TM_CCOEFF_NORMED search.
+ *
+ * Coarse peaks: after each maximum of the response is taken, a
+ * template-sized neighbourhood around it is cleared. The next maximum is
+ * then a different place rather than the same peak one pixel over.
+ *
+ * Refinement: a peak at (x, y) on level L lies near (2x, 2y) on level
+ * L - 1. pyrDown rounds odd sizes up, so the mapping is off by at most a
+ * pixel. The window of refineRadius pixels around it absorbs that and the
+ * coarse level's localization error. Each refinement step is a
+ * matchTemplate over (2r + 1)^2 positions, whatever the frame size.
+ *
+ * Scores are only compared at full resolution. Coarse scores are blurred
+ * by the pyramid and only pick which peaks are worth refining.
+ */
+
+static const int MIN_TEMPLATE_SIDE = 8;         // Full-resolution template
+static const int SMALLEST_LEVEL_SIDE = 4;       // Pyramid stops before this
+static const float MIN_COARSE_SCORE = 0.3f;     // Coarse peaks below this are not refined
+
+static void setError(std::string* error, const std::string& message) {
+    if (error) {
+        *error = message;
+    }
+}
+
+std::shared_ptr<TemplatePyramid> buildTemplatePyramid(const cv::Mat& gray, const std::string& name,
+                                                      std::string* error) {
+    if (gray.empty() || gray.type() != CV_8UC1) {
+        setError(error, "template must be a non-empty 8-bit gray image");
+        return nullptr;
+    }
+    if (std::min(gray.cols, gray.rows) < MIN_TEMPLATE_SIDE) {
+        setError(error, "template is smaller than " + std::to_string(MIN_TEMPLATE_SIDE) + " px");
+        return nullptr;
+    }
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(gray, mean, stddev);
+    if (stddev[0] < 2.0) {
+        // Normalized correlation is undefined for a flat template
+        setError(error, "template has no texture");
+        return nullptr;
+    }
+
+    auto pyramid = std::make_shared<TemplatePyramid>();
+    pyramid->name = name;
+    pyramid->levels.push_back(gray.clone());
+    while (static_cast<int>(pyramid->levels.size()) < TemplatePyramid::MAX_LEVELS) {
+        const cv::Size size((pyramid->levels.back().cols + 1) / 2, (pyramid->levels.back().rows + 1) / 2);
+        if (std::min(size.width, size.height) < SMALLEST_LEVEL_SIDE) {
+            break;
+        }
+        cv::Mat next;
+        cv::pyrDown(pyramid->levels.back(), next, size);
+        pyramid->levels.push_back(next);
+    }
+    return pyramid;
+}
+
+void TemplateMatcher::set(const TemplateParams& params) {
+    TemplateParams clamped = params;
+    clamped.coarseLevel = std::min(std::max(clamped.coarseLevel, 0), TemplatePyramid::MAX_LEVELS - 1);
+    clamped.minTemplateSide = std::max(clamped.minTemplateSide, SMALLEST_LEVEL_SIDE);
+    clamped.candidates = std::max(clamped.candidates, 1);
+    clamped.refineRadius = std::max(clamped.refineRadius, 1);
+    clamped.minScore = std::min(std::max(clamped.minScore, 0.0f), 1.0f);
+    clamped.trackMargin = std::max(clamped.trackMargin, 0.0f);
+    if (clamped == params_) {
+        return;
+    }
+    params_ = clamped;
+    reset();
+    LOGI("Template matching: coarse level %d, %d candidates, refine radius %d, min score %.2f",
+         params_.coarseLevel, params_.candidates, params_.refineRadius, params_.minScore);
+}
+
+void TemplateMatcher::setTemplate(std::shared_ptr<const TemplatePyramid> pyramid) {
+    if (pyramid == template_) {
+        return;
+    }
+    template_ = std::move(pyramid);
+    reset();
+}
+
+int TemplateMatcher::coarseLevel(cv::Size imageSize, int templateShift) const {
+    if (!template_ || templateShift < 0 || templateShift >= static_cast<int>(template_->levels.size())) {
+        return -1;
+    }
+    const cv::Mat& full = template_->levels[templateShift];
+    if (imageSize.width < full.cols || imageSize.height < full.rows) {
+        return -1;
+    }
+
+    // Climb while the template stays distinctive and still fits the image
+    int level = 0;
+    cv::Size size = imageSize;
+    while (level < params_.coarseLevel) {
+        const int next = level + 1 + templateShift;
+        if (next >= static_cast<int>(template_->levels.size())) {
+            break;
+        }
+        const cv::Mat& templ = template_->levels[next];
+        const cv::Size nextSize((size.width + 1) / 2, (size.height + 1) / 2);
+        if (std::min(templ.cols, templ.rows) < params_.minTemplateSide ||
+            nextSize.width < templ.cols || nextSize.height < templ.rows) {
+            break;
+        }
+        size = nextSize;
+        ++level;
+    }
+    return level;
+}
+
+void TemplateMatcher::findPeaks(const cv::Mat& image, const cv::Mat& templ, cv::Point offset, int count) {
+    peaks_.clear();
+    cv::matchTemplate(image, templ, response_, cv::TM_CCOEFF_NORMED);
+    const cv::Rect bounds(0, 0, response_.cols, response_.rows);
+    for (int i = 0; i < count; ++i) {
+        double score;
+        cv::Point location;
+        cv::minMaxLoc(response_, nullptr, &score, nullptr, &location);
+        if (score < MIN_COARSE_SCORE) {
+            break;
+        }
+        peaks_.push_back({location + offset, static_cast<float>(score)});
+
+        const cv::Rect around(location.x - templ.cols / 2, location.y - templ.rows / 2,
+                              templ.cols, templ.rows);
+        response_(around & bounds).setTo(-1.0f);
+    }
+}
+
+TemplateMatcher::Peak TemplateMatcher::refine(const cv::Mat* levels, int templateShift, int coarse,
+                                              Peak peak) {
+    const int r = params_.refineRadius;
+    for (int level = coarse - 1; level >= 0; --level) {
+        const cv::Mat& image = levels[level];
+        const cv::Mat& templ = template_->levels[level + templateShift];
+        const cv::Rect window = cv::Rect(peak.location.x * 2 - r, peak.location.y * 2 - r,
+                                         templ.cols + 2 * r, templ.rows + 2 * r) &
+                                cv::Rect(0, 0, image.cols, image.rows);
+        if (window.width < templ.cols || window.height < templ.rows) {
+            return {peak.location, -1.0f};
+        }
+        cv::matchTemplate(image(window), templ, response_, cv::TM_CCOEFF_NORMED);
+        double score;
+        cv::Point location;
+        cv::minMaxLoc(response_, nullptr, &score, nullptr, &location);
+        peak = {window.tl() + location, static_cast<float>(score)};
+    }
+    return peak;
+}
+
+bool TemplateMatcher::match(const cv::Mat* levels, int levelCount, int templateShift, TemplateMatch& out) {
+    CV_Assert(levelCount > 0 && levels[0].type() == CV_8UC1);
+    const int coarse = std::min(coarseLevel(levels[0].size(), templateShift), levelCount - 1);
+    if (coarse < 0) {
+        tracking_ = false;
+        return false;
+    }
+    const cv::Mat& image = levels[coarse];
+    const cv::Mat& templ = template_->levels[coarse + templateShift];
+
+    Peak best = {cv::Point(), -1.0f};
+    bool tracked = false;
+    if (tracking_) {
+        // Only around the last hit; the target moves a few pixels per frame
+        const int marginX = std::max(cvRound(templ.cols * params_.trackMargin), params_.refineRadius);
+        const int marginY = std::max(cvRound(templ.rows * params_.trackMargin), params_.refineRadius);
+        const cv::Rect window = cv::Rect((last_.x >> coarse) - marginX, (last_.y >> coarse) - marginY,
+                                         templ.cols + 2 * marginX, templ.rows + 2 * marginY) &
+                                cv::Rect(0, 0, image.cols, image.rows);
+        if (window.width >= templ.cols && window.height >= templ.rows) {
+            findPeaks(image(window), templ, window.tl(), 1);
+            if (!peaks_.empty()) {
+                best = refine(levels, templateShift, coarse, peaks_[0]);
+                tracked = best.score >= params_.minScore;
+            }
+        }
+    }
+    if (!tracked) {
+        // Lost (or never found): search the whole coarse level
+        best.score = -1.0f;
+        findPeaks(image, templ, cv::Point(), params_.candidates);
+        for (const Peak& peak : peaks_) {
+            const Peak refined = refine(levels, templateShift, coarse, peak);
+            if (refined.score > best.score) {
+                best = refined;
+            }
+        }
+    }
+
+    tracking_ = best.score >= params_.minScore;
+    if (!tracking_) {
+        return false;
+    }
+    last_ = cv::Rect(best.location, template_->levels[templateShift].size());
+    out.box = last_;
+    out.score = best.score;
+    out.tracked = tracked;
+    return true;
+}
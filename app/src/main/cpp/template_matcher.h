@@ -0,0 +1,108 @@
+#ifndef TEMPLATE_MATCHER_H
+#define TEMPLATE_MATCHER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * Locating a known logo or fiducial with coarse-to-fine template matching.
+ * Implementation is in template_matcher.cpp.
+ *
+ * A full-resolution matchTemplate costs O(W*H*w*h). Here the frame's
+ * Gaussian pyramid is searched from the top instead:
+ * - the coarsest level is searched exhaustively, where image and template
+ *   both have 1/4^L of their pixels, so the cost drops by about 16^L
+ * - the best few peaks are followed down one level at a time, each
+ *   matched only in a window a few pixels larger than the template
+ * - while the target is being tracked, even the coarse search runs only
+ *   in a window around the previous hit. A full search runs again when
+ *   the tracked score drops below minScore.
+ * The template's own pyramid is built once, when it is loaded.
+ */
+struct TemplateParams {
+    int coarseLevel = 3;            // Pyramid level searched exhaustively
+    int minTemplateSide = 12;       // Smallest template side allowed at that level, pixels
+    int candidates = 3;             // Coarse peaks followed to full resolution
+    int refineRadius = 3;           // Search radius around a peak at each finer level
+    float minScore = 0.7f;          // TM_CCOEFF_NORMED needed to report a hit
+    float trackMargin = 0.5f;       // Tracking window around the last hit, in template sizes
+
+    bool operator==(const TemplateParams& o) const {
+        return coarseLevel == o.coarseLevel && minTemplateSide == o.minTemplateSide &&
+               candidates == o.candidates && refineRadius == o.refineRadius &&
+               minScore == o.minScore && trackMargin == o.trackMargin;
+    }
+};
+
+/** Immutable template pyramid; shared between processing threads. */
+struct TemplatePyramid {
+    static constexpr int MAX_LEVELS = 8;
+
+    std::string name;
+    std::vector<cv::Mat> levels;    // CV_8UC1; levels[i + 1] = pyrDown(levels[i])
+};
+
+/**
+ * Build the pyramid of a CV_8UC1 template, down to a smallest side of
+ * 4 px. Returns nullptr (and fills *error) for an unusable template.
+ */
+std::shared_ptr<TemplatePyramid> buildTemplatePyramid(const cv::Mat& gray, const std::string& name,
+                                                      std::string* error = nullptr);
+
+struct TemplateMatch {
+    cv::Rect box;                   // In pixels of image pyramid level 0
+    float score = 0.0f;             // TM_CCOEFF_NORMED at full resolution
+    bool tracked = false;           // Found in the window around the previous hit
+};
+
+class TemplateMatcher {
+public:
+    /** A change of parameters drops the tracked position. */
+    void set(const TemplateParams& params);
+    const TemplateParams& params() const { return params_; }
+
+    /** A different template (or nullptr) drops the tracked position. */
+    void setTemplate(std::shared_ptr<const TemplatePyramid> pyramid);
+    bool hasTemplate() const { return template_ != nullptr; }
+
+    /** Forget the tracked position; the next match() searches everywhere. */
+    void reset() { tracking_ = false; }
+
+    /**
+     * Find the template in an image pyramid. levels[0] is the CV_8UC1
+     * image and levels[i + 1] = pyrDown(levels[i]). Levels above the coarse
+     * level are not read.
+     *
+     * templateShift pairs image level i with template level i + templateShift,
+     * for images that are 2^templateShift times smaller than the scale the
+     * template was cut at (e.g. a downscaled processing frame).
+     * Reuses internal buffers, so one thread at a time.
+     */
+    bool match(const cv::Mat* levels, int levelCount, int templateShift, TemplateMatch& out);
+
+    /** Coarse level match() would use for an image of this size. */
+    int coarseLevel(cv::Size imageSize, int templateShift) const;
+
+private:
+    struct Peak {
+        cv::Point location;
+        float score;
+    };
+
+    void findPeaks(const cv::Mat& image, const cv::Mat& templ, cv::Point offset, int count);
+    Peak refine(const cv::Mat* levels, int templateShift, int coarse, Peak peak);
+
+    TemplateParams params_;
+    std::shared_ptr<const TemplatePyramid> template_;
+
+    bool tracking_ = false;
+    cv::Rect last_;                 // Last hit, level 0 pixels
+
+    // Per-match scratch
+    cv::Mat response_;
+    std::vector<Peak> peaks_;
+};
+
+#endif // TEMPLATE_MATCHER_H
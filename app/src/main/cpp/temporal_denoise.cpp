@@ -0,0 +1,131 @@
+#include "temporal_denoise.h"
+#include <opencv2/core.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <android/log.h>
+#include <algorithm>
+#include <cstring>
+
+#define LOG_TAG "TemporalDenoise"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+/**
+ * temporal_denoise.cpp - Recursive filter with motion-adaptive weight.
+ *
+ * Per sample, with acc in 8.8 fixed point:
+ *   avg  = round(acc / 256)
+ *   w    = min(256, minWeight + |x - avg| * slope)      slope reaches 256 at
+ *                                                        the motion threshold
+ *   acc' = (acc * (256 - w) + (x << 8) * w) >> 8
+ *   out  = round(acc' / 256)
+ * The products are widened to 32 bits and narrowed back, so the whole row
+ * runs in OpenCV universal intrinsics with a scalar tail.
+ */
+
+static void filterRow(const uint8_t* src, uint8_t* dst, uint16_t* acc, int n,
+                      int minWeight, int slope) {
+    int i = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_uint8>::vlanes();
+    const cv::v_uint16 vMinWeight = cv::vx_setall_u16(static_cast<uint16_t>(minWeight));
+    const cv::v_uint16 vSlope = cv::vx_setall_u16(static_cast<uint16_t>(slope));
+    const cv::v_uint16 vFull = cv::vx_setall_u16(256);
+    const cv::v_uint32 vHalf = cv::vx_setall_u32(128);
+    for (; i <= n - lanes; i += lanes) {
+        const cv::v_uint8 x = cv::vx_load(src + i);
+        const cv::v_uint16 accLo = cv::vx_load(acc + i);
+        const cv::v_uint16 accHi = cv::vx_load(acc + i + lanes / 2);
+
+        const cv::v_uint8 avg = cv::v_rshr_pack<8>(accLo, accHi);
+        cv::v_uint16 diffLo, diffHi;
+        cv::v_expand(cv::v_absdiff(x, avg), diffLo, diffHi);
+        cv::v_uint16 xLo, xHi;
+        cv::v_expand(x, xLo, xHi);
+
+        cv::v_uint16 accOut[2];
+        const cv::v_uint16 diffs[2] = {diffLo, diffHi};
+        const cv::v_uint16 accs[2] = {accLo, accHi};
+        const cv::v_uint16 xs[2] = {xLo, xHi};
+        for (int h = 0; h < 2; ++h) {
+            // Saturating multiply/add, then clamp to a full weight of 256
+            const cv::v_uint16 w = cv::v_min(cv::v_add(vMinWeight, cv::v_mul(diffs[h], vSlope)), vFull);
+            cv::v_uint32 keep0, keep1, take0, take1;
+            cv::v_mul_expand(accs[h], cv::v_sub(vFull, w), keep0, keep1);
+            cv::v_mul_expand(cv::v_shl<8>(xs[h]), w, take0, take1);
+            accOut[h] = cv::v_pack(cv::v_shr<8>(cv::v_add(cv::v_add(keep0, take0), vHalf)),
+                                   cv::v_shr<8>(cv::v_add(cv::v_add(keep1, take1), vHalf)));
+        }
+        cv::v_store(acc + i, accOut[0]);
+        cv::v_store(acc + i + lanes / 2, accOut[1]);
+        cv::v_store(dst + i, cv::v_rshr_pack<8>(accOut[0], accOut[1]));
+    }
+#endif
+    for (; i < n; ++i) {
+        const int avg = (acc[i] + 128) >> 8;
+        const int diff = std::abs(src[i] - avg);
+        const int w = std::min(256, minWeight + diff * slope);
+        const uint32_t next = (static_cast<uint32_t>(acc[i]) * (256 - w) +
+                               (static_cast<uint32_t>(src[i]) << 8) * w + 128) >> 8;
+        acc[i] = static_cast<uint16_t>(next);
+        dst[i] = static_cast<uint8_t>(std::min<uint32_t>(255, (next + 128) >> 8));
+    }
+}
+
+void TemporalDenoiser::set(const DenoiseParams& params) {
+    if (params == params_) {
+        return;
+    }
+    params_ = params;
+    primed_ = false;
+    LOGI("Temporal denoise %s: min weight %d/256, motion threshold %d, chroma %s",
+         params_.enabled ? "on" : "off", params_.minWeight, params_.motionThreshold,
+         params_.chroma ? "on" : "off");
+}
+
+void TemporalDenoiser::reset() {
+    primed_ = false;
+}
+
+void TemporalDenoiser::apply(const uint8_t* nv21In, uint8_t* nv21Out, int width, int height) {
+    const size_t lumaSize = static_cast<size_t>(width) * height;
+    const size_t frameSize = lumaSize * 3 / 2;
+
+    if (width != width_ || height != height_) {
+        width_ = width;
+        height_ = height;
+        accumulator_.assign(frameSize, 0);
+        accumulator_.shrink_to_fit();
+        primed_ = false;
+        LOGI("Temporal denoise accumulator: %dx%d, %zu KB", width, height,
+             frameSize * sizeof(uint16_t) / 1024);
+    }
+
+    const size_t filtered = params_.chroma ? frameSize : lumaSize;
+    if (!primed_) {
+        for (size_t i = 0; i < frameSize; ++i) {
+            accumulator_[i] = static_cast<uint16_t>(nv21In[i] << 8);
+        }
+        if (nv21In != nv21Out) {
+            std::memcpy(nv21Out, nv21In, frameSize);
+        }
+        primed_ = true;
+        return;
+    }
+
+    const int minWeight = std::min(std::max(params_.minWeight, 1), 256);
+    const int threshold = std::max(params_.motionThreshold, 1);
+    const int slope = (256 - minWeight + threshold - 1) / threshold;
+
+    // Rows are independent; each plane row is `width` bytes (VU rows too)
+    const int rows = static_cast<int>(filtered / width);
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int r = range.start; r < range.end; ++r) {
+            const size_t offset = static_cast<size_t>(r) * width;
+            filterRow(nv21In + offset, nv21Out + offset, accumulator_.data() + offset, width,
+                      minWeight, slope);
+        }
+    });
+
+    if (!params_.chroma && nv21In != nv21Out) {
+        std::memcpy(nv21Out + lumaSize, nv21In + lumaSize, lumaSize / 2);
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef TEMPORAL_DENOISE_H
+#define TEMPORAL_DENOISE_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Motion-adaptive temporal denoiser for NV21.
+ * Implementation is in temporal_denoise.cpp.
+ *
+ * Keeps a 16-bit (8.8 fixed point) running average per sample and blends
+ * each new frame into it. Where the new sample is close to the average the
+ * new frame gets a small weight (strong averaging); as the difference grows
+ * towards the motion threshold the weight rises to 1, so moving edges do not
+ * ghost. One vectorized pass per plane; memory is fixed at 2 bytes per
+ * filtered sample, allocated once per frame size.
+ */
+struct DenoiseParams {
+    bool enabled = false;
+    int minWeight = 48;         // New-frame weight for static areas, /256 (~5 frame average)
+    int motionThreshold = 24;   // |new - average| at which the new frame fully wins
+    bool chroma = false;        // Also filter the VU plane
+
+    bool operator==(const DenoiseParams& o) const {
+        return enabled == o.enabled && minWeight == o.minWeight &&
+               motionThreshold == o.motionThreshold && chroma == o.chroma;
+    }
+};
+
+class TemporalDenoiser {
+public:
+    void set(const DenoiseParams& params);
+    const DenoiseParams& params() const { return params_; }
+    bool enabled() const { return params_.enabled; }
+
+    /**
+     * Blend a frame into the accumulator and write the filtered frame.
+     * nv21In and nv21Out may be the same buffer. The first frame (and the
+     * first after a size or parameter change) passes through unchanged.
+     */
+    void apply(const uint8_t* nv21In, uint8_t* nv21Out, int width, int height);
+
+    /** Forget history, e.g. after a camera switch or scene cut. */
+    void reset();
+
+private:
+    DenoiseParams params_;
+    int width_ = 0;
+    int height_ = 0;
+    bool primed_ = false;
+    std::vector<uint16_t> accumulator_;     // Y then VU, value * 256
+};
+
+#endif // TEMPORAL_DENOISE_H
@@ -0,0 +1,1504 @@
+#include "morphology.h"
+#include "color_mask.h"
+#include "chroma_effects.h"
+#include "luma_enhance.h"
+#include "temporal_denoise.h"
+#include "color_lut.h"
+#include "posterize.h"
+#include "recognizer.h"
+#include "panorama.h"
+#include "stabilizer.h"
+#include "calibration.h"
+#include "template_matcher.h"
+#include "people_detector.h"
+#include "hough_detector.h"
+#include "processor.h"
+#include "stats.h"
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/features2d.hpp>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/objdetect.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+/**
+ * processing_bench - Per-stage micro-benchmarks for Linux hosts.
+ *
+ * Each benchmark runs one of the app's processing stages next to the plain
+ * OpenCV route it replaces, on synthetic inputs at the preview size, and
+ * reports the median time of both plus whether the outputs agree.
+ *
+ * Usage:
+ *   processing_bench [--size WxH] [--iters N] [benchmark ...]
+ *
+ * With no benchmark names, all of them run. Available: morph, colormask, chroma,
+ * enhance and denoise (both always run at 720p and 1080p), lut, posterize,
+ * recognize, panorama, stabilize, calibrate, template, people, hough, context
+ */
+
+struct Options {
+    int width = 1280;
+    int height = 720;
+    int iters = 50;
+    std::vector<std::string> benches;
+};
+
+struct Benchmark {
+    const char* name;
+    void (*run)(const Options& opts);
+};
+
+static bool parseOptions(int argc, char** argv, Options& opts) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--size" && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &opts.width, &opts.height) != 2) return false;
+        } else if (arg == "--iters" && hasValue) {
+            opts.iters = std::atoi(argv[++i]);
+        } else if (!arg.empty() && arg[0] != '-') {
+            opts.benches.push_back(arg);
+        } else {
+            return false;
+        }
+    }
+    return opts.width > 0 && opts.height > 0 && opts.iters > 0 &&
+           opts.width % 2 == 0 && opts.height % 2 == 0;
+}
+
+/**
+ * Median wall time of `iters` calls, in milliseconds, after one warm-up call.
+ */
+static double medianMs(int iters, const std::function<void()>& fn) {
+    fn();
+    std::vector<double> samples(iters);
+    for (int i = 0; i < iters; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        samples[i] = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+    }
+    std::nth_element(samples.begin(), samples.begin() + iters / 2, samples.end());
+    return samples[iters / 2];
+}
+
+static void printRow(const char* label, double referenceMs, double stageMs, const char* note) {
+    std::printf("  %-28s opencv %8.3f ms  stage %8.3f ms  x%5.2f  %s\n", label,
+                referenceMs, stageMs, referenceMs / stageMs, note);
+}
+
+static const char* exactNote(bool exact) {
+    return exact ? "exact" : "MISMATCH";
+}
+
+/**
+ * Synthetic NV21 frame: smooth color gradients plus saturated blobs of
+ * assorted hues, so color stages see both in-range and boundary colors.
+ */
+static std::vector<uint8_t> makeNV21(int width, int height) {
+    cv::Mat rgb(height, width, CV_8UC3);
+    for (int y = 0; y < height; ++y) {
+        cv::Vec3b* row = rgb.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < width; ++x) {
+            row[x] = cv::Vec3b(static_cast<uint8_t>(x * 255 / width),
+                               static_cast<uint8_t>(y * 255 / height),
+                               static_cast<uint8_t>(128 + (x + y) % 64));
+        }
+    }
+    cv::RNG rng(42);
+    for (int i = 0; i < 60; ++i) {
+        cv::Mat hsv(1, 1, CV_8UC3, cv::Scalar(rng.uniform(0, 180), rng.uniform(80, 256), rng.uniform(60, 256)));
+        cv::Mat color;
+        cv::cvtColor(hsv, color, cv::COLOR_HSV2RGB);
+        cv::circle(rgb, cv::Point(rng.uniform(0, width), rng.uniform(0, height)), rng.uniform(10, 80),
+                   cv::Scalar(color.at<cv::Vec3b>(0)), cv::FILLED);
+    }
+
+    // OpenCV writes planar I420; NV21 wants Y then interleaved V, U
+    cv::Mat i420;
+    cv::cvtColor(rgb, i420, cv::COLOR_RGB2YUV_I420);
+    const size_t lumaSize = static_cast<size_t>(width) * height;
+    const size_t chromaSize = lumaSize / 4;
+    std::vector<uint8_t> nv21(lumaSize * 3 / 2);
+    std::memcpy(nv21.data(), i420.data, lumaSize);
+    const uint8_t* u = i420.data + lumaSize;
+    const uint8_t* v = u + chromaSize;
+    for (size_t i = 0; i < chromaSize; ++i) {
+        nv21[lumaSize + 2 * i] = v[i];
+        nv21[lumaSize + 2 * i + 1] = u[i];
+    }
+    return nv21;
+}
+
+static bool sameImage(const cv::Mat& a, const cv::Mat& b) {
+    return a.size() == b.size() && a.type() == b.type() && cv::norm(a, b, cv::NORM_INF) == 0;
+}
+
+// ========== morph: van Herk/Gil-Werman vs cv::dilate/cv::erode ==========
+
+static void benchMorphology(const Options& opts) {
+    // Edge map: Canny of a noisy pattern, as MODE_THICK_EDGES sees it
+    cv::Mat pattern(opts.height, opts.width, CV_8UC1);
+    cv::randu(pattern, 0, 255);
+    cv::GaussianBlur(pattern, pattern, cv::Size(9, 9), 0);
+    cv::Mat edges;
+    cv::Canny(pattern, edges, 20, 40);
+
+    // Motion mask: sparse blobs plus salt noise
+    cv::Mat mask = cv::Mat::zeros(opts.height, opts.width, CV_8UC1);
+    cv::RNG rng(1234);
+    for (int i = 0; i < 40; ++i) {
+        cv::circle(mask, cv::Point(rng.uniform(0, opts.width), rng.uniform(0, opts.height)),
+                   rng.uniform(5, 60), cv::Scalar(255), cv::FILLED);
+    }
+    for (int i = 0; i < opts.width * opts.height / 200; ++i) {
+        mask.at<uint8_t>(rng.uniform(0, opts.height), rng.uniform(0, opts.width)) = 255;
+    }
+
+    struct Input {
+        const char* name;
+        const cv::Mat* image;
+    };
+    const Input inputs[] = {{"edges", &edges}, {"mask", &mask}};
+    const int kernels[] = {3, 7, 15, 21, 31};
+
+    std::printf("morph (%dx%d, rectangular element)\n", opts.width, opts.height);
+    for (const Input& input : inputs) {
+        for (int k : kernels) {
+            const cv::Size size(k, k);
+            const cv::Mat element = cv::getStructuringElement(cv::MORPH_RECT, size);
+            cv::Mat reference;
+            cv::Mat result;
+            char label[64];
+
+            const double dilateRef = medianMs(opts.iters, [&] { cv::dilate(*input.image, reference, element); });
+            const double dilateVhgw = medianMs(opts.iters, [&] { morphRect(*input.image, result, size, MORPH_OP_DILATE); });
+            std::snprintf(label, sizeof(label), "%s dilate %dx%d", input.name, k, k);
+            printRow(label, dilateRef, dilateVhgw, exactNote(sameImage(reference, result)));
+
+            const double erodeRef = medianMs(opts.iters, [&] { cv::erode(*input.image, reference, element); });
+            const double erodeVhgw = medianMs(opts.iters, [&] { morphRect(*input.image, result, size, MORPH_OP_ERODE); });
+            std::snprintf(label, sizeof(label), "%s erode %dx%d", input.name, k, k);
+            printRow(label, erodeRef, erodeVhgw, exactNote(sameImage(reference, result)));
+        }
+    }
+
+    // Motion-mask cleanup as a whole: open removes the salt, close fills holes
+    const cv::Size cleanup(15, 15);
+    const cv::Mat element = cv::getStructuringElement(cv::MORPH_RECT, cleanup);
+    cv::Mat reference;
+    cv::Mat result;
+    const double closeRef = medianMs(opts.iters, [&] {
+        cv::morphologyEx(mask, reference, cv::MORPH_OPEN, element);
+        cv::morphologyEx(reference, reference, cv::MORPH_CLOSE, element);
+    });
+    const double closeVhgw = medianMs(opts.iters, [&] {
+        morphRect(mask, result, cleanup, MORPH_OP_OPEN);
+        morphRect(result, result, cleanup, MORPH_OP_CLOSE);
+    });
+    printRow("mask open+close 15x15", closeRef, closeVhgw, exactNote(sameImage(reference, result)));
+}
+
+// ========== colormask: NV21 lookup table vs NV21->RGB->HSV->inRange ==========
+
+static void benchColorMask(const Options& opts) {
+    const std::vector<uint8_t> nv21 = makeNV21(opts.width, opts.height);
+    const cv::Mat yuv(opts.height * 3 / 2, opts.width, CV_8UC1, const_cast<uint8_t*>(nv21.data()));
+
+    struct Case {
+        const char* name;
+        HsvRange range;
+    };
+    const Case cases[] = {
+            {"blue marker", {100, 130, 120, 255, 60, 255}},
+            {"red (wrapping hue)", {170, 10, 100, 255, 50, 255}},
+            {"skin-ish", {0, 25, 40, 170, 80, 255}},
+    };
+
+    std::printf("colormask (%dx%d NV21)\n", opts.width, opts.height);
+    for (const Case& c : cases) {
+        cv::Mat rgb;
+        cv::Mat hsv;
+        cv::Mat reference;
+        auto inRange = [&](const cv::Mat& src, cv::Mat& dst) {
+            if (c.range.hueMin <= c.range.hueMax) {
+                cv::inRange(src, cv::Scalar(c.range.hueMin, c.range.satMin, c.range.valMin),
+                            cv::Scalar(c.range.hueMax, c.range.satMax, c.range.valMax), dst);
+            } else {
+                cv::Mat low;
+                cv::inRange(src, cv::Scalar(c.range.hueMin, c.range.satMin, c.range.valMin),
+                            cv::Scalar(179, c.range.satMax, c.range.valMax), dst);
+                cv::inRange(src, cv::Scalar(0, c.range.satMin, c.range.valMin),
+                            cv::Scalar(c.range.hueMax, c.range.satMax, c.range.valMax), low);
+                cv::bitwise_or(dst, low, dst);
+            }
+        };
+        const double referenceMs = medianMs(opts.iters, [&] {
+            cv::cvtColor(yuv, rgb, cv::COLOR_YUV2RGB_NV21);
+            cv::cvtColor(rgb, hsv, cv::COLOR_RGB2HSV);
+            inRange(hsv, reference);
+        });
+
+        ColorMask mask;
+        mask.setRange(c.range);
+        cv::Mat chroma;
+        cv::Mat full;
+        const double chromaMs = medianMs(opts.iters, [&] {
+            mask.compute(nv21.data(), opts.width, opts.height, chroma);
+        });
+        const double fullMs = medianMs(opts.iters, [&] {
+            mask.compute(nv21.data(), opts.width, opts.height, cv::Size(opts.width, opts.height), full);
+        });
+
+        // Agreement with the full-resolution reference, overall and on the
+        // selected region (intersection over union)
+        cv::Mat diff;
+        cv::compare(full, reference, diff, cv::CMP_NE);
+        const double agree = 100.0 * (1.0 - cv::countNonZero(diff) / static_cast<double>(diff.total()));
+        cv::Mat both;
+        cv::Mat either;
+        cv::bitwise_and(full, reference, both);
+        cv::bitwise_or(full, reference, either);
+        const int unionCount = cv::countNonZero(either);
+        const double iou = unionCount > 0 ? 100.0 * cv::countNonZero(both) / unionCount : 100.0;
+
+        char note[64];
+        std::snprintf(note, sizeof(note), "agree %.2f%%, IoU %.1f%%", agree, iou);
+        char label[64];
+        std::snprintf(label, sizeof(label), "%s @chroma", c.name);
+        printRow(label, referenceMs, chromaMs, note);
+        std::snprintf(label, sizeof(label), "%s @full", c.name);
+        printRow(label, referenceMs, fullMs, note);
+    }
+}
+
+// ========== chroma: NV21 plane tables vs the same effect on RGBA ==========
+
+static void benchChromaEffects(const Options& opts) {
+    const std::vector<uint8_t> nv21 = makeNV21(opts.width, opts.height);
+    const cv::Mat yuv(opts.height * 3 / 2, opts.width, CV_8UC1, const_cast<uint8_t*>(nv21.data()));
+    cv::Mat rgba;
+    cv::cvtColor(yuv, rgba, cv::COLOR_YUV2RGBA_NV21);
+
+    struct Case {
+        const char* name;
+        ColorAdjust adjust;
+        std::function<void(const cv::Mat&, cv::Mat&)> reference;  // Same effect on RGBA
+    };
+
+    cv::Mat gray;
+    cv::Mat grayRgba;
+    cv::Mat rgb;
+    cv::Mat hsv;
+    auto saturate = [&](float s) {
+        return [&, s](const cv::Mat& src, cv::Mat& dst) {
+            cv::cvtColor(src, gray, cv::COLOR_RGBA2GRAY);
+            cv::cvtColor(gray, grayRgba, cv::COLOR_GRAY2RGBA);
+            cv::addWeighted(src, s, grayRgba, 1.0 - s, 0.0, dst);
+        };
+    };
+    cv::Mat gammaLut(1, 256, CV_8UC1);
+    for (int i = 0; i < 256; ++i) {
+        gammaLut.at<uint8_t>(i) = cv::saturate_cast<uint8_t>(255.0 * std::pow(i / 255.0, 1.6));
+    }
+
+    ColorAdjust vivid;
+    vivid.saturation = 1.5f;
+    ColorAdjust mono;
+    mono.saturation = 0.0f;
+    ColorAdjust hue;
+    hue.hueShiftDeg = 30.0f;
+    ColorAdjust warm;
+    warm.tintU = -12;
+    warm.tintV = 10;
+    ColorAdjust contrast;
+    contrast.contrast = 1.3f;
+    contrast.brightness = 8.0f;
+    ColorAdjust gamma;
+    gamma.gamma = 1.6f;
+
+    const Case cases[] = {
+            {"saturation 1.5", vivid, saturate(1.5f)},
+            {"saturation 0 (gray)", mono, saturate(0.0f)},
+            {"hue +30 deg", hue, [&](const cv::Mat& src, cv::Mat& dst) {
+                cv::cvtColor(src, rgb, cv::COLOR_RGBA2RGB);
+                cv::cvtColor(rgb, hsv, cv::COLOR_RGB2HSV);
+                for (int y = 0; y < hsv.rows; ++y) {
+                    cv::Vec3b* row = hsv.ptr<cv::Vec3b>(y);
+                    for (int x = 0; x < hsv.cols; ++x) {
+                        row[x][0] = static_cast<uint8_t>((row[x][0] + 15) % 180);
+                    }
+                }
+                cv::cvtColor(hsv, rgb, cv::COLOR_HSV2RGB);
+                cv::cvtColor(rgb, dst, cv::COLOR_RGB2RGBA);
+            }},
+            {"warm tint", warm, [&](const cv::Mat& src, cv::Mat& dst) {
+                // The RGB offset that the same U/V shift produces (BT.601)
+                cv::add(src, cv::Scalar(1.596 * 10, -0.813 * 10 + 0.391 * 12, 2.018 * -12, 0), dst);
+            }},
+            {"contrast 1.3 +8", contrast, [&](const cv::Mat& src, cv::Mat& dst) {
+                src.convertTo(dst, -1, 1.3, 128 * (1 - 1.3) + 8 * 1.164);
+            }},
+            {"gamma 1.6", gamma, [&](const cv::Mat& src, cv::Mat& dst) {
+                cv::LUT(src, gammaLut, dst);
+            }},
+    };
+
+    std::printf("chroma (%dx%d NV21; effect cost only, both routes then convert/upload as usual)\n",
+                opts.width, opts.height);
+    std::vector<uint8_t> adjusted(nv21.size());
+    for (const Case& c : cases) {
+        cv::Mat reference;
+        const double referenceMs = medianMs(opts.iters, [&] { c.reference(rgba, reference); });
+
+        ChromaEffects effects;
+        effects.set(c.adjust);
+        const double stageMs = medianMs(opts.iters, [&] {
+            effects.apply(nv21.data(), adjusted.data(), opts.width, opts.height);
+        });
+
+        // How close the two routes end up after conversion (they are not
+        // the same math: YUV vs RGB/HSV)
+        cv::Mat result;
+        cv::cvtColor(cv::Mat(opts.height * 3 / 2, opts.width, CV_8UC1, adjusted.data()), result,
+                     cv::COLOR_YUV2RGBA_NV21);
+        cv::Mat diff;
+        cv::absdiff(result, reference, diff);
+        const cv::Scalar meanDiff = cv::mean(diff);
+        char note[64];
+        std::snprintf(note, sizeof(note), "mean |d| %.1f",
+                      (meanDiff[0] + meanDiff[1] + meanDiff[2]) / 3.0);
+        printRow(c.name, referenceMs, stageMs, note);
+    }
+}
+
+// ========== enhance: Y-plane CLAHE + unsharp vs the Lab route on RGBA ==========
+
+static void benchLumaEnhance(const Options& opts) {
+    const cv::Size sizes[] = {{1280, 720}, {1920, 1080}};
+    const int grids[] = {2, 4, 8, 16};
+
+    std::printf("enhance (CLAHE clip 2.0 + unsharp 0.8/sigma 1.0, low-light input)\n");
+    for (const cv::Size& size : sizes) {
+        std::vector<uint8_t> nv21 = makeNV21(size.width, size.height);
+        for (size_t i = 0; i < static_cast<size_t>(size.area()); ++i) {
+            nv21[i] = static_cast<uint8_t>(16 + (nv21[i] - 16) * 3 / 10);   // Underexpose
+        }
+        const cv::Mat yuv(size.height * 3 / 2, size.width, CV_8UC1, nv21.data());
+        cv::Mat rgba;
+        cv::cvtColor(yuv, rgba, cv::COLOR_YUV2RGBA_NV21);
+
+        for (int grid : grids) {
+            // RGBA route: CLAHE on Lab lightness, back to RGBA, sharpen all channels
+            cv::Ptr<cv::CLAHE> clahe = cv::createCLAHE(2.0, cv::Size(grid, grid));
+            cv::Mat rgb;
+            cv::Mat lab;
+            cv::Mat blurred;
+            cv::Mat reference;
+            std::vector<cv::Mat> channels;
+            const double referenceMs = medianMs(opts.iters, [&] {
+                cv::cvtColor(rgba, rgb, cv::COLOR_RGBA2RGB);
+                cv::cvtColor(rgb, lab, cv::COLOR_RGB2Lab);
+                cv::split(lab, channels);
+                clahe->apply(channels[0], channels[0]);
+                cv::merge(channels, lab);
+                cv::cvtColor(lab, rgb, cv::COLOR_Lab2RGB);
+                cv::GaussianBlur(rgb, blurred, cv::Size(), 1.0);
+                cv::addWeighted(rgb, 1.8, blurred, -0.8, 0.0, rgb);
+                cv::cvtColor(rgb, reference, cv::COLOR_RGB2RGBA);
+            });
+
+            LumaEnhancer enhancer;
+            LumaEnhanceParams params;
+            params.clahe = true;
+            params.clipLimit = 2.0;
+            params.tiles = grid;
+            params.sharpenAmount = 0.8f;
+            params.sharpenSigma = 1.0;
+            enhancer.set(params);
+            std::vector<uint8_t> work(nv21);
+            const double stageMs = medianMs(opts.iters, [&] {
+                enhancer.apply(nv21.data(), work.data(), size.width, size.height);
+            });
+
+            char label[64];
+            std::snprintf(label, sizeof(label), "%dx%d grid %dx%d", size.width, size.height, grid, grid);
+            printRow(label, referenceMs, stageMs, "Y only, VU untouched");
+        }
+    }
+}
+
+// ========== denoise: temporal accumulator vs a spatial Gaussian on Y ==========
+
+static void benchTemporalDenoise(const Options& opts) {
+    const cv::Size sizes[] = {{1280, 720}, {1920, 1080}};
+    const int frames = 16;
+
+    std::printf("denoise (static scene + sigma 8 noise, PSNR vs clean after %d frames)\n", frames);
+    for (const cv::Size& size : sizes) {
+        const std::vector<uint8_t> clean = makeNV21(size.width, size.height);
+        const size_t frameBytes = clean.size();
+        const cv::Mat cleanY(size, CV_8UC1, const_cast<uint8_t*>(clean.data()));
+
+        // Independent noise per frame
+        std::vector<std::vector<uint8_t>> noisy(frames, clean);
+        cv::RNG rng(7);
+        for (std::vector<uint8_t>& frame : noisy) {
+            cv::Mat all(1, static_cast<int>(frameBytes), CV_8UC1, frame.data());
+            cv::Mat noise(all.size(), CV_16SC1);
+            rng.fill(noise, cv::RNG::NORMAL, 0, 8);
+            cv::Mat sum;
+            all.convertTo(sum, CV_16SC1);
+            sum += noise;
+            sum.convertTo(all, CV_8UC1);
+        }
+        const cv::Mat noisyY(size, CV_8UC1, noisy[frames - 1].data());
+
+        cv::Mat blurred;
+        const double gaussMs = medianMs(opts.iters, [&] {
+            cv::GaussianBlur(noisyY, blurred, cv::Size(5, 5), 0);
+        });
+
+        for (bool chroma : {false, true}) {
+            TemporalDenoiser denoiser;
+            DenoiseParams params;
+            params.enabled = true;
+            params.chroma = chroma;
+            denoiser.set(params);
+            std::vector<uint8_t> out(frameBytes);
+            for (int f = 0; f < frames; ++f) {
+                denoiser.apply(noisy[f].data(), out.data(), size.width, size.height);
+            }
+            const cv::Mat outY(size, CV_8UC1, out.data());
+            const double psnrNoisy = cv::PSNR(cleanY, noisyY);
+            const double psnrTemporal = cv::PSNR(cleanY, outY);
+            const double psnrGauss = cv::PSNR(cleanY, blurred);
+
+            int f = 0;
+            const double stageMs = medianMs(opts.iters, [&] {
+                denoiser.apply(noisy[f++ % frames].data(), out.data(), size.width, size.height);
+            });
+
+            char label[64];
+            std::snprintf(label, sizeof(label), "%dx%d %s", size.width, size.height,
+                          chroma ? "Y+VU" : "Y");
+            char note[96];
+            std::snprintf(note, sizeof(note), "PSNR %.1f -> %.1f dB (gauss %.1f)",
+                          psnrNoisy, psnrTemporal, psnrGauss);
+            printRow(label, gaussMs, stageMs, note);
+        }
+    }
+}
+
+// ========== lut: tetrahedral 3D LUT vs a plain float trilinear lookup ==========
+
+/**
+ * Synthetic film-style grade: an S-curve on each channel plus a split tone
+ * (cool shadows, warm highlights).
+ */
+static std::vector<float> makeGradeCube(int size) {
+    std::vector<float> rgb;
+    rgb.reserve(static_cast<size_t>(size) * size * size * 3);
+    for (int b = 0; b < size; ++b) {
+        for (int g = 0; g < size; ++g) {
+            for (int r = 0; r < size; ++r) {
+                const float in[3] = {r / (size - 1.0f), g / (size - 1.0f), b / (size - 1.0f)};
+                const float luma = 0.299f * in[0] + 0.587f * in[1] + 0.114f * in[2];
+                const float tone[3] = {0.06f * (luma - 0.5f), 0.0f, -0.06f * (luma - 0.5f)};
+                for (int c = 0; c < 3; ++c) {
+                    const float s = in[c] * in[c] * (3.0f - 2.0f * in[c]);
+                    rgb.push_back(0.7f * s + 0.3f * in[c] + tone[c]);
+                }
+            }
+        }
+    }
+    return rgb;
+}
+
+static void gradeTrilinear(const std::vector<float>& cube, int size, const cv::Mat& src, cv::Mat& dst) {
+    dst.create(src.size(), CV_8UC4);
+    const float scale = (size - 1) / 255.0f;
+    auto at = [&](int r, int g, int b) {
+        return &cube[((static_cast<size_t>(b) * size + g) * size + r) * 3];
+    };
+    for (int y = 0; y < src.rows; ++y) {
+        const uint8_t* in = src.ptr<uint8_t>(y);
+        uint8_t* out = dst.ptr<uint8_t>(y);
+        for (int x = 0; x < src.cols; ++x, in += 4, out += 4) {
+            int i0[3];
+            float f[3];
+            for (int c = 0; c < 3; ++c) {
+                const float p = in[c] * scale;
+                i0[c] = std::min(static_cast<int>(p), size - 2);
+                f[c] = p - i0[c];
+            }
+            for (int c = 0; c < 3; ++c) {
+                float v = 0.0f;
+                for (int corner = 0; corner < 8; ++corner) {
+                    const int dr = corner & 1, dg = (corner >> 1) & 1, db = corner >> 2;
+                    const float w = (dr ? f[0] : 1 - f[0]) * (dg ? f[1] : 1 - f[1]) *
+                                    (db ? f[2] : 1 - f[2]);
+                    v += w * at(i0[0] + dr, i0[1] + dg, i0[2] + db)[c];
+                }
+                out[c] = cv::saturate_cast<uint8_t>(v * 255.0f);
+            }
+            out[3] = 255;
+        }
+    }
+}
+
+static void benchColorLut(const Options& opts) {
+    const std::vector<uint8_t> nv21 = makeNV21(opts.width, opts.height);
+    const cv::Mat yuv(opts.height * 3 / 2, opts.width, CV_8UC1, const_cast<uint8_t*>(nv21.data()));
+    cv::Mat rgba;
+    cv::cvtColor(yuv, rgba, cv::COLOR_YUV2RGBA_NV21);
+
+    std::printf("lut (%dx%d RGBA; reference is a scalar float trilinear lookup)\n",
+                opts.width, opts.height);
+    for (int size : {17, 33, 65}) {
+        const std::vector<float> cube = makeGradeCube(size);
+
+        // Round-trip through a .cube file to time the one-off parse
+        const std::string path = "/tmp/processing_bench_" + std::to_string(size) + ".cube";
+        {
+            std::ofstream file(path);
+            file << "TITLE \"bench\"\nLUT_3D_SIZE " << size << "\n";
+            for (size_t i = 0; i < cube.size(); i += 3) {
+                file << cube[i] << ' ' << cube[i + 1] << ' ' << cube[i + 2] << '\n';
+            }
+        }
+        const auto parseStart = std::chrono::steady_clock::now();
+        std::string error;
+        const std::shared_ptr<const ColorLut3D> lut = loadCubeLut(path, &error);
+        const double parseMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - parseStart).count();
+        std::remove(path.c_str());
+        if (!lut) {
+            std::printf("  %d^3: %s\n", size, error.c_str());
+            continue;
+        }
+
+        cv::Mat reference;
+        const double referenceMs = medianMs(opts.iters, [&] {
+            gradeTrilinear(cube, size, rgba, reference);
+        });
+        cv::Mat graded;
+        const double stageMs = medianMs(opts.iters, [&] {
+            rgba.copyTo(graded);
+            applyColorLut(*lut, graded);
+        });
+
+        cv::Mat diff;
+        cv::absdiff(graded, reference, diff);
+        double maxDiff = 0.0;
+        cv::minMaxLoc(diff.reshape(1), nullptr, &maxDiff);
+        char label[64];
+        std::snprintf(label, sizeof(label), "%d^3 tetrahedral", size);
+        char note[96];
+        std::snprintf(note, sizeof(note), "max |d| %.0f, parse %.1f ms, texture %dx%d",
+                      maxDiff, parseMs, lut->textureWidth(), lut->textureHeight());
+        printRow(label, referenceMs, stageMs, note);
+    }
+}
+
+// ========== posterize: amortized palette + lookup vs full-frame k-means ==========
+
+static double rmsError(const cv::Mat& a, const cv::Mat& b) {
+    return cv::norm(a, b, cv::NORM_L2) / std::sqrt(static_cast<double>(a.total()) * 3.0);
+}
+
+static void benchPosterize(const Options& opts) {
+    const std::vector<uint8_t> nv21 = makeNV21(opts.width, opts.height);
+    const cv::Mat yuv(opts.height * 3 / 2, opts.width, CV_8UC1, const_cast<uint8_t*>(nv21.data()));
+    cv::Mat rgba;
+    cv::cvtColor(yuv, rgba, cv::COLOR_YUV2RGBA_NV21);
+    cv::Mat rgb;
+    cv::cvtColor(rgba, rgb, cv::COLOR_RGBA2RGB);
+
+    std::printf("posterize (%dx%d RGBA; reference is cv::kmeans over every pixel, each frame)\n",
+                opts.width, opts.height);
+    for (int colors : {4, 8, 16}) {
+        // Full-frame k-means is slow; a few runs are enough for a median
+        cv::Mat samples;
+        rgb.reshape(1, static_cast<int>(rgb.total())).convertTo(samples, CV_32F);
+        cv::Mat labels;
+        cv::Mat centers;
+        const double referenceMs = medianMs(std::min(opts.iters, 3), [&] {
+            cv::kmeans(samples, colors, labels,
+                       cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 12, 1.0),
+                       1, cv::KMEANS_PP_CENTERS, centers);
+        });
+        cv::Mat reference(rgba.size(), CV_8UC4);
+        for (int i = 0; i < static_cast<int>(reference.total()); ++i) {
+            const float* c = centers.ptr<float>(labels.at<int>(i));
+            reference.at<cv::Vec4b>(i / reference.cols, i % reference.cols) =
+                    cv::Vec4b(cv::saturate_cast<uint8_t>(c[0]), cv::saturate_cast<uint8_t>(c[1]),
+                              cv::saturate_cast<uint8_t>(c[2]), 255);
+        }
+
+        PosterizeParams params;
+        params.colors = colors;
+        Posterizer posterizer;
+        posterizer.set(params);
+        posterizer.refresh(rgba);   // Cold start
+
+        // Warm re-estimate, as in steady state
+        const double refreshMs = medianMs(opts.iters, [&] { posterizer.refresh(rgba); });
+        cv::Mat posterized;
+        const double mapMs = medianMs(opts.iters, [&] {
+            rgba.copyTo(posterized);
+            posterizer.map(posterized);
+        });
+        const double amortizedMs = mapMs + refreshMs / params.refreshInterval;
+
+        char label[64];
+        std::snprintf(label, sizeof(label), "K=%d (refresh every %d)", colors,
+                      params.refreshInterval);
+        char note[128];
+        std::snprintf(note, sizeof(note), "map %.2f + recluster %.2f ms; rms %.1f vs %.1f",
+                      mapMs, refreshMs, rmsError(posterized, rgba), rmsError(reference, rgba));
+        printRow(label, referenceMs, amortizedMs, note);
+    }
+}
+
+// ========== recognize: ORB + LSH index vs brute-force Hamming matching ==========
+
+/** Synthetic poster: random shapes and lines (plenty of corners) plus a label */
+static cv::Mat makePoster(int seed) {
+    cv::RNG rng(static_cast<uint64_t>(seed) * 7919 + 1);
+    cv::Mat poster(240, 320, CV_8UC1, cv::Scalar(rng.uniform(0, 256)));
+    for (int i = 0; i < 40; ++i) {
+        const cv::Point a(rng.uniform(0, poster.cols), rng.uniform(0, poster.rows));
+        const cv::Point b(rng.uniform(0, poster.cols), rng.uniform(0, poster.rows));
+        const cv::Scalar color(rng.uniform(0, 256));
+        switch (rng.uniform(0, 3)) {
+            case 0: cv::rectangle(poster, a, b, color, cv::FILLED); break;
+            case 1: cv::circle(poster, a, rng.uniform(5, 40), color, cv::FILLED); break;
+            default: cv::line(poster, a, b, color, rng.uniform(1, 5)); break;
+        }
+    }
+    cv::putText(poster, std::to_string(seed), cv::Point(20, 200), cv::FONT_HERSHEY_SIMPLEX, 2.0,
+                cv::Scalar(255 - poster.at<uint8_t>(200, 20)), 4);
+    return poster;
+}
+
+/** Resident set size of this process, from /proc/self/statm */
+static long residentKB() {
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static void benchRecognize(const Options& opts) {
+    // Queries run on the pyramid level the app would use (<= 640 wide)
+    cv::Size querySize(opts.width, opts.height);
+    while (querySize.width > 640) {
+        querySize = cv::Size((querySize.width + 1) / 2, (querySize.height + 1) / 2);
+    }
+
+    std::printf("recognize (%dx%d query; reference is brute-force Hamming knnMatch over all features)\n",
+                querySize.width, querySize.height);
+    const std::string dbPath = "/tmp/processing_bench.refdb";
+    for (int count : {50, 200, 800}) {
+        std::vector<ReferenceImage> refs(count);
+        for (int i = 0; i < count; ++i) {
+            refs[i].name = "poster-" + std::to_string(i);
+            refs[i].gray = makePoster(i);
+        }
+
+        const auto buildStart = std::chrono::steady_clock::now();
+        std::string error;
+        if (!Recognizer::build(refs, dbPath, RecognitionParams(), &error)) {
+            std::printf("  build failed: %s\n", error.c_str());
+            return;
+        }
+        const double buildMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - buildStart).count();
+
+        Recognizer recognizer;
+        const auto loadStart = std::chrono::steady_clock::now();
+        if (!recognizer.load(dbPath, RecognitionParams(), &error)) {
+            std::printf("  load failed: %s\n", error.c_str());
+            return;
+        }
+        const double loadMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - loadStart).count();
+
+        // One of the posters, seen at an angle over a noisy background
+        const int target = count / 2;
+        const cv::Mat& poster = refs[target].gray;
+        cv::Mat query(querySize, CV_8UC1);
+        cv::randu(query, 0, 256);
+        cv::GaussianBlur(query, query, cv::Size(9, 9), 0);
+        const float w = static_cast<float>(querySize.width), h = static_cast<float>(querySize.height);
+        const cv::Point2f from[4] = {{0, 0}, {320, 0}, {320, 240}, {0, 240}};
+        const cv::Point2f to[4] = {{w * 0.25f, h * 0.15f}, {w * 0.72f, h * 0.2f},
+                                   {w * 0.7f, h * 0.85f}, {w * 0.2f, h * 0.8f}};
+        cv::warpPerspective(poster, query, cv::getPerspectiveTransform(from, to), querySize,
+                            cv::INTER_LINEAR, cv::BORDER_TRANSPARENT);
+
+        // Brute force over the same descriptors (from a fresh extraction)
+        cv::Ptr<cv::ORB> orb = cv::ORB::create(RecognitionParams().maxFeatures);
+        std::vector<cv::KeyPoint> keypoints;
+        cv::Mat queryDescriptors;
+        orb->detectAndCompute(query, cv::noArray(), keypoints, queryDescriptors);
+        cv::Mat allDescriptors;
+        for (const ReferenceImage& ref : refs) {
+            std::vector<cv::KeyPoint> refKeypoints;
+            cv::Mat refDescriptors;
+            orb->detectAndCompute(ref.gray, cv::noArray(), refKeypoints, refDescriptors);
+            allDescriptors.push_back(refDescriptors);
+        }
+        cv::BFMatcher matcher(cv::NORM_HAMMING);
+        std::vector<std::vector<cv::DMatch>> knn;
+        const double bruteMs = medianMs(std::min(opts.iters, 10), [&] {
+            matcher.knnMatch(queryDescriptors, allDescriptors, knn, 2);
+        });
+
+        Recognition match;
+        bool found = false;
+        const double stageMs = medianMs(opts.iters, [&] { found = recognizer.recognize(query, match); });
+
+        char label[64];
+        std::snprintf(label, sizeof(label), "%d refs / %zu features", count, recognizer.featureCount());
+        char note[160];
+        std::snprintf(note, sizeof(note), "%s (%d inliers), build %.0f ms, load %.1f ms",
+                      found && match.reference == target ? "hit" : "MISS", match.inliers,
+                      buildMs, loadMs);
+        printRow(label, bruteMs, stageMs, note);
+    }
+
+    // Reloading the last set must not leave anything behind. This catches
+    // leaks only; the LSH tables outweigh the descriptors, so it cannot
+    // tell whether a load copied them
+    const int reloads = 20;
+    Recognizer recognizer;
+    std::string error;
+    if (!recognizer.load(dbPath, RecognitionParams(), &error)) {
+        std::printf("  reload failed: %s\n", error.c_str());
+        return;
+    }
+    const size_t descriptorBytes = recognizer.featureCount() * 32;
+    const long before = residentKB();
+    for (int i = 0; i < reloads; ++i) {
+        recognizer.load(dbPath, RecognitionParams(), &error);
+    }
+    const long growthKB = residentKB() - before;
+    std::printf("  %d reloads: resident memory %+ld KB (descriptors %zu KB) -> %s\n", reloads, growthKB,
+                descriptorBytes / 1024, growthKB * 1024 < static_cast<long>(descriptorBytes) ? "OK" : "LEAK");
+    std::remove(dbPath.c_str());
+}
+
+// ========== panorama: low-resolution keyframe registration + strip warps ==========
+
+/** Wide synthetic scene: blurred color noise under random shapes */
+static cv::Mat makeScene(int width, int height) {
+    cv::RNG rng(4242);
+    cv::Mat rgb(height, width, CV_8UC3);
+    rng.fill(rgb, cv::RNG::UNIFORM, 0, 256);
+    cv::GaussianBlur(rgb, rgb, cv::Size(0, 0), 4);
+    for (int i = 0; i < width * height / 3000; ++i) {
+        const cv::Point a(rng.uniform(0, width), rng.uniform(0, height));
+        const cv::Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        if (rng.uniform(0, 2)) {
+            cv::rectangle(rgb, a, a + cv::Point(rng.uniform(8, 80), rng.uniform(8, 80)), color, cv::FILLED);
+        } else {
+            cv::circle(rgb, a, rng.uniform(4, 40), color, cv::FILLED);
+        }
+    }
+    cv::Mat rgba;
+    cv::cvtColor(rgb, rgba, cv::COLOR_RGB2RGBA);
+    return rgba;
+}
+
+static double medianOf(std::vector<double> samples) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+struct SweepResult {
+    std::vector<double> registerMs;
+    std::vector<double> warpMs;
+    int keyframes = 0;
+    int lost = 0;
+    cv::Size covered;
+    size_t canvasBytes = 0;
+};
+
+/** Pan right across the scene one step per frame, with a little vertical shake */
+static SweepResult runSweep(const cv::Mat& scene, const cv::Size& frameSize, int step,
+                            const PanoramaParams& params) {
+    Panorama panorama;
+    panorama.set(params);
+    SweepResult result;
+    cv::Mat gray, luma;
+    for (int i = 0, x = 0; x + frameSize.width <= scene.cols; ++i, x += step) {
+        if (!panorama.registrationDue()) {
+            panorama.skipFrame();
+            continue;
+        }
+        const int y = 4 + static_cast<int>(std::lround(3.0 * std::sin(i * 0.3)));
+        const cv::Mat frame = scene(cv::Rect(cv::Point(x, y), frameSize));
+        cv::cvtColor(frame, gray, cv::COLOR_RGBA2GRAY);
+        luma = gray;
+        while (luma.cols > params.registerWidth) {
+            cv::pyrDown(luma, luma);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        const PanoramaStep outcome = panorama.track(luma);
+        result.registerMs.push_back(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count());
+        if (outcome == PANORAMA_LOST) {
+            ++result.lost;
+        } else if (outcome == PANORAMA_KEYFRAME) {
+            start = std::chrono::steady_clock::now();
+            panorama.stitch(frame);
+            result.warpMs.push_back(std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start).count());
+        }
+    }
+    cv::Mat snapshot;
+    if (panorama.snapshot(snapshot)) {
+        result.covered = snapshot.size();
+    }
+    result.keyframes = panorama.keyframeCount();
+    result.canvasBytes = panorama.canvasBytes();
+    return result;
+}
+
+static void benchPanorama(const Options& opts) {
+    const cv::Size frameSize(opts.width, opts.height);
+    const cv::Mat scene = makeScene(opts.width * 4, opts.height + 8);
+    const int step = std::max(opts.width / 40, 1);
+
+    std::printf("panorama (%dx%d frames, %d px per frame over a %d px wide scene)\n",
+                opts.width, opts.height, step, scene.cols);
+
+    const PanoramaParams params;
+    const SweepResult low = runSweep(scene, frameSize, step, params);
+    PanoramaParams fullParams = params;
+    fullParams.registerWidth = opts.width;
+    const SweepResult full = runSweep(scene, frameSize, step, fullParams);
+
+    char note[160];
+    std::snprintf(note, sizeof(note), "%d keyframes, %d lost (full res: %d, %d lost)",
+                  low.keyframes, low.lost, full.keyframes, full.lost);
+    char label[64];
+    std::snprintf(label, sizeof(label), "register %d px vs %d px", params.registerWidth, opts.width);
+    printRow(label, medianOf(full.registerMs), medianOf(low.registerMs), note);
+
+    // Reference: warping every keyframe whole into the canvas
+    const cv::Matx33d toCanvas(params.canvasScale, 0, 0, 0, params.canvasScale, 0, 0, 0, 1);
+    const cv::Size warpedSize(cvCeil(opts.width * params.canvasScale),
+                              cvCeil(opts.height * params.canvasScale));
+    cv::Mat warped;
+    const double wholeMs = medianMs(opts.iters, [&] {
+        cv::warpPerspective(scene(cv::Rect(cv::Point(0, 0), frameSize)), warped, toCanvas, warpedSize);
+    });
+    const int expected = cvRound((scene.cols - opts.width) / step * step * params.canvasScale +
+                                 warpedSize.width);
+    std::snprintf(note, sizeof(note), "canvas %.1f MB, covered %dx%d (expected ~%d wide)",
+                  low.canvasBytes / 1048576.0, low.covered.width, low.covered.height, expected);
+    printRow("warp strip vs whole frame", wholeMs, medianOf(low.warpMs), note);
+}
+
+// ========== stabilize: tracking + path smoothing vs a CPU warp pass ==========
+
+/** Frame-to-frame displacement spread (px rms) of a sequence of positions */
+static double shakeRms(const std::vector<cv::Point2d>& positions) {
+    cv::Point2d mean;
+    for (size_t i = 1; i < positions.size(); ++i) {
+        mean += positions[i] - positions[i - 1];
+    }
+    mean *= 1.0 / (positions.size() - 1);
+    double sum = 0.0;
+    for (size_t i = 1; i < positions.size(); ++i) {
+        const cv::Point2d d = positions[i] - positions[i - 1] - mean;
+        sum += d.dot(d);
+    }
+    return std::sqrt(sum / (positions.size() - 1));
+}
+
+static void benchStabilize(const Options& opts) {
+    // Slow pan to the right with random hand shake of up to +-6 px
+    const int frames = 200;
+    const int shake = 6;
+    const double pan = 2.0;
+    const cv::Mat scene = makeScene(opts.width + cvCeil(pan * frames) + 4 * shake,
+                                    opts.height + 4 * shake);
+    std::printf("stabilize (%dx%d, %d frames, %.0f px/frame pan, +-%d px shake)\n",
+                opts.width, opts.height, frames, pan, shake);
+
+    cv::RNG rng(77);
+    Stabilizer stabilizer;
+    stabilizer.set(StabilizeParams());
+    std::vector<double> updateMs;
+    std::vector<cv::Point2d> raw, stabilized;
+    cv::Mat gray;
+    for (int i = 0; i < frames; ++i) {
+        const cv::Point offset(cvRound(pan * i) + 2 * shake + rng.uniform(-shake, shake + 1),
+                               2 * shake + rng.uniform(-shake, shake + 1));
+        cv::cvtColor(scene(cv::Rect(offset, cv::Size(opts.width, opts.height))), gray,
+                     cv::COLOR_RGBA2GRAY);
+
+        const auto start = std::chrono::steady_clock::now();
+        stabilizer.update(gray);
+        updateMs.push_back(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count());
+
+        // Where a fixed scene point ends up on screen, ignoring the zoom
+        const double toFrame = static_cast<double>(opts.width) / stabilizer.analysisSize().width;
+        const cv::Vec4d& c = stabilizer.correction();
+        raw.emplace_back(-offset.x, -offset.y);
+        stabilized.emplace_back(-offset.x + c[0] * toFrame, -offset.y + c[1] * toFrame);
+    }
+
+    // Reference: the warpAffine pass the texture-coordinate transform replaces
+    cv::Mat rgba, warped;
+    scene(cv::Rect(0, 0, opts.width, opts.height)).copyTo(rgba);
+    const cv::Mat m = cv::getRotationMatrix2D(cv::Point2f(opts.width * 0.5f, opts.height * 0.5f),
+                                              0.5, 1.0 / 0.9);
+    const double warpMs = medianMs(opts.iters, [&] { cv::warpAffine(rgba, warped, m, rgba.size()); });
+
+    char note[128];
+    std::snprintf(note, sizeof(note), "shake %.2f -> %.2f px rms, path lag ~%.0f frames",
+                  shakeRms(raw), shakeRms(stabilized), stabilizer.pathLagFrames());
+    printRow("track vs warpAffine RGBA", warpMs, medianOf(updateMs), note);
+}
+
+// ========== calibrate: fast board check, ROI refinement, solve, undistort ==========
+
+/**
+ * Synthetic chessboard views through a known lens. Views are rendered
+ * undistorted (warpPerspective of a flat board) and then distorted with a
+ * per-pixel map built once from undistortPoints.
+ */
+struct SyntheticLens {
+    cv::Size size;
+    cv::Mat k;
+    cv::Mat dist;
+    cv::Mat mapX;                   // Distorted pixel -> ideal pixel
+    cv::Mat mapY;
+};
+
+static SyntheticLens makeLens(const cv::Size& size) {
+    SyntheticLens lens;
+    lens.size = size;
+    const double f = 0.9 * size.width;
+    lens.k = (cv::Mat_<double>(3, 3) << f, 0, size.width * 0.5, 0, f, size.height * 0.5, 0, 0, 1);
+    lens.dist = (cv::Mat_<double>(1, 5) << -0.25, 0.08, 0, 0, 0);
+
+    std::vector<cv::Point2f> pixels;
+    pixels.reserve(size.area());
+    for (int y = 0; y < size.height; ++y) {
+        for (int x = 0; x < size.width; ++x) {
+            pixels.emplace_back(static_cast<float>(x), static_cast<float>(y));
+        }
+    }
+    std::vector<cv::Point2f> ideal;
+    cv::undistortPoints(pixels, ideal, lens.k, lens.dist, cv::noArray(), lens.k);
+    lens.mapX.create(size, CV_32F);
+    lens.mapY.create(size, CV_32F);
+    for (int i = 0; i < size.area(); ++i) {
+        lens.mapX.at<float>(i / size.width, i % size.width) = ideal[i].x;
+        lens.mapY.at<float>(i / size.width, i % size.width) = ideal[i].y;
+    }
+    return lens;
+}
+
+/** One view of a board (inner corners `board`) at a random pose; fills the true corners. */
+static cv::Mat renderBoardView(const SyntheticLens& lens, const cv::Size& board, cv::RNG& rng,
+                               std::vector<cv::Point2f>& truth) {
+    const int square = 40;          // Board texture pixels per square
+    cv::Mat texture(square * (board.height + 3), square * (board.width + 3), CV_8UC1, cv::Scalar(255));
+    for (int y = 0; y <= board.height; ++y) {
+        for (int x = 0; x <= board.width; ++x) {
+            if ((x + y) % 2 == 0) {
+                cv::rectangle(texture, cv::Rect(square * (x + 1), square * (y + 1), square, square),
+                              cv::Scalar(0), cv::FILLED);
+            }
+        }
+    }
+
+    // Pose: tilted up to ~25 degrees, board center near the optical axis
+    const cv::Vec3d rvec(rng.uniform(-0.45, 0.45), rng.uniform(-0.45, 0.45), rng.uniform(-0.3, 0.3));
+    cv::Matx33d r;
+    cv::Rodrigues(rvec, r);
+    const double depth = lens.k.at<double>(0, 0) * (board.width + 1) / (0.55 * lens.size.width);
+    const cv::Vec3d center((board.width - 1) * 0.5, (board.height - 1) * 0.5, 0.0);
+    const cv::Vec3d tvec = cv::Vec3d(rng.uniform(-1.5, 1.5), rng.uniform(-1.0, 1.0), depth) - r * center;
+
+    // Texture pixel -> board units (inner corner (0,0) at texture (2, 2) squares) -> ideal image
+    const cv::Matx33d toBoard(1.0 / square, 0, -2, 0, 1.0 / square, -2, 0, 0, 1);
+    const cv::Matx33d planeToImage(r(0, 0), r(0, 1), tvec[0],
+                                   r(1, 0), r(1, 1), tvec[1],
+                                   r(2, 0), r(2, 1), tvec[2]);
+    const cv::Matx33d h = cv::Matx33d(lens.k) * planeToImage * toBoard;
+    cv::Mat ideal, view;
+    cv::warpPerspective(texture, ideal, h, lens.size, cv::INTER_LINEAR, cv::BORDER_CONSTANT,
+                        cv::Scalar(160));
+    cv::remap(ideal, view, lens.mapX, lens.mapY, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(160));
+
+    std::vector<cv::Point3f> object;
+    for (int y = 0; y < board.height; ++y) {
+        for (int x = 0; x < board.width; ++x) {
+            object.emplace_back(static_cast<float>(x), static_cast<float>(y), 0.0f);
+        }
+    }
+    cv::projectPoints(object, rvec, tvec, lens.k, lens.dist, truth);
+    return view;
+}
+
+static void benchCalibrate(const Options& opts) {
+    const cv::Size size(opts.width, opts.height);
+    const CalibrationParams params;
+    std::printf("calibrate (%dx%d, %dx%d board; reference is full-resolution findChessboardCorners)\n",
+                opts.width, opts.height, params.boardSize.width, params.boardSize.height);
+
+    const SyntheticLens lens = makeLens(size);
+    cv::RNG rng(2024);
+    std::vector<cv::Mat> views;
+    std::vector<std::vector<cv::Point2f>> truths;
+    for (int i = 0; i < params.viewsNeeded + 5; ++i) {
+        std::vector<cv::Point2f> truth;
+        views.push_back(renderBoardView(lens, params.boardSize, rng, truth));
+        truths.push_back(truth);
+    }
+    const std::vector<uint8_t> nv21 = makeNV21(opts.width, opts.height);
+    const cv::Mat noBoard(opts.height, opts.width, CV_8UC1, const_cast<uint8_t*>(nv21.data()));
+
+    const int iters = std::min(opts.iters, 10);
+    const int flags = cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE;
+    const cv::TermCriteria subpix(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 30, 0.01);
+    std::vector<cv::Point2f> corners;
+
+    // Frames without a board: most frames of a session
+    const double fullEmptyMs = medianMs(iters, [&] {
+        cv::findChessboardCorners(noBoard, params.boardSize, corners, flags);
+    });
+    cv::Mat small;
+    const double scale = std::min(1.0, static_cast<double>(params.detectWidth) / opts.width);
+    const double fastEmptyMs = medianMs(opts.iters, [&] {
+        cv::resize(noBoard, small, cv::Size(), scale, scale, cv::INTER_AREA);
+        cv::findChessboardCorners(small, params.boardSize, corners, flags | cv::CALIB_CB_FAST_CHECK);
+    });
+    printRow("no board", fullEmptyMs, fastEmptyMs, "fast check at detectWidth");
+
+    // Frames with a board, through the real worker one frame at a time
+    const double fullBoardMs = medianMs(iters, [&] {
+        cv::findChessboardCorners(views[0], params.boardSize, corners, flags);
+        cv::cornerSubPix(views[0], corners, cv::Size(5, 5), cv::Size(-1, -1), subpix);
+    });
+    Calibrator calibrator;
+    calibrator.set(params);
+    std::vector<double> checkMs;
+    double errorSum = 0.0;
+    int errorCount = 0;
+    int missed = 0;
+    CalibrationStatus status;
+    for (size_t i = 0; i < views.size() && status.state == CALIBRATION_COLLECTING; ++i) {
+        while (!calibrator.submit(views[i])) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        do {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            status = calibrator.status();
+        } while (status.checkedFrames < i + 1);
+        checkMs.push_back(statsLastMs(STAT_CALIB_CHECK));
+        if (!status.boardFound) {
+            ++missed;
+            continue;
+        }
+        for (size_t c = 0; c < truths[i].size(); ++c) {
+            errorSum += cv::norm(status.corners[c] - truths[i][c]);
+            ++errorCount;
+        }
+    }
+    char note[160];
+    std::snprintf(note, sizeof(note), "corner error %.3f px mean, %d/%zu boards missed",
+                  errorCount ? errorSum / errorCount : 0.0, missed, checkMs.size());
+    printRow("board (check + subpix)", fullBoardMs, medianOf(checkMs), note);
+
+    // Background solve
+    const auto solveStart = std::chrono::steady_clock::now();
+    while (status.state != CALIBRATION_DONE && status.views >= params.viewsNeeded) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        status = calibrator.status();
+    }
+    const double solveMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - solveStart).count();
+    const std::shared_ptr<const CameraCalibration> result = calibrator.result();
+    if (!result) {
+        std::printf("  calibrateCamera: not solved (%d/%d distinct views)\n", status.views,
+                    params.viewsNeeded);
+        return;
+    }
+    std::printf("  calibrateCamera: %d views in ~%.0f ms on the worker, RMS %.3f px, "
+                "fx %.1f (true %.1f), k1 %.3f (true %.3f)\n", result->views, solveMs, result->rms,
+                result->cameraMatrix.at<double>(0, 0), lens.k.at<double>(0, 0),
+                result->distCoeffs.at<double>(0), lens.dist.at<double>(0));
+
+    // Undistortion: cached fixed-point maps vs cv::undistort (maps rebuilt per call)
+    cv::Mat rgba, reference, undistorted;
+    cv::cvtColor(views[0], rgba, cv::COLOR_GRAY2RGBA);
+    const cv::Mat newK = cv::getOptimalNewCameraMatrix(result->cameraMatrix, result->distCoeffs, size, 0.0);
+    const double undistortMs = medianMs(iters, [&] {
+        cv::undistort(rgba, reference, result->cameraMatrix, result->distCoeffs, newK);
+    });
+    Undistorter undistorter;
+    undistorter.set(result);
+    const double stageMs = medianMs(opts.iters, [&] { undistorter.apply(rgba, undistorted); });
+    double maxDiff = 0.0;
+    cv::Mat diff;
+    cv::absdiff(reference, undistorted, diff);
+    cv::minMaxLoc(diff.reshape(1), nullptr, &maxDiff);
+    std::snprintf(note, sizeof(note), "max diff %.0f (fixed-point maps)", maxDiff);
+    printRow("undistort RGBA", undistortMs, stageMs, note);
+}
+
+// ========== template: coarse-to-fine pyramid search vs single-level matchTemplate ==========
+
+static void benchTemplate(const Options& opts) {
+    cv::Mat logo;
+    cv::resize(makePoster(7), logo, cv::Size(opts.width / 8, opts.width * 3 / 32), 0, 0, cv::INTER_AREA);
+    cv::Mat background;
+    cv::cvtColor(makeScene(opts.width, opts.height), background, cv::COLOR_RGBA2GRAY);
+    std::printf("template (%dx%d, %dx%d template; reference is single-level matchTemplate)\n",
+                opts.width, opts.height, logo.cols, logo.rows);
+
+    cv::Mat frame;
+    const auto render = [&](cv::Point at) {
+        background.copyTo(frame);
+        logo.copyTo(frame(cv::Rect(at, logo.size())));
+    };
+
+    TemplateMatcher matcher;
+    matcher.set(TemplateParams());
+    matcher.setTemplate(buildTemplatePyramid(logo, "logo"));
+    const int coarse = matcher.coarseLevel(background.size(), 0);
+    std::vector<cv::Mat> levels;
+    TemplateMatch hit;
+    bool found = false;
+
+    // Single-level reference (FFT correlation inside OpenCV for large templates)
+    const cv::Point truth(opts.width * 5 / 8, opts.height / 3);
+    render(truth);
+    cv::Mat response;
+    double score = 0.0;
+    cv::Point location;
+    const double fullMs = medianMs(std::max(1, std::min(opts.iters, 5)), [&] {
+        cv::matchTemplate(frame, logo, response, cv::TM_CCOEFF_NORMED);
+        cv::minMaxLoc(response, nullptr, &score, nullptr, &location);
+    });
+
+    // Exhaustive coarse search, with and without building the pyramid
+    const double searchMs = medianMs(opts.iters, [&] {
+        cv::buildPyramid(frame, levels, coarse);
+        matcher.reset();
+        found = matcher.match(levels.data(), coarse + 1, 0, hit);
+    });
+    char note[160];
+    std::snprintf(note, sizeof(note), "level %d, error (%+d,%+d) px, score %.2f (reference %s)",
+                  coarse, found ? hit.box.x - truth.x : 0, found ? hit.box.y - truth.y : 0,
+                  found ? hit.score : 0.0f, location == truth ? "exact" : "off");
+    printRow("search (incl. pyramid)", fullMs, searchMs, note);
+    const double sharedMs = medianMs(opts.iters, [&] {
+        matcher.reset();
+        matcher.match(levels.data(), coarse + 1, 0, hit);
+    });
+    printRow("search (pyramid shared)", fullMs, sharedMs, "as in the app: FrameContext pyramid");
+
+    // Tracking a logo that moves 5 px right and 2 px down per frame
+    const int frames = 60;
+    matcher.reset();
+    std::vector<double> trackMs;
+    int tracked = 0, lost = 0, maxError = 0;
+    for (int i = 0; i < frames; ++i) {
+        const cv::Point at(opts.width / 8 + 5 * i, opts.height / 4 + 2 * i);
+        render(at);
+        cv::buildPyramid(frame, levels, coarse);
+        const auto start = std::chrono::steady_clock::now();
+        found = matcher.match(levels.data(), coarse + 1, 0, hit);
+        trackMs.push_back(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count());
+        if (!found) {
+            ++lost;
+            continue;
+        }
+        tracked += hit.tracked ? 1 : 0;
+        maxError = std::max(maxError, std::max(std::abs(hit.box.x - at.x), std::abs(hit.box.y - at.y)));
+    }
+    std::snprintf(note, sizeof(note), "%d/%d frames in the tracking window, %d lost, max error %d px",
+                  tracked, frames, lost, maxError);
+    printRow("tracking (pyramid shared)", fullMs, medianOf(trackMs), note);
+}
+
+// ========== people: pruned, spread HOG scan vs full-resolution detectMultiScale ==========
+
+static void benchPeople(const Options& opts) {
+    // Timing only: the synthetic frame has no people in it
+    cv::Mat gray;
+    cv::cvtColor(makeScene(opts.width, opts.height), gray, cv::COLOR_RGBA2GRAY);
+    const PeopleParams params;
+    std::printf("people (%dx%d, timing only; reference is detectMultiScale at full resolution, step 1.05)\n",
+                opts.width, opts.height);
+
+    cv::HOGDescriptor hog;
+    hog.setSVMDetector(cv::HOGDescriptor::getDefaultPeopleDetector());
+    std::vector<cv::Rect> found;
+    const double fullMs = medianMs(std::max(1, std::min(opts.iters, 3)), [&] {
+        hog.detectMultiScale(gray, found, 0.0, cv::Size(8, 8), cv::Size(0, 0), 1.05, 2.0);
+    });
+    int fullScales = 0;
+    for (double s = 1.0; gray.cols / s >= hog.winSize.width && gray.rows / s >= hog.winSize.height; s *= 1.05) {
+        ++fullScales;
+    }
+
+    // Feed the worker as fast as it takes frames
+    PeopleDetector detector;
+    detector.set(params);
+    const int scans = 10;
+    PeopleStatus status;
+    int passes = 0;
+    const auto start = std::chrono::steady_clock::now();
+    while (status.scans < scans) {
+        if (detector.submit(gray)) {
+            ++passes;
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        status = detector.status();
+    }
+    const double wallMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+    if (status.scales.empty()) {
+        std::printf("  no scale fits %dx%d\n", status.detectSize.width, status.detectSize.height);
+        return;
+    }
+
+    const int passesPerScan = (static_cast<int>(status.scales.size()) + params.levelsPerPass - 1) /
+                              params.levelsPerPass;
+    char note[160];
+    std::snprintf(note, sizeof(note), "%zu scales at %dx%d vs %d, over %d frames",
+                  status.scales.size(), status.detectSize.width, status.detectSize.height,
+                  fullScales, passesPerScan);
+    printRow("one scan", fullMs, status.scanMs, note);
+    for (size_t i = 0; i < status.scales.size(); ++i) {
+        std::printf("    scale %.2f (person %3.0f px): %6.2f ms\n", status.scales[i],
+                    status.scales[i] * hog.winSize.height, status.scaleMs[i]);
+    }
+
+    // One pass per camera frame at most, so the camera rate can be the limit
+    const double passMs = status.scanMs / passesPerScan;
+    std::printf("  detection rate: %.1f scans/s on an unthrottled worker (%d passes), "
+                "%.1f scans/s at 30 fps, full-resolution %.1f/s\n",
+                scans * 1000.0 / wallMs, passes,
+                1000.0 / (passesPerScan * std::max(passMs, 1000.0 / 30.0)), 1000.0 / fullMs);
+}
+
+// ========== hough: ROI + change-gated Hough vs per-frame HoughLinesP/HoughCircles ==========
+
+/** Road-and-dashboard frame: two lane lines and a gauge whose needle is at `angle` */
+static cv::Mat makeGaugeFrame(int width, int height, double angle) {
+    cv::Mat gray(height, width, CV_8UC1);
+    for (int r = 0; r < height; ++r) {
+        gray.row(r).setTo(60 + r * 80 / height);
+    }
+    cv::line(gray, cv::Point(width * 2 / 5, height / 3), cv::Point(width / 10, height - 1), 230, 6);
+    cv::line(gray, cv::Point(width * 3 / 5, height / 3), cv::Point(width * 9 / 10, height - 1), 230, 6);
+    const cv::Point center(width * 3 / 4, height / 4);
+    const int radius = height / 6;
+    cv::circle(gray, center, radius, 20, cv::FILLED);
+    cv::circle(gray, center, radius, 240, 4);
+    cv::line(gray, center, center + cv::Point(cvRound(radius * 0.8 * std::cos(angle)),
+                                              cvRound(radius * 0.8 * std::sin(angle))), 240, 3);
+    return gray;
+}
+
+static void benchHough(const Options& opts) {
+    HoughParams params;
+    params.lines = true;
+    params.circles = true;
+    std::printf("hough (%dx%d, 60 frames, needle moves every 10th; reference runs HoughLinesP "
+                "and HoughCircles on every frame)\n", opts.width, opts.height);
+
+    // Canny as in MODE_CANNY, done up front: both sides consume the same edges
+    const int frames = 60;
+    std::vector<cv::Mat> grays, halves, edges;
+    for (int i = 0; i < frames; ++i) {
+        grays.push_back(makeGaugeFrame(opts.width, opts.height, -2.5 + 0.2 * (i / 10)));
+        cv::Mat half, edge;
+        cv::resize(grays.back(), half, cv::Size(), 0.5, 0.5, cv::INTER_AREA);
+        cv::Canny(grays.back(), edge, 80, 160);
+        halves.push_back(half);
+        edges.push_back(edge);
+    }
+
+    const auto timeSequence = [&](const std::function<void(int)>& fn) {
+        fn(0);
+        std::vector<double> samples;
+        for (int i = 0; i < frames; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            fn(i);
+            samples.push_back(std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start).count());
+        }
+        double total = 0.0;
+        for (double ms : samples) total += ms;
+        return total / frames;
+    };
+
+    std::vector<cv::Vec4i> lines;
+    std::vector<cv::Vec3f> circles;
+    const double fullMs = timeSequence([&](int i) {
+        cv::HoughLinesP(edges[i], lines, params.rho, params.theta, params.lineVotes,
+                        params.minLineLength, params.maxLineGap);
+        cv::HoughCircles(grays[i], circles, cv::HOUGH_GRADIENT, params.circleDp, params.minCircleDistance,
+                         params.cannyHigh, params.circleVotes, params.minRadius,
+                         std::min(opts.width, opts.height) / 2);
+    });
+
+    // Mean rather than median: gated frames are the point
+    const auto runStage = [&](const char* label, const HoughParams& stageParams) {
+        HoughDetector detector;
+        detector.set(stageParams);
+        HoughResult result;
+        const double stageMs = timeSequence([&](int i) {
+            detector.detect(edges[i], stageParams.circlesHalfRes ? halves[i] : grays[i], result);
+        });
+        char note[160];
+        std::snprintf(note, sizeof(note), "ran on %llu/%llu frames, %zu lines, %zu circles (reference %zu, %zu)",
+                      static_cast<unsigned long long>(detector.runs()),
+                      static_cast<unsigned long long>(detector.frames()),
+                      result.lines.size(), result.circles.size(), lines.size(), circles.size());
+        printRow(label, fullMs, stageMs, note);
+    };
+
+    HoughParams ungated = params;
+    ungated.gateChanged = 0.0f;     // Every frame counts as changed
+    ungated.circlesHalfRes = false;
+    runStage("every frame (same work)", ungated);
+    HoughParams halfRes = ungated;
+    halfRes.circlesHalfRes = true;
+    runStage("every frame, half-res circles", halfRes);
+    runStage("gated, half-res circles", params);
+    HoughParams gauge = params;
+    gauge.lines = false;
+    gauge.roi = cv::Rect2f(0.5f, 0.0f, 0.5f, 0.5f);
+    runStage("gated, gauge ROI, circles only", gauge);
+}
+
+// ========== context: gray, pyramid and integral shared through FrameContext ==========
+
+/** Mean luma of each cell of a grid x grid block layout, from an integral image */
+static void blockMeans(const cv::Mat& integral, int grid, std::vector<double>& means) {
+    means.clear();
+    const int rows = integral.rows - 1;
+    const int cols = integral.cols - 1;
+    for (int by = 0; by < grid; ++by) {
+        const int y0 = rows * by / grid;
+        const int y1 = rows * (by + 1) / grid;
+        for (int bx = 0; bx < grid; ++bx) {
+            const int x0 = cols * bx / grid;
+            const int x1 = cols * (bx + 1) / grid;
+            const int sum = integral.at<int>(y1, x1) - integral.at<int>(y0, x1)
+                            - integral.at<int>(y1, x0) + integral.at<int>(y0, x0);
+            means.push_back(static_cast<double>(sum) / ((y1 - y0) * (x1 - x0)));
+        }
+    }
+}
+
+static void benchContext(const Options& opts) {
+    std::printf("context (%dx%d; three analytics consumers per frame: block means from the "
+                "integral image, pyramid level 2, half-scale gray; reference has each convert "
+                "its own gray)\n", opts.width, opts.height);
+    const cv::Mat rgba = makeScene(opts.width, opts.height);
+    const int grid = 8;
+
+    cv::Mat refGray, refIntegral, refLevel1, refLevel2, refHalf;
+    std::vector<double> refMeans;
+    const double referenceMs = medianMs(opts.iters, [&] {
+        cv::cvtColor(rgba, refGray, cv::COLOR_RGBA2GRAY);
+        cv::integral(refGray, refIntegral, CV_32S);
+        blockMeans(refIntegral, grid, refMeans);
+        cv::cvtColor(rgba, refGray, cv::COLOR_RGBA2GRAY);
+        cv::pyrDown(refGray, refLevel1);
+        cv::pyrDown(refLevel1, refLevel2);
+        cv::cvtColor(rgba, refGray, cv::COLOR_RGBA2GRAY);
+        cv::resize(refGray, refHalf, cv::Size(refGray.cols / 2, refGray.rows / 2), 0, 0, cv::INTER_AREA);
+    });
+
+    FrameContext context;
+    std::vector<double> means;
+    const double sharedMs = medianMs(opts.iters, [&] {
+        context.begin(rgba);
+        blockMeans(context.integral(), grid, means);
+        context.pyramid(2);
+        context.grayHalf();
+    });
+
+    const bool exact = means == refMeans && sameImage(context.integral(), refIntegral)
+                       && sameImage(context.pyramid(2), refLevel2) && sameImage(context.grayHalf(), refHalf);
+    printRow("3 consumers, shared context", referenceMs, sharedMs, exactNote(exact));
+}
+
+static const Benchmark BENCHMARKS[] = {
+        {"morph", benchMorphology},
+        {"colormask", benchColorMask},
+        {"chroma", benchChromaEffects},
+        {"enhance", benchLumaEnhance},
+        {"denoise", benchTemporalDenoise},
+        {"lut", benchColorLut},
+        {"posterize", benchPosterize},
+        {"recognize", benchRecognize},
+        {"panorama", benchPanorama},
+        {"stabilize", benchStabilize},
+        {"calibrate", benchCalibrate},
+        {"template", benchTemplate},
+        {"people", benchPeople},
+        {"hough", benchHough},
+        {"context", benchContext},
+};
+
+int main(int argc, char** argv) {
+    Options opts;
+    if (!parseOptions(argc, argv, opts)) {
+        std::fprintf(stderr, "usage: %s [--size WxH] [--iters N] [benchmark ...]\n", argv[0]);
+        return 2;
+    }
+
+    std::printf("OpenCV %s, %d threads\n\n", CV_VERSION, cv::getNumThreads());
+    bool ran = false;
+    for (const Benchmark& bench : BENCHMARKS) {
+        bool selected = opts.benches.empty();
+        for (const std::string& name : opts.benches) {
+            selected |= name == bench.name;
+        }
+        if (selected) {
+            bench.run(opts);
+            std::printf("\n");
+            ran = true;
+        }
+    }
+    if (!ran) {
+        std::fprintf(stderr, "No such benchmark\n");
+        return 2;
+    }
+    return 0;
+}
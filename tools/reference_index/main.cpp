@@ -0,0 +1,64 @@
+/**
+ * reference_index - build the recognizer's reference database
+ *
+ *   reference_index out.refdb image1.jpg [image2.png ...]
+ *
+ * Each image becomes one reference, named after its file name without the
+ * directory and extension (truncated to Recognizer::NAME_BYTES - 1).
+ */
+#include "recognizer.h"
+#include <opencv2/imgcodecs.hpp>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static std::string referenceName(const std::string& path) {
+    const size_t slash = path.find_last_of('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    const size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos && dot > 0) {
+        name.resize(dot);
+    }
+    return name;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s out.refdb image [image ...]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<ReferenceImage> refs;
+    for (int i = 2; i < argc; ++i) {
+        cv::Mat gray = cv::imread(argv[i], cv::IMREAD_GRAYSCALE);
+        if (gray.empty()) {
+            std::fprintf(stderr, "skipping %s: cannot decode\n", argv[i]);
+            continue;
+        }
+        refs.push_back({referenceName(argv[i]), gray});
+    }
+    if (refs.empty()) {
+        std::fprintf(stderr, "no usable images\n");
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::string error;
+    if (!Recognizer::build(refs, argv[1], RecognitionParams(), &error)) {
+        std::fprintf(stderr, "build failed: %s\n", error.c_str());
+        return 1;
+    }
+    const double buildMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+
+    // Round trip, so a broken file is caught here rather than on the device
+    Recognizer check;
+    if (!check.load(argv[1], RecognitionParams(), &error)) {
+        std::fprintf(stderr, "reload failed: %s\n", error.c_str());
+        return 1;
+    }
+    std::printf("%d references, %zu features, built in %.0f ms\n",
+                check.referenceCount(), check.featureCount(), buildMs);
+    return 0;
+}
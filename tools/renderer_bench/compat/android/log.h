@@ -0,0 +1,31 @@
+#ifndef RENDERER_BENCH_ANDROID_LOG_H
+#define RENDERER_BENCH_ANDROID_LOG_H
+
+#include <cstdio>
+
+/**
+ * Host stand-in for <android/log.h> so the app's native sources build
+ * unmodified on Linux. Info logs are suppressed unless
+ * RENDERER_BENCH_VERBOSE is defined; warnings and errors go to stderr.
+ */
+enum {
+    ANDROID_LOG_DEBUG = 3,
+    ANDROID_LOG_INFO = 4,
+    ANDROID_LOG_WARN = 5,
+    ANDROID_LOG_ERROR = 6
+};
+
+#ifdef RENDERER_BENCH_VERBOSE
+#define RENDERER_BENCH_MIN_PRIORITY ANDROID_LOG_DEBUG
+#else
+#define RENDERER_BENCH_MIN_PRIORITY ANDROID_LOG_WARN
+#endif
+
+#define __android_log_print(prio, tag, ...)                      \
+    ((prio) >= RENDERER_BENCH_MIN_PRIORITY                       \
+         ? (std::fprintf(stderr, "[%s] ", tag),                  \
+            std::fprintf(stderr, __VA_ARGS__),                   \
+            std::fputc('\n', stderr))                            \
+         : 0)
+
+#endif // RENDERER_BENCH_ANDROID_LOG_H
@@ -0,0 +1,531 @@
+#include "renderer.h"
+#include "processor.h"
+#include "stats.h"
+#include "gl_util.h"
+#include "contour_vectors.h"
+#include "contour_layer.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef HAVE_GBM
+#include <fcntl.h>
+#include <gbm.h>
+#include <unistd.h>
+#endif
+
+/**
+ * renderer_bench - Headless Renderer benchmark for Linux hosts.
+ *
+ * Creates an EGL pbuffer context on Mesa (surfaceless or GBM platform),
+ * drives Renderer::onSurfaceCreated/onSurfaceChanged/onCameraFrame/onDrawFrame
+ * with replayed NV21 frames, and reports per-configuration timings:
+ * - process/upload: CPU-side stats stages
+ * - gpu-upload/gpu-draw: timer queries, when the context exposes them
+ * - e2e: wall time per frame including glFinish (throughput)
+ *
+ * After each configuration the framebuffer is read back and compared with
+ * processFrame() run on the CPU for the same frame, when the viewport maps
+ * the processed image 1:1.
+ *
+ * A last section compares two ways of showing the same Canny edges: as a
+ * full-frame RGBA texture (pack + upload + quad) and as contour polylines
+ * (vectorize + vertex buffer update + line strips).
+ *
+ * Usage:
+ *   renderer_bench [--size WxH] [--frames N] [--input frames.nv21]
+ *                  [--platform surfaceless|gbm|default] [--gles3] [--slow-sink MS]
+ *
+ * --input is a raw file of concatenated NV21 frames at --size; without it,
+ * synthetic moving test patterns are used. --slow-sink registers a sink that
+ * takes MS per frame, to check that it only drops its own frames and leaves
+ * the display numbers unchanged.
+ */
+
+struct Options {
+    int width = 1280;
+    int height = 720;
+    int frames = 300;
+    std::string input;
+    std::string platform = "surfaceless";
+    bool gles3 = false;
+    int slowSinkMs = 0;
+};
+
+/** Stand-in for a recorder/analytics consumer that cannot keep up */
+class SlowSink : public FrameSink {
+public:
+    explicit SlowSink(int delayMs) : delayMs_(delayMs) {}
+    const char* name() const override { return "slow"; }
+    void consume(const FrameBuffer& frame) override {
+        // Touch the pixels like a real consumer would, then stall
+        volatile uint8_t sink = frame.data[frame.width * frame.height / 2];
+        (void)sink;
+        std::this_thread::sleep_for(std::chrono::milliseconds(delayMs_));
+    }
+
+private:
+    int delayMs_;
+};
+
+struct BenchConfig {
+    const char* name;
+    int viewDivisor;        // Viewport = preview / viewDivisor
+    OutputFormat format;
+    int ringSize;
+};
+
+static const BenchConfig BENCH_CONFIGS[] = {
+        {"full-rgba-ring1",    1, OUTPUT_RGBA8888, 1},
+        {"full-rgba-ring2",    1, OUTPUT_RGBA8888, 2},
+        {"full-rgba-ring3",    1, OUTPUT_RGBA8888, 3},
+        {"full-565-ring3",     1, OUTPUT_RGB565,   3},
+        {"half-rgba-ring3",    2, OUTPUT_RGBA8888, 3},
+        {"quarter-rgba-ring3", 4, OUTPUT_RGBA8888, 3},
+};
+
+struct EglState {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+#ifdef HAVE_GBM
+    int drmFd = -1;
+    gbm_device* gbm = nullptr;
+#endif
+};
+
+static bool parseOptions(int argc, char** argv, Options& opts) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--size" && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &opts.width, &opts.height) != 2) return false;
+        } else if (arg == "--frames" && hasValue) {
+            opts.frames = std::atoi(argv[++i]);
+        } else if (arg == "--input" && hasValue) {
+            opts.input = argv[++i];
+        } else if (arg == "--platform" && hasValue) {
+            opts.platform = argv[++i];
+        } else if (arg == "--gles3") {
+            opts.gles3 = true;
+        } else if (arg == "--slow-sink" && hasValue) {
+            opts.slowSinkMs = std::atoi(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return opts.width > 0 && opts.height > 0 && opts.frames > 0 &&
+           opts.width % 2 == 0 && opts.height % 2 == 0;
+}
+
+static EGLDisplay openDisplay(const Options& opts, EglState& egl) {
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+    if (opts.platform == "surfaceless" && getPlatformDisplay) {
+        return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+
+#ifdef HAVE_GBM
+    if (opts.platform == "gbm" && getPlatformDisplay) {
+        egl.drmFd = open("/dev/dri/renderD128", O_RDWR | O_CLOEXEC);
+        if (egl.drmFd < 0) {
+            std::fprintf(stderr, "Cannot open /dev/dri/renderD128\n");
+            return EGL_NO_DISPLAY;
+        }
+        egl.gbm = gbm_create_device(egl.drmFd);
+        return getPlatformDisplay(EGL_PLATFORM_GBM_KHR, egl.gbm, nullptr);
+    }
+#else
+    (void)egl;
+#endif
+
+    if (opts.platform != "default") {
+        std::fprintf(stderr, "Platform '%s' unavailable, using default display\n",
+                     opts.platform.c_str());
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static bool createContext(const Options& opts, EglState& egl) {
+    egl.display = openDisplay(opts, egl);
+    if (egl.display == EGL_NO_DISPLAY || !eglInitialize(egl.display, nullptr, nullptr)) {
+        std::fprintf(stderr, "eglInitialize failed: 0x%x\n", eglGetError());
+        return false;
+    }
+    eglBindAPI(EGL_OPENGL_ES_API);
+
+    const EGLint configAttribs[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, opts.gles3 ? EGL_OPENGL_ES3_BIT_KHR : EGL_OPENGL_ES2_BIT,
+            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+            EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(egl.display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+        std::fprintf(stderr, "No pbuffer-capable EGL config\n");
+        return false;
+    }
+
+    const EGLint surfaceAttribs[] = {EGL_WIDTH, opts.width, EGL_HEIGHT, opts.height, EGL_NONE};
+    egl.surface = eglCreatePbufferSurface(egl.display, config, surfaceAttribs);
+
+    const EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, opts.gles3 ? 3 : 2, EGL_NONE};
+    egl.context = eglCreateContext(egl.display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (egl.surface == EGL_NO_SURFACE || egl.context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(egl.display, egl.surface, egl.surface, egl.context)) {
+        std::fprintf(stderr, "EGL context creation failed: 0x%x\n", eglGetError());
+        return false;
+    }
+
+    std::printf("GL_RENDERER: %s\nGL_VERSION:  %s\n\n",
+                reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+                reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+    return true;
+}
+
+static void destroyContext(EglState& egl) {
+    if (egl.display != EGL_NO_DISPLAY) {
+        eglMakeCurrent(egl.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (egl.context != EGL_NO_CONTEXT) eglDestroyContext(egl.display, egl.context);
+        if (egl.surface != EGL_NO_SURFACE) eglDestroySurface(egl.display, egl.surface);
+        eglTerminate(egl.display);
+    }
+#ifdef HAVE_GBM
+    if (egl.gbm) gbm_device_destroy(egl.gbm);
+    if (egl.drmFd >= 0) close(egl.drmFd);
+#endif
+}
+
+/**
+ * Load NV21 frames from a raw file, or synthesize moving test patterns.
+ */
+static std::vector<std::vector<uint8_t>> loadFrames(const Options& opts) {
+    const size_t frameSize = static_cast<size_t>(opts.width) * opts.height * 3 / 2;
+    std::vector<std::vector<uint8_t>> frames;
+
+    if (!opts.input.empty()) {
+        std::ifstream file(opts.input, std::ios::binary);
+        std::vector<uint8_t> frame(frameSize);
+        while (file.read(reinterpret_cast<char*>(frame.data()), frameSize)) {
+            frames.push_back(frame);
+        }
+        if (frames.empty()) {
+            std::fprintf(stderr, "No complete %dx%d NV21 frames in %s\n",
+                         opts.width, opts.height, opts.input.c_str());
+        }
+        return frames;
+    }
+
+    // Gradient + moving checkerboard (edges for Canny) + slowly rotating chroma
+    const int synthetic = 16;
+    for (int f = 0; f < synthetic; ++f) {
+        std::vector<uint8_t> frame(frameSize);
+        uint8_t* y = frame.data();
+        for (int r = 0; r < opts.height; ++r) {
+            for (int c = 0; c < opts.width; ++c) {
+                const bool check = (((c + f * 8) / 32) + (r / 32)) % 2 == 0;
+                y[r * opts.width + c] = static_cast<uint8_t>((c * 255 / opts.width) / 2 + (check ? 100 : 0));
+            }
+        }
+        uint8_t* vu = frame.data() + static_cast<size_t>(opts.width) * opts.height;
+        for (int r = 0; r < opts.height / 2; ++r) {
+            for (int c = 0; c < opts.width / 2; ++c) {
+                vu[r * opts.width + 2 * c] = static_cast<uint8_t>(128 + ((r + f * 4) % 64) - 32);
+                vu[r * opts.width + 2 * c + 1] = static_cast<uint8_t>(128 + ((c + f * 4) % 64) - 32);
+            }
+        }
+        frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+/**
+ * Compare the rendered viewport against processFrame() on the CPU.
+ * Prints n/a when the viewport does not map the processed image 1:1.
+ */
+static void verifyReadback(const std::vector<uint8_t>& nv21, int width, int height,
+                           int viewWidth, int viewHeight, OutputFormat format) {
+    // Same downscale the renderer picks for this viewport
+    const int downscale = processorChooseDownscale(width, height, viewWidth, viewHeight);
+    const int outWidth = width / downscale;
+    const int outHeight = height / downscale;
+    if (outWidth != viewWidth || outHeight != viewHeight) {
+        std::printf("    verify: n/a (processed %dx%d is scaled to %dx%d viewport)\n",
+                    outWidth, outHeight, viewWidth, viewHeight);
+        return;
+    }
+
+    std::vector<uint8_t> reference(static_cast<size_t>(outWidth) * outHeight * 4);
+    processFrame(nv21.data(), width, height, reference.data(), downscale, format);
+    cv::Mat expected(outHeight, outWidth, CV_8UC4, reference.data());
+    cv::Mat expanded;
+    if (format == OUTPUT_RGB565) {
+        // Expand like GL does (bit replication), not like cvtColor (zero fill)
+        expanded.create(outHeight, outWidth, CV_8UC4);
+        const uint16_t* packed = reinterpret_cast<const uint16_t*>(reference.data());
+        for (int i = 0; i < outWidth * outHeight; ++i) {
+            const int r = packed[i] >> 11, g = (packed[i] >> 5) & 0x3f, b = packed[i] & 0x1f;
+            uint8_t* dst = expanded.data + i * 4;
+            dst[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+            dst[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+            dst[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+            dst[3] = 255;
+        }
+        expected = expanded;
+    }
+
+    // glReadPixels rows are bottom-up; the quad draws texture row 0 at the top
+    cv::Mat rendered(viewHeight, viewWidth, CV_8UC4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, viewWidth, viewHeight, GL_RGBA, GL_UNSIGNED_BYTE, rendered.data);
+    cv::flip(rendered, rendered, 0);
+
+    cv::Mat diff;
+    cv::absdiff(rendered, expected, diff);
+    double maxDiff = 0.0;
+    cv::minMaxLoc(diff.reshape(1), nullptr, &maxDiff);
+    cv::Mat bad;
+    cv::threshold(diff.reshape(1), bad, 2, 255, cv::THRESH_BINARY);
+    const double badPercent = 100.0 * cv::countNonZero(bad) / static_cast<double>(bad.total());
+
+    std::printf("    verify: max diff %.0f, %.3f%% channels off by > 2 -> %s\n",
+                maxDiff, badPercent, badPercent < 0.1 ? "OK" : "MISMATCH");
+}
+
+static double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void runConfig(const BenchConfig& config, const Options& opts,
+                      const std::vector<std::vector<uint8_t>>& frames) {
+    const int viewWidth = opts.width / config.viewDivisor;
+    const int viewHeight = opts.height / config.viewDivisor;
+
+    Renderer renderer(opts.width, opts.height);
+    renderer.setOutputFormat(config.format);
+    renderer.setTextureRingSize(config.ringSize);
+    renderer.onSurfaceCreated();
+    renderer.onSurfaceChanged(viewWidth, viewHeight);
+    int sinkId = -1;
+    if (opts.slowSinkMs > 0) {
+        sinkId = renderer.addSink(std::make_shared<SlowSink>(opts.slowSinkMs), SINK_DROP_OLDEST, 2);
+    }
+
+    // Warm up (texture allocation, shader compile, first-use driver work)
+    for (int i = 0; i < 10; ++i) {
+        renderer.onCameraFrame(frames[i % frames.size()].data(), opts.width, opts.height);
+        renderer.onDrawFrame();
+    }
+    glFinish();
+    statsReset();
+
+    double cameraMs = 0.0;
+    double drawMs = 0.0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < opts.frames; ++i) {
+        const auto frameStart = std::chrono::steady_clock::now();
+        renderer.onCameraFrame(frames[i % frames.size()].data(), opts.width, opts.height);
+        cameraMs += msSince(frameStart);
+
+        const auto drawStart = std::chrono::steady_clock::now();
+        renderer.onDrawFrame();
+        glFinish();
+        drawMs += msSince(drawStart);
+    }
+    const double totalMs = msSince(start);
+
+    std::printf("%-20s view %4dx%-4d  e2e %7.2f fps (%6.2f ms)  onCameraFrame %6.2f ms  "
+                "onDrawFrame+finish %6.2f ms\n",
+                config.name, viewWidth, viewHeight,
+                1000.0 * opts.frames / totalMs, totalMs / opts.frames,
+                cameraMs / opts.frames, drawMs / opts.frames);
+    std::printf("    process %.2f ms, upload %.2f+-%.2f ms, gpu-upload %.2f ms, gpu-draw %.2f ms, "
+                "draw jitter %.2f ms, dropped %llu\n",
+                statsAverageMs(STAT_PROCESS), statsAverageMs(STAT_UPLOAD),
+                statsJitterMs(STAT_UPLOAD), statsAverageMs(STAT_GPU_UPLOAD),
+                statsAverageMs(STAT_GPU_DRAW), statsJitterMs(STAT_DRAW_INTERVAL),
+                static_cast<unsigned long long>(statsDroppedFrames()));
+    SinkStats sink;
+    if (sinkId >= 0 && renderer.sinkStats(sinkId, sink)) {
+        std::printf("    slow sink: %llu/%llu consumed, %llu dropped, lag %.2f ms (max %.2f)\n",
+                    static_cast<unsigned long long>(sink.consumed),
+                    static_cast<unsigned long long>(sink.received),
+                    static_cast<unsigned long long>(sink.dropped), sink.lagMs, sink.maxLagMs);
+    }
+
+    // The last drawn frame is the last one uploaded (draw follows each upload)
+    verifyReadback(frames[(opts.frames - 1) % frames.size()], opts.width, opts.height,
+                   viewWidth, viewHeight, config.format);
+}
+
+// Minimal textured quad for the edge-texture side of the comparison
+static constexpr const char* edgeVertexShaderSource = R"(
+    attribute vec2 a_position;
+    varying vec2 v_texCoord;
+
+    void main() {
+        gl_Position = vec4(a_position, 0.0, 1.0);
+        v_texCoord = vec2(a_position.x * 0.5 + 0.5, 0.5 - a_position.y * 0.5);
+    }
+)";
+
+static constexpr const char* edgeFragmentShaderSource = R"(
+    precision mediump float;
+    varying vec2 v_texCoord;
+    uniform sampler2D u_texture;
+
+    void main() {
+        gl_FragColor = texture2D(u_texture, v_texCoord);
+    }
+)";
+
+/**
+ * Edge output as pixels vs. as vectors. Both sides start from the same
+ * precomputed Canny images, so only the output path differs. "cpu" is the
+ * time to hand the frame to GL, "+finish" includes the draw and glFinish.
+ */
+static void runEdgeOutputComparison(const Options& opts,
+                                    const std::vector<std::vector<uint8_t>>& frames) {
+    std::vector<cv::Mat> edges;
+    for (const std::vector<uint8_t>& frame : frames) {
+        cv::Mat edge;
+        cv::Canny(cv::Mat(opts.height, opts.width, CV_8UC1, const_cast<uint8_t*>(frame.data())),
+                  edge, 80, 160);
+        edges.push_back(edge);
+    }
+    glViewport(0, 0, opts.width, opts.height);
+
+    // Edges as an RGBA texture
+    const GLuint program = linkProgram(edgeVertexShaderSource, edgeFragmentShaderSource);
+    const GLint positionLoc = glGetAttribLocation(program, "a_position");
+    const GLfloat quad[] = {-1, -1, 1, -1, -1, 1, 1, 1};
+    GLuint vbo = 0;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    allocateOutputTexture(opts.width, opts.height, OUTPUT_RGBA8888);
+    cv::Mat rgba(opts.height, opts.width, CV_8UC4);
+
+    double textureCpuMs = 0.0;
+    double textureTotalMs = 0.0;
+    for (int i = -10; i < opts.frames; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        cv::cvtColor(edges[(i + 10) % edges.size()], rgba, cv::COLOR_GRAY2RGBA);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        uploadOutputTexture(0, 0, opts.width, opts.height, OUTPUT_RGBA8888, rgba.data);
+        const double cpuMs = msSince(start);
+        glUseProgram(program);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glEnableVertexAttribArray(positionLoc);
+        glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glFinish();
+        if (i >= 0) {   // First ten are warm-up
+            textureCpuMs += cpuMs;
+            textureTotalMs += msSince(start);
+        }
+    }
+    glDisableVertexAttribArray(positionLoc);
+    glDeleteTextures(1, &texture);
+    glDeleteBuffers(1, &vbo);
+    glDeleteProgram(program);
+
+    // Edges as polylines
+    ContourVectorizer vectorizer;
+    vectorizer.set(ContourParams());
+    ContourGeometry geometry;
+    ContourLayer layer;
+    layer.onSurfaceCreated(vectorizer.params().maxVertices, 1);
+    const GLfloat identity[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+
+    double extractMs = 0.0;
+    double vectorCpuMs = 0.0;
+    double vectorTotalMs = 0.0;
+    double vertices = 0.0;
+    double bytes = 0.0;
+    int truncated = 0;
+    for (int i = -10; i < opts.frames; ++i) {
+        const auto extractStart = std::chrono::steady_clock::now();
+        vectorizer.extract(edges[(i + 10) % edges.size()], geometry);
+        const double frameExtractMs = msSince(extractStart);
+        const auto start = std::chrono::steady_clock::now();
+        layer.upload(0, geometry);
+        const double cpuMs = msSince(start);
+        layer.draw(0, identity);
+        glFinish();
+        if (i >= 0) {
+            extractMs += frameExtractMs;
+            vectorCpuMs += cpuMs;
+            vectorTotalMs += msSince(start);
+            vertices += geometry.vertices.size();
+            bytes += layer.uploadedBytes();
+            truncated += geometry.truncated ? 1 : 0;
+        }
+    }
+    layer.release(true);
+
+    const double n = opts.frames;
+    std::printf("\nEdge output at %dx%d (same Canny input, %d frames):\n", opts.width, opts.height,
+                opts.frames);
+    std::printf("    texture   cpu %6.2f ms  +finish %6.2f ms  %8.1f KB/frame "
+                "(gray -> RGBA pack + upload + quad)\n",
+                textureCpuMs / n, textureTotalMs / n,
+                static_cast<double>(opts.width) * opts.height * 4 / 1024.0);
+    std::printf("    vectors   cpu %6.2f ms  +finish %6.2f ms  %8.1f KB/frame "
+                "(%.0f vertices, vertex buffer update + line strips)\n",
+                vectorCpuMs / n, vectorTotalMs / n, bytes / n / 1024.0, vertices / n);
+    std::printf("    vectorize %.2f ms per frame on the processing thread, %d frames truncated\n",
+                extractMs / n, truncated);
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    if (!parseOptions(argc, argv, opts)) {
+        std::fprintf(stderr,
+                     "usage: %s [--size WxH] [--frames N] [--input frames.nv21]\n"
+                     "          [--platform surfaceless|gbm|default] [--gles3] [--slow-sink MS]\n", argv[0]);
+        return 2;
+    }
+
+    const std::vector<std::vector<uint8_t>> frames = loadFrames(opts);
+    if (frames.empty()) {
+        return 1;
+    }
+
+    EglState egl;
+    if (!createContext(opts, egl)) {
+        destroyContext(egl);
+        return 1;
+    }
+
+    std::printf("Preview %dx%d, %d frames per configuration, %zu distinct input frames\n\n",
+                opts.width, opts.height, opts.frames, frames.size());
+    for (const BenchConfig& config : BENCH_CONFIGS) {
+        runConfig(config, opts, frames);
+    }
+    runEdgeOutputComparison(opts, frames);
+
+    destroyContext(egl);
+    return 0;
+}